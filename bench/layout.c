@@ -0,0 +1,302 @@
+// Checks src/types.c's layouts against the C compiler's own for the same
+// structs, and that a layout doesn't depend on what was laid out before it.
+// Times laying out 20000 random types from scratch, and again once
+// they're all memoised.
+// Build and run with `./build bench`.
+#include <time.h>
+
+#include "../src/util.c"
+#include "../src/scan.c"
+#include "../src/lexer.c"
+#include "../src/types.c"
+#include "../src/ui.c"
+
+#define TYPE_COUNT 20000
+#define SIZE_MAX_MEMBER 4096 // Keeps random nesting from overflowing
+#define RUNS 5
+
+Counters counters; // Only bumped, so src/stats.c isn't needed
+
+// The C types the Wyrt ones in check_abi are made to match
+typedef struct {
+	uint8_t a;
+	uint64_t b;
+	uint16_t c;
+} AbiA;
+
+typedef struct {
+	uint32_t const *ptr;
+	uint64_t len;
+} AbiSlice;
+
+typedef struct {
+	bool f;
+	AbiSlice s;
+	uint8_t t;
+} AbiB;
+
+typedef struct {
+	uint8_t a;
+	uint16_t arr[3];
+	AbiA *p;
+	AbiB inner;
+	int32_t z;
+} AbiC;
+
+static uint32_t rng = 12345;
+
+static uint32_t rand_next(void)
+{
+	rng = rng * 1103515245u + 12345u;
+	return rng >> 8;
+}
+
+static TypeId make_struct(TypeContext *tc, TypeId const *members, size_t count, Error *err)
+{
+	Id names[UINT8_MAX];
+	for(size_t i = 0; i < count; i++) names[i] = i;
+	return types_register(tc, (Type) {.struct_type = {
+		.type = TYPE_STRUCT,
+		.member_types = (TypeId*) members,
+		.member_name_ids = names,
+		.member_count = count,
+	}}, err);
+}
+
+static TypeId primitive(TypeContext *tc, TypeType type)
+{
+	return types_find(tc, (Type) {.type = type});
+}
+
+static bool expect_layout(
+	TypeContext *tc,
+	char const *name,
+	TypeId id,
+	uint64_t size,
+	uint32_t align,
+	size_t const *offsets,
+	Error *err
+)
+{
+	TypeLayout layout = type_layout(tc, id, err);
+	if(*err) return false;
+
+	bool ok = layout.size == size && layout.align == align;
+	Type t = type_resolve(tc, tc->types[id]);
+	for(size_t i = 0; t.type == TYPE_STRUCT && i < t.struct_type.member_count; i++) {
+		ok = ok && layout.offsets[i] == offsets[i];
+	}
+	if(!ok) {
+		fprintf(
+			stderr, "%s: laid out as size %llu align %u, C has size %llu align %u\n",
+			name, (unsigned long long) layout.size, layout.align, (unsigned long long) size, align
+		);
+	}
+	return ok;
+}
+
+static bool check_abi(Error *err)
+{
+	Arena arena = { 0 };
+	TypeContext tc;
+	bool ok = false;
+	types_init(&tc, &arena, err);
+	if(*err) goto RET;
+
+	TypeId u8 = primitive(&tc, TYPE_PRIMITIVE_U8);
+	TypeId u16 = primitive(&tc, TYPE_PRIMITIVE_U16);
+	TypeId u32 = primitive(&tc, TYPE_PRIMITIVE_U32);
+	TypeId u64 = primitive(&tc, TYPE_PRIMITIVE_U64);
+	TypeId s32 = primitive(&tc, TYPE_PRIMITIVE_S32);
+	TypeId boolean = primitive(&tc, TYPE_PRIMITIVE_BOOL);
+
+	TypeId a = make_struct(&tc, (TypeId[]) {u8, u64, u16}, 3, err);
+	if(*err) goto RET;
+
+	TypeId slice = types_register(&tc, (Type) {.slice = {TYPE_SLICE_CONST, u32}}, err);
+	if(*err) goto RET;
+	TypeId b = make_struct(&tc, (TypeId[]) {boolean, slice, u8}, 3, err);
+	if(*err) goto RET;
+
+	TypeId arr = types_register(&tc, (Type) {.array = {TYPE_ARRAY, u16, 3}}, err);
+	if(*err) goto RET;
+	TypeId ptr = types_register(&tc, (Type) {.pointer = {TYPE_POINTER_VAR, a}}, err);
+	if(*err) goto RET;
+	TypeId c = make_struct(&tc, (TypeId[]) {u8, arr, ptr, b, s32}, 5, err);
+	if(*err) goto RET;
+
+	TypeId c_arr = types_register(&tc, (Type) {.array = {TYPE_ARRAY, c, 5}}, err);
+	if(*err) goto RET;
+	TypeId c_def = types_register(&tc, (Type) {.typdef = {TYPE_TYPEDEF, 1, c}}, err);
+	if(*err) goto RET;
+
+	ok = expect_layout(&tc, "struct {u8, u64, u16}", a, sizeof(AbiA), TYPE_ALIGN(AbiA),
+		(size_t[]) {offsetof(AbiA, a), offsetof(AbiA, b), offsetof(AbiA, c)}, err);
+	if(*err) goto RET;
+	ok &= expect_layout(&tc, "[]const u32", slice, sizeof(AbiSlice), TYPE_ALIGN(AbiSlice), NULL, err);
+	if(*err) goto RET;
+	ok &= expect_layout(&tc, "struct {bool, []const u32, u8}", b, sizeof(AbiB), TYPE_ALIGN(AbiB),
+		(size_t[]) {offsetof(AbiB, f), offsetof(AbiB, s), offsetof(AbiB, t)}, err);
+	if(*err) goto RET;
+	ok &= expect_layout(&tc, "struct {u8, [3]u16, &var A, B, s32}", c, sizeof(AbiC), TYPE_ALIGN(AbiC),
+		(size_t[]) {
+			offsetof(AbiC, a), offsetof(AbiC, arr), offsetof(AbiC, p),
+			offsetof(AbiC, inner), offsetof(AbiC, z)
+		}, err);
+	if(*err) goto RET;
+	ok &= expect_layout(&tc, "[5]C", c_arr, sizeof(AbiC[5]), TYPE_ALIGN(AbiC), NULL, err);
+	if(*err) goto RET;
+	ok &= expect_layout(&tc, "typedef of C", c_def, sizeof(AbiC), TYPE_ALIGN(AbiC),
+		(size_t[]) {
+			offsetof(AbiC, a), offsetof(AbiC, arr), offsetof(AbiC, p),
+			offsetof(AbiC, inner), offsetof(AbiC, z)
+		}, err);
+	if(*err) goto RET;
+
+RET:
+	arena_clean(&arena);
+	return ok;
+}
+
+// Random pointers, arrays, slices, typedefs and structs of what came before
+static void gen_types(TypeContext *tc, Error *err)
+{
+	while(tc->count < TYPE_COUNT) {
+		TypeId members[8];
+		Id names[8];
+		Type t = { 0 };
+
+		TypeId base;
+		do {
+			base = rand_next() % tc->count;
+		} while(
+			tc->types[base].type == TYPE_PRIMITIVE_VOID
+			|| type_layout(tc, base, err).size > SIZE_MAX_MEMBER
+		);
+		if(*err) goto RET;
+
+		switch(rand_next() % 5) {
+		case 0:
+			t.pointer.type = TYPE_POINTER_CONST + rand_next() % 3;
+			t.pointer.base = base;
+			break;
+		case 1:
+			t.array.type = TYPE_ARRAY;
+			t.array.base = base;
+			t.array.len = 1 + rand_next() % 4;
+			break;
+		case 2:
+			t.slice.type = TYPE_SLICE_CONST + rand_next() % 3;
+			t.slice.base = base;
+			break;
+		case 3:
+			t.typdef.type = TYPE_TYPEDEF;
+			t.typdef.id = tc->count;
+			t.typdef.backing = base;
+			break;
+		default: {
+			size_t count = 1 + rand_next() % 8;
+			members[0] = base;
+			names[0] = 0;
+			for(size_t i = 1; i < count; i++) {
+				do {
+					members[i] = rand_next() % tc->count;
+				} while(
+					tc->types[members[i]].type == TYPE_PRIMITIVE_VOID
+					|| type_layout(tc, members[i], err).size > SIZE_MAX_MEMBER
+				);
+				if(*err) goto RET;
+				names[i] = i;
+			}
+			t.struct_type.type = TYPE_STRUCT;
+			t.struct_type.member_types = members;
+			t.struct_type.member_name_ids = names;
+			t.struct_type.member_count = count;
+		} break;
+		}
+
+		types_register(tc, t, err);
+		if(*err) goto RET;
+	}
+
+RET:
+	return;
+}
+
+static bool layouts_equal(TypeContext const *tc, TypeId id, TypeLayout a, TypeLayout b)
+{
+	if(a.size != b.size || a.align != b.align) return false;
+
+	Type t = type_resolve(tc, tc->types[id]);
+	if(t.type != TYPE_STRUCT) return true;
+	return !memcmp(a.offsets, b.offsets, t.struct_type.member_count * sizeof(uint64_t));
+}
+
+static double seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+	Error err = ERROR_OK;
+	int ret = 1;
+	Arena gen_arena = { 0 };
+	Arena arena = { 0 };
+
+	bool abi_ok = check_abi(&err);
+	if(err) goto RET;
+	printf("C ABI      %s\n", abi_ok ? "agrees" : "DISAGREES");
+
+	// Laid out as they're made, bottom up
+	TypeContext gen;
+	types_init(&gen, &gen_arena, &err);
+	if(err) goto RET;
+	gen_types(&gen, &err);
+	if(err) goto RET;
+
+	double fresh = 0, memo = 0;
+	bool same = true;
+	for(int run = 0; run < RUNS; run++) {
+		// The same types, laid out top down, so each one is first reached
+		// from a different type than in gen
+		TypeContext tc;
+		types_init(&tc, &arena, &err);
+		if(err) goto RET;
+		for(TypeId id = tc.count; id < gen.count; id++) {
+			types_register(&tc, gen.types[id], &err);
+			if(err) goto RET;
+		}
+
+		clock_t start = clock();
+		for(TypeId id = tc.count; id--;) {
+			type_layout(&tc, id, &err);
+			if(err) goto RET;
+		}
+		double t = seconds(start);
+		if(!run || t < fresh) fresh = t;
+
+		start = clock();
+		for(TypeId id = tc.count; id--;) {
+			TypeLayout layout = type_layout(&tc, id, &err);
+			if(err) goto RET;
+			same = same && layouts_equal(&tc, id, layout, type_layout(&gen, id, &err));
+			if(err) goto RET;
+		}
+		t = seconds(start);
+		if(!run || t < memo) memo = t;
+
+		arena_reset(&arena, (ArenaMark) { 0 });
+	}
+
+	printf("fresh      %8.3f ms   (%zu types)\n", fresh * 1e3, gen.count);
+	printf("memoised   %8.3f ms   (twice the lookups, and a compare)\n", memo * 1e3);
+	if(!same) fprintf(stderr, "Layouts depend on the order they're asked for!\n");
+	ret = !(abi_ok && same);
+
+RET:
+	if(err) fprintf(stderr, "Failed to lay out types!\n");
+	arena_clean(&gen_arena);
+	arena_clean(&arena);
+	return ret;
+}
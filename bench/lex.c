@@ -0,0 +1,293 @@
+// Benchmark for the lexer: tokens per second on a large synthetic .w corpus.
+// Build and run with `./build bench`.
+#include <time.h>
+
+#include "../src/util.c"
+#include "../src/scan.c"
+#include "../src/lexer.c"
+
+#define SRC_SIZE (32 * 1024 * 1024)
+#define RUNS 5
+
+// The only diagnostic in the lexer that uses it can't fire on the corpus
+void wyrt_diag(FILE *file, char *const *idents, char *const *strings, const TypeContext *tc, const char *fmt, ...)
+{
+	(void) file; (void) idents; (void) strings; (void) tc; (void) fmt;
+}
+
+static uint32_t rng = 12345;
+static uint32_t next_rand(void)
+{
+	rng = rng * 1103515245u + 12345u;
+	return rng >> 8;
+}
+
+static const char *pick(const char *const *list, size_t count)
+{
+	return list[next_rand() % count];
+}
+#define PICK(list) pick(list, (sizeof list) / (sizeof list[0]))
+
+// Operator-heavy function bodies, roughly the shape of generated code
+static char *gen_source(size_t size, size_t *len)
+{
+	char *src = malloc(size + 256);
+	if(!src) return NULL;
+
+	static const char *const names[] = {"a", "b", "count", "ptr", "idx", "value", "len", "x1", "tmp"};
+	static const char *const bin_ops[] = {"+", "-", "*", "/", "==", "!=", ">=", "<=", ">", "<", "&&", "||", "|"};
+	static const char *const assign_ops[] = {"=", "+=", "-=", "*=", "/="};
+	static const char *const types[] = {"u8", "u32", "s64", "*var u8", "[]const u8"};
+
+	size_t i = 0;
+	size_t fn = 0;
+	while(i < size) {
+		i += sprintf(src + i, "fn f%zu(a: u32, b: *var u8) -> u32 {\n", fn++);
+		for(uint32_t stmts = 4 + next_rand() % 8; stmts && i < size; stmts--) {
+			switch(next_rand() % 4) {
+			case 0:
+				i += sprintf(
+					src + i, "\tvar %s: %s = %s %s %u;\n",
+					PICK(names), PICK(types), PICK(names), PICK(bin_ops), next_rand() % 1000
+				);
+				break;
+			case 1:
+				i += sprintf(
+					src + i, "\t%s %s %s[%u] %s !%s;\n",
+					PICK(names), PICK(assign_ops), PICK(names), next_rand() % 64, PICK(bin_ops), PICK(names)
+				);
+				break;
+			case 2:
+				i += sprintf(
+					src + i, "\tif(%s %s %s) { discard f%u(&%s, \"str\"); } else { %s -> %s; }\n",
+					PICK(names), PICK(bin_ops), PICK(names), next_rand() % 100, PICK(names), PICK(names), PICK(names)
+				);
+				break;
+			default:
+				i += sprintf(src + i, "\treturn (%s %s %s) . %s;\n", PICK(names), PICK(bin_ops), PICK(names), PICK(names));
+				break;
+			}
+		}
+		i += sprintf(src + i, "}\n\n");
+	}
+
+	*len = i;
+	return src;
+}
+
+/*
+ * The operator switch src/lexer.c used before the DFA: read a byte, peek the
+ * next one with get_char and back up if it doesn't extend the operator.
+ */
+static TokenType old_operator(Lexer *lex, size_t *pos, char first)
+{
+	int c;
+	switch(first) {
+	case '!':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_COMP_NE;
+		}
+		backup(pos);
+		return TOKEN_LOGIC_NOT;
+	case ':':
+		return TOKEN_COLON;
+	case '(':
+		return TOKEN_LPAREN;
+	case ')':
+		return TOKEN_RPAREN;
+	case '>':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_COMP_GE;
+		}
+		backup(pos);
+		return TOKEN_COMP_GT;
+	case '<':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_COMP_LE;
+		}
+		backup(pos);
+		return TOKEN_COMP_LT;
+	case '=':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_COMP_EQ;
+		}
+		backup(pos);
+		return TOKEN_ASSIGN;
+	case '|':
+		c = get_char(lex, pos);
+		if(c == '|') {
+			return TOKEN_LOGIC_OR;
+		}
+		backup(pos);
+		return TOKEN_BIT_OR;
+	case '{':
+		return TOKEN_LCURLY;
+	case '}':
+		return TOKEN_RCURLY;
+	case ';':
+		return TOKEN_SEMICOLON;
+	case '*':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_MUL_ASSIGN;
+		}
+		backup(pos);
+		return TOKEN_STAR;
+	case '/':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_DIV_ASSIGN;
+		}
+		backup(pos);
+		return TOKEN_FSLASH;
+	case '+':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_ADD_ASSIGN;
+		}
+		backup(pos);
+		return TOKEN_PLUS;
+	case '-':
+		c = get_char(lex, pos);
+		if(c == '=') {
+			return TOKEN_SUB_ASSIGN;
+		} else if(c == '>') {
+			return TOKEN_ARROW;
+		}
+		backup(pos);
+		return TOKEN_MINUS;
+	case ',':
+		return TOKEN_COMMA;
+	case '&':
+		c = get_char(lex, pos);
+		if(c == '&') {
+			return TOKEN_LOGIC_AND;
+		}
+		backup(pos);
+		return TOKEN_AMPERSAND;
+	case '[':
+		return TOKEN_LSQUARE;
+	case ']':
+		return TOKEN_RSQUARE;
+	case '.':
+		return TOKEN_PERIOD;
+	default:
+		return TOKEN_NONE;
+	}
+}
+
+typedef struct {
+	size_t tokens;
+	size_t ops;
+	uint32_t check; // Hash of the operator types, to compare the two
+} Summary;
+
+// Just enough of a lexer to hand every operator to one of the recognisers
+static Summary walk(Lexer *lex, bool dfa)
+{
+	Summary sum = { 0 };
+	size_t pos = 0;
+	while(true) {
+		int c = skip_whitespace(lex, &pos);
+		if(c == EOF) break;
+
+		sum.tokens++;
+		TokenType type = dfa ? lex_operator(lex, &pos, c) : old_operator(lex, &pos, c);
+		if(type != TOKEN_NONE) {
+			sum.ops++;
+			sum.check = sum.check * 31 + type;
+		} else if(c == '"') {
+			while((c = get_char(lex, &pos)) != '"' && c != EOF);
+		} else {
+			pos += lex->scan->ident(lex->file_contents + pos, remaining(lex, pos));
+		}
+	}
+	return sum;
+}
+
+static double seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void report(const char *name, double best, double base, size_t tokens)
+{
+	printf(
+		"%-16s %8.2f ms %8.1f Mtok/s %6.2fx   (%zu tokens)\n",
+		name,
+		best * 1000.0,
+		tokens / best / 1e6,
+		base / best,
+		tokens
+	);
+}
+
+int main(void)
+{
+	size_t len;
+	char *src = gen_source(SRC_SIZE, &len);
+	if(!src) {
+		fprintf(stderr, "Out of Memory!\n");
+		return 1;
+	}
+
+	op_table_init();
+	Lexer lex = {
+		.file_contents = src,
+		.file_length = len,
+		.scan = scan_best(),
+		.jobs = 1,
+	};
+
+	int ret = 0;
+	Summary sums[2];
+	double base = 0;
+	const char *names[2] = {"switch+backup", "dfa"};
+	for(int dfa = 0; dfa < 2; dfa++) {
+		double best = 0;
+		for(int i = 0; i < RUNS; i++) {
+			clock_t start = clock();
+			sums[dfa] = walk(&lex, dfa);
+			double t = seconds(start);
+			if(!i || t < best) best = t;
+		}
+		if(!dfa) base = best;
+		report(names[dfa], best, base, sums[dfa].tokens);
+	}
+	if(sums[0].ops != sums[1].ops || sums[0].check != sums[1].check) {
+		fprintf(stderr, "The DFA disagrees with the old operator switch!\n");
+		ret = 1;
+	}
+
+	Error err = ERROR_OK;
+	double best = 0;
+	size_t tokens = 0;
+	for(int i = 0; i < RUNS && !err; i++) {
+		Tokens toks = { 0 };
+		char **idents = NULL;
+		char **strings = NULL;
+		size_t ident_count, string_count;
+
+		clock_t start = clock();
+		lexer_tokenize(&lex, &toks, &idents, &ident_count, &strings, &string_count, &err);
+		double t = seconds(start);
+		if(!i || t < best) best = t;
+		tokens = toks.count;
+
+		tokens_clean(&toks);
+		lexer_clean_strings(idents);
+		lexer_clean_strings(strings);
+	}
+	if(err) {
+		fprintf(stderr, "lexer_tokenize failed on the corpus!\n");
+		ret = 1;
+	}
+	report("lexer_tokenize", best, best, tokens);
+
+	free(src);
+	return ret;
+}
@@ -0,0 +1,232 @@
+// Benchmark for the parser: AST memory and nodes per second on a synthetic
+// module, including one array literal too long for 16-bit node offsets.
+// Also times walking that literal's chain in the packed Ast against the same
+// walk over whole AstNodes, which is what codegen did before, and checks that
+// parsing on several threads gives the same Ast. That's timed in CPU time, so
+// it shows the cost of splitting and splicing, not the speedup.
+// Build and run with `./build bench`.
+#include <time.h>
+
+#include "../src/util.c"
+#include "../src/scan.c"
+#include "../src/lexer.c"
+#include "../src/parser.c"
+
+#define FN_COUNT 4000
+#define TABLE_LEN 100000 // Elements in the big array literal, each is a node
+#define RUNS 5
+#define PARALLEL_JOBS 4
+
+// Only used for diagnostics, and the module parses cleanly
+void wyrt_diag(FILE *file, char *const *idents, char *const *strings, const TypeContext *tc, const char *fmt, ...)
+{
+	(void) file; (void) idents; (void) strings; (void) tc; (void) fmt;
+}
+
+static char *gen_source(size_t *len)
+{
+	char *src = malloc(FN_COUNT * 256 + TABLE_LEN * 8 + 256);
+	if(!src) return NULL;
+
+	size_t i = 0;
+	for(int fn = 0; fn < FN_COUNT; fn++) {
+		i += sprintf(
+			src + i,
+			"fn f%d(a: u8, b: &const u8) u8\n"
+			"{\n"
+			"\tconst x: u8 = a + 3 * (a - 1);\n"
+			"\tvar y: [3]u8 = {1, 2, x};\n"
+			"\tif(x >= 2 && a != 4) {\n"
+			"\t\ty[1] += 5;\n"
+			"\t} else {\n"
+			"\t\ty[0] = *b;\n"
+			"\t}\n"
+			"\treturn y[1];\n"
+			"}\n",
+			fn
+		);
+	}
+
+	i += sprintf(src + i, "fn table() u32\n{\n\tconst t: [%d]u32 = {", TABLE_LEN);
+	for(int elem = 0; elem < TABLE_LEN; elem++) {
+		i += sprintf(src + i, elem ? ", %d" : "%d", elem * 7 % 1000);
+	}
+	i += sprintf(src + i, "};\n\treturn t[5];\n}\n");
+
+	*len = i;
+	return src;
+}
+
+// Index of the big literal's first element
+static size_t table_start(Ast const *ast)
+{
+	for(size_t i = ast->len; i-- > 0;) {
+		if(ast->types[i] != AST_ARRAY_LIT) continue;
+		return i + ast_get(ast, i).array_lit.elems;
+	}
+	return 0;
+}
+
+// Walks the big literal's element chain, which only works if no link overflowed
+static size_t table_elems(Ast const *ast, size_t elem)
+{
+	size_t count = 0;
+	while(true) {
+		count += ast->types[elem] == AST_INT_LIT;
+		if(!ast->next[elem]) break;
+		elem += ast->next[elem];
+	}
+	return count;
+}
+
+static size_t table_elems_unpacked(AstNode const *nodes, size_t elem)
+{
+	size_t count = 0;
+	while(true) {
+		count += nodes[elem].type == AST_INT_LIT;
+		if(!nodes[elem].com.next) break;
+		elem += nodes[elem].com.next;
+	}
+	return count;
+}
+
+static bool same_ast(Ast const *a, Ast const *b)
+{
+	return a->len == b->len
+		&& !memcmp(a->types, b->types, a->len)
+		&& !memcmp(a->locs, b->locs, a->len * sizeof(uint32_t))
+		&& !memcmp(a->next, b->next, a->len * sizeof(Offset))
+		&& !memcmp(a->data, b->data, a->len * sizeof(AstPayload));
+}
+
+static double seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void)
+{
+	Error err = ERROR_OK;
+	int ret = 1;
+	Tokens toks = { 0 };
+	char **idents = NULL;
+	char **strings = NULL;
+	size_t ident_count, string_count;
+
+	size_t len;
+	char *src = gen_source(&len);
+	if(!src) {
+		fprintf(stderr, "Out of Memory!\n");
+		return 1;
+	}
+
+	Lexer lex = {
+		.file_contents = src,
+		.file_length = len,
+		.scan = scan_best(),
+		.jobs = 1,
+	};
+	lexer_tokenize(&lex, &toks, &idents, &ident_count, &strings, &string_count, &err);
+	if(err) goto RET;
+
+	double best = 0;
+	double walk_packed = 0;
+	double walk_unpacked = 0;
+	size_t nodes = 0;
+	size_t elems = 0;
+	size_t elems_unpacked = 0;
+	for(int i = 0; i < RUNS; i++) {
+		Parser prs;
+		parser_init(&prs, &toks, idents, strings);
+
+		clock_t start = clock();
+		parser_parse(&prs, &err);
+		double t = seconds(start);
+		if(!i || t < best) best = t;
+		if(err) {
+			parser_clean(&prs);
+			goto RET;
+		}
+
+		nodes = prs.tree.len;
+		AstNode *unpacked = malloc(sizeof(AstNode) * nodes);
+		if(!unpacked) {
+			fprintf(stderr, "Out of Memory!\n");
+			parser_clean(&prs);
+			goto RET;
+		}
+		for(size_t j = 0; j < nodes; j++) unpacked[j] = ast_get(&prs.tree, j);
+		size_t table = table_start(&prs.tree);
+
+		start = clock();
+		for(int j = 0; j < 100; j++) elems = table_elems(&prs.tree, table);
+		t = seconds(start);
+		if(!i || t < walk_packed) walk_packed = t;
+
+		start = clock();
+		for(int j = 0; j < 100; j++) elems_unpacked = table_elems_unpacked(unpacked, table);
+		t = seconds(start);
+		if(!i || t < walk_unpacked) walk_unpacked = t;
+
+		free(unpacked);
+		parser_clean(&prs);
+	}
+
+	size_t packed_size = 1 + sizeof(uint32_t) + sizeof(Offset) + sizeof(AstPayload);
+	printf(
+		"%zu nodes, %zu bytes each, %.1f MB   %8.2f ms %8.1f Mnodes/s\n",
+		nodes,
+		packed_size,
+		nodes * packed_size / (1024.0 * 1024.0),
+		best * 1000.0,
+		nodes / best / 1e6
+	);
+	printf(
+		"chain walk x100: packed %8.2f ms, AstNode %8.2f ms\n",
+		walk_packed * 1000.0,
+		walk_unpacked * 1000.0
+	);
+
+	if(elems != TABLE_LEN || elems_unpacked != TABLE_LEN) {
+		fprintf(stderr, "Array literal has %zu elements, expected %d!\n", elems, TABLE_LEN);
+		goto RET;
+	}
+
+	Parser serial;
+	parser_init(&serial, &toks, idents, strings);
+	parser_parse(&serial, &err);
+	if(err) {
+		parser_clean(&serial);
+		goto RET;
+	}
+
+	bool same = true;
+	for(int i = 0; i < RUNS; i++) {
+		Parser parallel;
+		parser_init(&parallel, &toks, idents, strings);
+		parallel.jobs = PARALLEL_JOBS;
+
+		clock_t start = clock();
+		parser_parse(&parallel, &err);
+		double t = seconds(start);
+		if(!i || t < best) best = t;
+
+		same = same && !err && same_ast(&serial.tree, &parallel.tree);
+		parser_clean(&parallel);
+		if(err) break;
+	}
+	parser_clean(&serial);
+	if(err) goto RET;
+
+	printf("-j%d: %8.2f ms cpu, %s\n", PARALLEL_JOBS, best * 1000.0, same ? "same AST" : "AST differs");
+	if(!same) goto RET;
+	ret = 0;
+
+RET:
+	if(err) fprintf(stderr, "Couldn't lex or parse the benchmark module!\n");
+	free(src);
+	tokens_clean(&toks);
+	lexer_clean_strings(idents);
+	lexer_clean_strings(strings);
+	return ret;
+}
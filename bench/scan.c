@@ -0,0 +1,186 @@
+// Microbenchmark for src/scan.c against the old per-byte lexer loops.
+// Build and run with `./build bench`.
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "../src/scan.c"
+
+#define SRC_SIZE (64 * 1024 * 1024)
+#define RUNS 5
+
+typedef struct {
+	size_t tokens;
+	size_t ident_bytes;
+} Summary;
+
+// Roughly the shape of generated code: indented lines of short identifiers
+static char *gen_source(size_t size)
+{
+	char *src = malloc(size);
+	if(!src) return NULL;
+
+	const char ident_chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+	const char punct[] = "(){};:,=+-*&[].";
+	uint32_t rng = 12345;
+	size_t i = 0;
+	while(i < size) {
+		rng = rng * 1103515245u + 12345u;
+		uint32_t r = rng >> 8;
+		size_t len;
+		switch(r % 8) {
+		case 0:
+			src[i++] = '\n';
+			for(len = r / 8 % 4; len && i < size; len--) src[i++] = '\t';
+			break;
+		case 1:
+		case 2:
+			for(len = 1 + r / 8 % 3; len && i < size; len--) src[i++] = ' ';
+			break;
+		case 3:
+			src[i++] = punct[r / 8 % (sizeof(punct) - 1)];
+			break;
+		default:
+			src[i++] = 'a' + r / 8 % 26;
+			for(len = r / 256 % 16; len && i < size; len--) {
+				rng = rng * 1103515245u + 12345u;
+				src[i++] = ident_chars[(rng >> 8) % (sizeof(ident_chars) - 1)];
+			}
+			break;
+		}
+	}
+	return src;
+}
+
+/*
+ * The loops src/lexer.c used before src/scan.c: one get_char (bounds check +
+ * line/col bookkeeping) and one ctype call per byte.
+ * The lexer no longer tracks lines at all (see lexer_locate), the scanners
+ * below only find token boundaries.
+ */
+
+typedef struct {
+	const char *src;
+	size_t len;
+	size_t pos;
+	uint32_t line;
+	uint32_t col;
+} Cursor;
+
+static int get_char(Cursor *cur)
+{
+	if(cur->pos >= cur->len) return EOF;
+	char ret = cur->src[cur->pos++];
+	if(ret == '\n') {
+		cur->col = 0;
+		cur->line += 1;
+	} else {
+		cur->col += 1;
+	}
+	return ret;
+}
+
+static Summary run_bytewise(const char *src, size_t len)
+{
+	Summary sum = { 0 };
+	Cursor cur = {src, len, 0, 1, 1};
+	while(cur.pos < len) {
+		int c = ' ';
+		while(isspace(c)) c = get_char(&cur);
+		if(c == EOF) break;
+
+		sum.tokens++;
+		if(isalpha(c) || c == '_' || c == '@') {
+			size_t start = cur.pos - 1;
+			while((isalnum(c = get_char(&cur)) || c == '_' || c == '@') && c != EOF);
+			if(c != EOF) {
+				cur.pos--;
+				if(c == '\n') cur.line--;
+				else cur.col--;
+			}
+			sum.ident_bytes += cur.pos - start;
+		}
+	}
+	return sum;
+}
+
+static Summary run_scanner(Scanner const *scan, const char *src, size_t len)
+{
+	Summary sum = { 0 };
+	size_t pos = 0;
+	while(pos < len) {
+		pos += scan->whitespace(src + pos, len - pos);
+		if(pos >= len) break;
+
+		sum.tokens++;
+		char c = src[pos++];
+		if(isalpha(c) || c == '_' || c == '@') {
+			size_t run = scan->ident(src + pos, len - pos);
+			pos += run;
+			sum.ident_bytes += run + 1;
+		}
+	}
+	return sum;
+}
+
+static double seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void report(const char *name, double best, double base, Summary sum)
+{
+	printf(
+		"%-10s %8.2f ms %8.1f MB/s %6.2fx   (%zu tokens)\n",
+		name,
+		best * 1000.0,
+		SRC_SIZE / best / (1024.0 * 1024.0),
+		base / best,
+		sum.tokens
+	);
+}
+
+int main(void)
+{
+	char *src = gen_source(SRC_SIZE);
+	if(!src) {
+		fprintf(stderr, "Out of Memory!\n");
+		return 1;
+	}
+
+	Summary expected;
+	double base = 0;
+	for(int i = 0; i < RUNS; i++) {
+		clock_t start = clock();
+		expected = run_bytewise(src, SRC_SIZE);
+		double t = seconds(start);
+		if(!i || t < base) base = t;
+	}
+	report("bytewise", base, base, expected);
+
+	int ret = 0;
+	Scanner const *const *available = scan_available();
+	for(size_t s = 0; available[s]; s++) {
+		Summary sum;
+		double best = 0;
+		for(int i = 0; i < RUNS; i++) {
+			clock_t start = clock();
+			sum = run_scanner(available[s], src, SRC_SIZE);
+			double t = seconds(start);
+			if(!i || t < best) best = t;
+		}
+		report(available[s]->name, best, base, sum);
+
+		if(
+			sum.tokens != expected.tokens
+			|| sum.ident_bytes != expected.ident_bytes
+		) {
+			fprintf(stderr, "'%s' scanner disagrees with the bytewise loop!\n", available[s]->name);
+			ret = 1;
+		}
+	}
+
+	free(src);
+	return ret;
+}
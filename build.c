@@ -18,7 +18,7 @@
 #else
 #define EXT " "
 #define DLEXT ".so"
-#define LDFLAGS "-ldl "
+#define LDFLAGS "-ldl -lpthread "
 #define DBGFLAGS "-O0 -g -fsanitize=undefined -fsanitize-trap=all "
 #define TEST_RUNNER "./test_runner "
 #define CWD_PREFIX "./"
@@ -33,9 +33,21 @@ const char *(sources[]) = {
 	"codegen",
 	"types",
 	"ui",
+	"scan",
+	"cache",
+	"stats",
 };
 const int source_count = (sizeof sources) / sizeof sources[0];
 
+// bench/<name>.c, each is a standalone program
+const char *(benches[]) = {
+	"scan",
+	"lex",
+	"parse",
+	"layout",
+};
+const int bench_count = (sizeof benches) / sizeof benches[0];
+
 typedef struct {
 	const char *name;
 	const char *desc;
@@ -52,6 +64,7 @@ int main(int argc, char **argv)
 	Error err = ERROR_OK;
 	bool release = false;
 	bool test = false;
+	bool bench = false;
 	StringBuilder cmd = { 0 };
 	StringBuilder srcpath = { 0 };
 	StringBuilder dstpath = { 0 };
@@ -68,8 +81,10 @@ int main(int argc, char **argv)
 			release = true;
 		} else if(!strcmp(argv[1], "test")) {
 			test = true;
+		} else if(!strcmp(argv[1], "bench")) {
+			bench = true;
 		} else {
-			fprintf(stderr, "Expected either 'release' or 'test', found '%s'\n", argv[1]);
+			fprintf(stderr, "Expected either 'release', 'test' or 'bench', found '%s'\n", argv[1]);
 			err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
@@ -78,6 +93,33 @@ int main(int argc, char **argv)
 	mkdir_if_nexist("obj", &err);
 	if(err) goto RET;
 
+	if(bench) {
+		for(int i = 0; i < bench_count; i++) {
+			cmd.count = 0;
+			string_builder_printf(
+				&cmd, &err, CC CFLAGS "-O3 -o " CWD_PREFIX "obj/bench_%s" EXT "bench/%s.c " LDFLAGS,
+				benches[i], benches[i]
+			);
+			if(err) goto RET;
+			if(system(cmd.str)) {
+				fprintf(stderr, "Could not build '%s' benchmark\n", benches[i]);
+				err = ERROR_IO;
+				goto RET;
+			}
+
+			cmd.count = 0;
+			string_builder_printf(&cmd, &err, CWD_PREFIX "obj/bench_%s" EXT, benches[i]);
+			if(err) goto RET;
+			printf("== %s ==\n", benches[i]);
+			fflush(stdout);
+			if(system(cmd.str)) {
+				fprintf(stderr, "'%s' benchmark failed its checks\n", benches[i]);
+				err = ERROR_UNEXPECTED_DATA;
+			}
+		}
+		goto RET;
+	}
+
 	config = fopen("config.h", "w");
 	if(!config) {
 		fprintf(stderr, "Could not create config file!\n");
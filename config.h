@@ -0,0 +1,9 @@
+typedef struct {
+	const char *name;
+	const char *desc;
+	const char *path;
+} Backend;
+
+const Backend backends[] = {
+	{"none", "Do not use any backend. (You probably also want to use --ast-dump)", NULL}
+};
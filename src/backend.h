@@ -12,7 +12,9 @@ typedef enum {
 	GEN_DBG = 0x04,
 	GEN_OPT1 = 0x08,
 	GEN_OPT2 = 0x10,
-	GEN_OPT3 = 0x18
+	GEN_OPT3 = 0x18,
+
+	GEN_TIME = 0x20, // Print how long compile's own phases took to stderr
 } GenOptions;
 
 typedef void *WyrtContext;
@@ -22,8 +24,12 @@ typedef void *WyrtFunction;
 typedef void *WyrtBlock;
 typedef void *WyrtParam;
 
+// Turns a DebugInfo into file/line/col, backends should only call it when
+// they actually need a location.
+typedef SourcePos (*WyrtLocate)(DebugInfo const*);
+
 typedef struct {
-	WyrtContext (*get_ctx)(Error*);
+	WyrtContext (*get_ctx)(WyrtLocate, Error*);
 	void (*compile)(WyrtContext, GenOptions, const char*, Error*);
 	void (*release_ctx)(WyrtContext);
 
@@ -66,7 +72,16 @@ typedef struct {
 		size_t,
 		Error*
 	);
-	WyrtRvalue (*rvalue_cstring_lit)(WyrtContext, const DebugInfo*, char const*, Error*);
+	// id is unique per distinct literal, len excludes the NUL terminator.
+	// Called for every use, the backend can share the bytes between them by id.
+	WyrtRvalue (*rvalue_cstring_lit)(
+		WyrtContext,
+		const DebugInfo*,
+		size_t,
+		char const*,
+		size_t,
+		Error*
+	);
 
 	WyrtRvalue (*rvalue_binary_op)(
 		WyrtContext,
@@ -1,11 +1,21 @@
 #include "../backend.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include <libgccjit.h>
 
-WyrtContext get_ctx(Error *err)
+// There is only ever one context per process, so this doesn't need to live in it
+static WyrtLocate locate;
+// Each string literal's str.<id> global, by id, NULL == Not made yet.
+// Only the global is shared: an rvalue using it gets tied to the first
+// function it's used in, so every use needs its own.
+static gcc_jit_lvalue **string_globals;
+static size_t string_global_cap;
+
+WyrtContext get_ctx(WyrtLocate loc, Error *err)
 {
+	locate = loc;
 	gcc_jit_context *ctx = gcc_jit_context_acquire();
 	if(!ctx) {
 		fprintf(stderr, "[BACKEND] Could not create GCC Context!\n");
@@ -40,22 +50,42 @@ void compile(WyrtContext vpctx, GenOptions options, const char *path, Error *err
 	case GEN_SHR: format = GCC_JIT_OUTPUT_KIND_DYNAMIC_LIBRARY; break;
 	}
 
+#ifdef LIBGCCJIT_HAVE_TIMING_API
+	// GCC times its own passes, including assembling and linking
+	gcc_jit_timer *timer = NULL;
+	if(options & GEN_TIME) {
+		timer = gcc_jit_timer_new();
+		gcc_jit_context_set_timer(ctx, timer);
+	}
+#endif
+
 	gcc_jit_context_compile_to_file(ctx, format, path);
 	gcc_jit_context_dump_to_file(ctx, "ir", false);
 
+#ifdef LIBGCCJIT_HAVE_TIMING_API
+	if(timer) {
+		gcc_jit_timer_print(timer, stderr);
+		gcc_jit_timer_release(timer);
+	}
+#endif
+
 	return;
 }
 
 void release_ctx(WyrtContext ctx)
 {
 	gcc_jit_context_release((gcc_jit_context*)ctx);
+	free(string_globals);
+	string_globals = NULL;
+	string_global_cap = 0;
 }
 
 static gcc_jit_location *gcc_loc(gcc_jit_context *ctx, const DebugInfo *debug, Error *err)
 {
 	if(!debug) return NULL;
 
-	gcc_jit_location *loc = gcc_jit_context_new_location(ctx, debug->file, debug->line, debug->col);
+	SourcePos pos = locate(debug);
+	gcc_jit_location *loc = gcc_jit_context_new_location(ctx, pos.file, pos.line, pos.col);
 	if(!loc) {
 		fprintf(stderr, "[BACKEND] Could not generate Source Location!\n");
 		*err = ERROR_IO;
@@ -678,24 +708,90 @@ RET:
 	return lit;
 }
 
-WyrtRvalue rvalue_cstring_lit(WyrtContext vpctx, const DebugInfo *debug, char const *str, Error *err)
+// Each literal becomes one internal, read-only global, made on its first
+// use. Every use gets a new pointer to it, at its own location.
+WyrtRvalue rvalue_cstring_lit(
+	WyrtContext vpctx,
+	const DebugInfo *debug,
+	size_t id,
+	char const *str,
+	size_t len,
+	Error *err
+)
 {
 	gcc_jit_context *ctx = vpctx;
+	gcc_jit_rvalue *val = NULL;
 
 	gcc_jit_location *loc = gcc_loc(ctx, debug, err);
 	if(*err) goto RET;
 
-	gcc_jit_rvalue *lit = gcc_jit_context_new_string_literal(ctx, str);
-
-	if(!lit) {
-		fprintf(stderr, "[BACKEND] Could not generate String Literal!\n");
+	gcc_jit_type *u8 = gcc_jit_context_get_type(ctx, GCC_JIT_TYPE_UINT8_T);
+	if(!u8) {
+		fprintf(stderr, "[BACKEND] Could not generate u8 type!\n");
 		*err = ERROR_IO;
 		goto RET;
 	}
 
-	gcc_jit_type *u8 = gcc_jit_context_get_type(ctx, GCC_JIT_TYPE_UINT8_T);
-	if(!u8) {
-		fprintf(stderr, "[BACKEND] Could not generate u8 type!\n");
+#ifdef LIBGCCJIT_HAVE_gcc_jit_global_set_initializer
+	if(id >= string_global_cap) {
+		size_t cap = string_global_cap ? string_global_cap : 64;
+		while(cap <= id) cap *= 2;
+		gcc_jit_lvalue **globals = realloc(string_globals, cap * sizeof(*globals));
+		CHECK_MALLOC(globals);
+		memset(globals + string_global_cap, 0, (cap - string_global_cap) * sizeof(*globals));
+		string_globals = globals;
+		string_global_cap = cap;
+	}
+
+	gcc_jit_lvalue *global = string_globals[id];
+	if(!global) {
+		gcc_jit_type *arr = gcc_jit_context_new_array_type(
+			ctx,
+			loc,
+			gcc_jit_type_get_const(u8),
+			len + 1
+		);
+		if(!arr) {
+			fprintf(stderr, "[BACKEND] Could not generate String Literal type!\n");
+			*err = ERROR_IO;
+			goto RET;
+		}
+
+		// '.' keeps it from colliding with any Wyrt identifier
+		char name[32] = {0};
+		snprintf(name, sizeof(name), "str.%zu", id);
+
+		global = gcc_jit_context_new_global(
+			ctx,
+			loc,
+			GCC_JIT_GLOBAL_INTERNAL,
+			arr,
+			name
+		);
+		if(global) global = gcc_jit_global_set_initializer(global, str, len + 1);
+		if(!global) {
+			fprintf(stderr, "[BACKEND] Could not generate String Literal!\n");
+			*err = ERROR_IO;
+			goto RET;
+		}
+		string_globals[id] = global;
+	}
+
+	gcc_jit_lvalue *first = gcc_jit_context_new_array_access(
+		ctx,
+		loc,
+		gcc_jit_lvalue_as_rvalue(global),
+		gcc_jit_context_zero(ctx, gcc_jit_context_get_type(ctx, GCC_JIT_TYPE_SIZE_T))
+	);
+	gcc_jit_rvalue *lit = first ? gcc_jit_lvalue_get_address(first, loc) : NULL;
+#else
+	(void) id;
+	(void) len;
+	gcc_jit_rvalue *lit = gcc_jit_context_new_string_literal(ctx, str);
+#endif
+
+	if(!lit) {
+		fprintf(stderr, "[BACKEND] Could not generate String Literal!\n");
 		*err = ERROR_IO;
 		goto RET;
 	}
@@ -707,7 +803,7 @@ WyrtRvalue rvalue_cstring_lit(WyrtContext vpctx, const DebugInfo *debug, char co
 		goto RET;
 	}
 
-	gcc_jit_rvalue *val = gcc_jit_context_new_cast(ctx, loc, lit, t);
+	val = gcc_jit_context_new_cast(ctx, loc, lit, t);
 	if(!val) {
 		fprintf(stderr, "[BACKEND] Could not make String Literal into &u8!\n");
 		*err = ERROR_IO;
@@ -0,0 +1,368 @@
+#include "cache.h"
+
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define CACHE_MAGIC "WYRTAST" // 8 bytes, with the NUL
+#define CACHE_VERSION 3 // Bump whenever AstNode, its enums or the layout below change
+
+#define CACHE_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+/*
+ * The header is followed by these sections, each padded to 8 bytes:
+ * Ast.data, Ast.next, Ast.locs, Ast.types, then the identifier pool and the
+ * string pool, both as intern_finish leaves them ([u32 len][bytes][NUL]...).
+ * Nothing in them is bounds checked when they're used (node offsets, Ids,
+ * string ids), so they're hashed too, and a cache whose bytes changed since
+ * it was written is thrown out like a stale one.
+ */
+#define CACHE_SECTIONS 6
+
+typedef struct {
+	void const *data;
+	size_t len; // Without padding
+} CacheSection;
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t payload_size; // sizeof(AstPayload)
+	uint64_t source_hash;
+	uint64_t source_length;
+	uint64_t sections_hash;
+	uint64_t node_count;
+	uint64_t identifier_count;
+	uint64_t identifier_bytes;
+	uint64_t string_count;
+	uint64_t string_bytes;
+} CacheHeader;
+
+static inline uint64_t cache_mix(uint64_t h)
+{
+	h *= 0x9E3779B97F4A7C15u;
+	return h ^ (h >> 29);
+}
+
+// Not cryptographic, it only has to notice that the source changed.
+// Four lanes, so it isn't bound by the latency of a multiply per word.
+uint64_t cache_hash(const char *src, size_t len)
+{
+	uint64_t lanes[4] = {
+		0x243F6A8885A308D3u, 0x13198A2E03707344u,
+		0xA4093822299F31D0u, 0x082EFA98EC4E6C89u,
+	};
+
+	size_t i = 0;
+	uint64_t words[4];
+	for(; i + sizeof words <= len; i += sizeof words) {
+		memcpy(words, src + i, sizeof words);
+		for(int j = 0; j < 4; j++) lanes[j] = cache_mix(lanes[j] ^ words[j]);
+	}
+	memset(words, 0, sizeof words);
+	memcpy(words, src + i, len - i);
+	for(int j = 0; j < 4; j++) lanes[j] = cache_mix(lanes[j] ^ words[j]);
+
+	uint64_t hash = len;
+	for(int j = 0; j < 4; j++) hash = cache_mix(hash ^ lanes[j]);
+	return hash;
+}
+
+static uint64_t cache_sections_hash(CacheSection const *sections)
+{
+	uint64_t hash = 0;
+	for(size_t i = 0; i < CACHE_SECTIONS; i++) {
+		if(sections[i].len) hash ^= cache_hash(sections[i].data, sections[i].len);
+		hash = cache_mix(hash ^ i);
+	}
+	return hash;
+}
+
+char *cache_path(const char *src_path, Error *err)
+{
+	size_t len = strlen(src_path);
+	char *path = malloc(len + 4);
+	CHECK_MALLOC(path);
+
+	memcpy(path, src_path, len);
+	if(len >= 2 && !strcmp(src_path + len - 2, ".w")) {
+		strcpy(path + len, "c");
+	} else {
+		strcpy(path + len, ".wc");
+	}
+
+RET:
+	return path;
+}
+
+// Like lexer_map, but a missing file is fine and on Windows it's read instead
+static bool cache_map(AstCache *cache, const char *path)
+{
+	bool ok = false;
+#ifdef _WIN32
+	FILE *file = fopen(path, "rb");
+	if(!file) goto RET;
+
+	fseek(file, 0, SEEK_END);
+	long len = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if(len <= 0) goto RET;
+
+	cache->data = malloc(len);
+	if(!cache->data) goto RET;
+	cache->len = len;
+	cache->mapped = false;
+	if(fread(cache->data, 1, len, file) < (size_t)len) {
+		free(cache->data);
+		cache->data = NULL;
+		goto RET;
+	}
+	ok = true;
+RET:
+	if(file) fclose(file);
+	return ok;
+#else
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) goto RET;
+
+	struct stat st;
+	if(fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size == 0) goto RET;
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(map == MAP_FAILED) goto RET;
+
+	cache->data = map;
+	cache->len = st.st_size;
+	cache->mapped = true;
+	ok = true;
+RET:
+	if(fd >= 0) close(fd);
+	return ok;
+#endif
+}
+
+// Points table at every string in pool, checking that they fill it exactly
+static bool cache_load_pool(
+	char *pool,
+	size_t bytes,
+	size_t count,
+	char ***table,
+	Error *err
+)
+{
+	bool ok = false;
+	*table = NULL;
+	if(!count) {
+		ok = !bytes;
+		goto RET;
+	}
+
+	*table = malloc(count * sizeof(char*));
+	CHECK_MALLOC(*table);
+
+	size_t at = 0;
+	for(size_t i = 0; i < count; i++) {
+		uint32_t len;
+		if(bytes - at < sizeof len) goto RET;
+		memcpy(&len, pool + at, sizeof len);
+		at += sizeof len;
+
+		if(bytes - at <= len || pool[at + len]) goto RET;
+		(*table)[i] = pool + at;
+		at += len + 1;
+	}
+	ok = at == bytes;
+
+RET:
+	if(!ok) {
+		free(*table);
+		*table = NULL;
+	}
+	return ok;
+}
+
+bool cache_load(
+	AstCache *cache,
+	const char *path,
+	uint64_t source_hash,
+	size_t source_length,
+	uint32_t file,
+	char ***identifiers, size_t *identifier_count,
+	char ***strings, size_t *string_count,
+	Error *err
+)
+{
+	bool ok = false;
+	char **idents = NULL;
+	char **strs = NULL;
+
+	*cache = (AstCache) {0};
+	if(!cache_map(cache, path)) goto RET;
+
+	CacheHeader head;
+	if(cache->len < sizeof head) goto RET;
+	memcpy(&head, cache->data, sizeof head);
+
+	if(
+		memcmp(head.magic, CACHE_MAGIC, sizeof head.magic)
+		|| head.version != CACHE_VERSION
+		|| head.payload_size != sizeof(AstPayload)
+		|| head.source_hash != source_hash
+		|| head.source_length != source_length
+	) goto RET;
+
+	// Every count is bounded by the file's size, so none of this overflows
+	size_t len = cache->len;
+	if(
+		head.node_count > len
+		|| head.identifier_bytes > len
+		|| head.string_bytes > len
+		|| head.identifier_count > head.identifier_bytes
+		|| head.string_count > head.string_bytes
+	) goto RET;
+
+	size_t nodes = head.node_count;
+	size_t at = sizeof head;
+	size_t data_at = at;
+	at += CACHE_ALIGN(sizeof(AstPayload) * nodes);
+	size_t next_at = at;
+	at += CACHE_ALIGN(sizeof(Offset) * nodes);
+	size_t locs_at = at;
+	at += CACHE_ALIGN(sizeof(uint32_t) * nodes);
+	size_t types_at = at;
+	at += CACHE_ALIGN(nodes);
+	size_t idents_at = at;
+	at += CACHE_ALIGN(head.identifier_bytes);
+	size_t strs_at = at;
+	at += CACHE_ALIGN(head.string_bytes);
+	if(at != len) goto RET;
+
+	char *base = cache->data;
+	CacheSection sections[CACHE_SECTIONS] = {
+		{base + data_at, sizeof(AstPayload) * nodes},
+		{base + next_at, sizeof(Offset) * nodes},
+		{base + locs_at, sizeof(uint32_t) * nodes},
+		{base + types_at, nodes},
+		{base + idents_at, head.identifier_bytes},
+		{base + strs_at, head.string_bytes},
+	};
+	if(cache_sections_hash(sections) != head.sections_hash) goto RET;
+
+	if(!cache_load_pool(base + idents_at, head.identifier_bytes, head.identifier_count, &idents, err)) goto RET;
+	if(!cache_load_pool(base + strs_at, head.string_bytes, head.string_count, &strs, err)) goto RET;
+
+	cache->tree = (Ast) {
+		.types = (uint8_t*)(base + types_at),
+		.locs = (uint32_t*)(base + locs_at),
+		.next = (Offset*)(base + next_at),
+		.data = (AstPayload*)(base + data_at),
+		.len = nodes,
+		.file = file,
+	};
+	*identifiers = idents;
+	*identifier_count = head.identifier_count;
+	*strings = strs;
+	*string_count = head.string_count;
+	ok = true;
+
+RET:
+	if(!ok) {
+		free(idents);
+		free(strs);
+		cache_clean(cache);
+		*cache = (AstCache) {0};
+	}
+	return ok;
+}
+
+void cache_clean(AstCache const *cache)
+{
+	if(!cache->data) return;
+#ifndef _WIN32
+	if(cache->mapped) {
+		munmap(cache->data, cache->len);
+		return;
+	}
+#endif
+	free(cache->data);
+}
+
+// intern_finish tables keep their strings in one pool, in id order
+static size_t cache_pool_bytes(char *const *table, size_t count)
+{
+	if(!count) return 0;
+	char const *start = table[0] - sizeof(uint32_t);
+	char const *end = table[count - 1] + intern_len(table, count - 1) + 1;
+	return end - start;
+}
+
+static bool cache_write(FILE *file, void const *data, size_t len)
+{
+	static const char zeros[8];
+	if(!len) return true;
+	return fwrite(data, 1, len, file) == len
+		&& fwrite(zeros, 1, CACHE_ALIGN(len) - len, file) == CACHE_ALIGN(len) - len;
+}
+
+void cache_store(
+	const char *path,
+	uint64_t source_hash,
+	size_t source_length,
+	Ast const *ast,
+	char *const *identifiers, size_t identifier_count,
+	char *const *strings, size_t string_count,
+	Error *err
+)
+{
+	FILE *file = fopen(path, "wb");
+	if(!file) {
+		*err = ERROR_IO;
+		goto RET;
+	}
+
+	size_t identifier_bytes = cache_pool_bytes(identifiers, identifier_count);
+	size_t string_bytes = cache_pool_bytes(strings, string_count);
+	CacheSection sections[CACHE_SECTIONS] = {
+		{ast->data, sizeof(AstPayload) * ast->len},
+		{ast->next, sizeof(Offset) * ast->len},
+		{ast->locs, sizeof(uint32_t) * ast->len},
+		{ast->types, ast->len},
+		{identifier_count ? identifiers[0] - sizeof(uint32_t) : NULL, identifier_bytes},
+		{string_count ? strings[0] - sizeof(uint32_t) : NULL, string_bytes},
+	};
+
+	CacheHeader head = {
+		.magic = CACHE_MAGIC,
+		.version = CACHE_VERSION,
+		.payload_size = sizeof(AstPayload),
+		.source_hash = source_hash,
+		.source_length = source_length,
+		.sections_hash = cache_sections_hash(sections),
+		.node_count = ast->len,
+		.identifier_count = identifier_count,
+		.identifier_bytes = identifier_bytes,
+		.string_count = string_count,
+		.string_bytes = string_bytes,
+	};
+
+	bool ok = cache_write(file, &head, sizeof head);
+	for(size_t i = 0; ok && i < CACHE_SECTIONS; i++) {
+		ok = cache_write(file, sections[i].data, sections[i].len);
+	}
+	if(fclose(file)) ok = false;
+	file = NULL;
+
+	// A partial cache would be rejected anyway, but don't leave it around
+	if(!ok) {
+		remove(path);
+		*err = ERROR_IO;
+	}
+
+RET:
+	return;
+}
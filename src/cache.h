@@ -0,0 +1,53 @@
+#pragma once
+#include "util.h"
+#include "parser.h"
+
+/*
+ * On-disk AST cache, written next to the source (see cache_path).
+ * It holds the packed Ast and the identifier and string tables in one file,
+ * laid out so that loading it is an mmap plus a walk over the string pools.
+ * A cache is tied to the exact bytes of its source by cache_hash, and to the
+ * compiler that wrote it by CACHE_VERSION and the size of an AstPayload.
+ * Its own bytes are hashed too, so a damaged cache is rewritten, not trusted.
+ * It's in native byte order, and isn't meant to be shared between machines.
+ */
+typedef struct {
+	Ast tree; // Points into data, don't ast_clean it
+	void *data;
+	size_t len;
+	bool mapped; // data is an mmap of the cache file, rather than read into memory
+} AstCache;
+
+uint64_t cache_hash(const char *src, size_t len);
+
+// <src>c for a .w file, <src>.wc otherwise. Returns a malloc'd path.
+char *cache_path(const char *src_path, Error *err);
+
+/*
+ * Returns false if there is no usable cache at path, which includes one that
+ * was written for different source. err is only set if memory runs out.
+ * On success identifiers and strings are tables like lexer_tokenize's, which
+ * point into cache and are freed with lexer_clean_strings.
+ * file is the Lexer.file of the source, for the tree's DebugInfo.
+ */
+bool cache_load(
+	AstCache *cache,
+	const char *path,
+	uint64_t source_hash,
+	size_t source_length,
+	uint32_t file,
+	char ***identifiers, size_t *identifier_count,
+	char ***strings, size_t *string_count,
+	Error *err
+);
+void cache_clean(AstCache const *cache);
+
+void cache_store(
+	const char *path,
+	uint64_t source_hash,
+	size_t source_length,
+	Ast const *ast,
+	char *const *identifiers, size_t identifier_count,
+	char *const *strings, size_t string_count,
+	Error *err
+);
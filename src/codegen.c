@@ -4,6 +4,7 @@
 #include <assert.h>
 
 #include "ui.h"
+#include "stats.h"
 
 #ifdef _WIN32
 void *LoadLibraryA(const char *);
@@ -13,6 +14,9 @@ int FreeLibrary(void *);
 #include <dlfcn.h>
 #endif
 
+// cg's backend function name, counting the call for --time-passes
+#define BE(name) (counters.backend_calls += 1, cg->be.name)
+
 typedef struct {
 	WyrtRvalue expr;
 	Type type;
@@ -27,8 +31,7 @@ typedef struct {
 
 void codegen_init(
 	CodeGen *cg,
-	const AstNode *nodes,
-	size_t node_count,
+	Ast const *ast,
 	char *const *identifiers,
 	char *const *strings,
 	size_t string_count,
@@ -66,12 +69,11 @@ void codegen_init(
 	}
 #endif
 
-	WyrtContext ctx = be->get_ctx(err);
+	WyrtContext ctx = be->get_ctx(lexer_locate, err);
 	if(*err) goto RET;
 
 	*cg = (CodeGen) {
-		.nodes = nodes,
-		.node_count = node_count,
+		.ast = ast,
 		.identifiers = identifiers,
 		.strings = strings,
 		.string_count = string_count,
@@ -89,12 +91,10 @@ RET:
 
 void codegen_clean(const CodeGen *cg)
 {
-	for(size_t i = 0; i < cg->fn_count; i++) {
-		free(cg->fn_sigs[i].args);
-		free(cg->fn_sigs[i].arg_ids);
-	}
 	free(cg->fn_sigs);
 	free(cg->fns);
+	arena_clean(&cg->arena);
+	arena_clean(&cg->fn_arena);
 	if(cg->be.release_ctx) cg->be.release_ctx(cg->ctx);
 
 #ifdef _WIN32
@@ -104,6 +104,123 @@ void codegen_clean(const CodeGen *cg)
 #endif
 }
 
+// Where to start probing for name in a table of mask + 1 slots
+static size_t name_slot(size_t name, size_t mask)
+{
+	return ((name + 1) * 0x9E3779B97F4A7C15u >> 32) & mask;
+}
+
+// name's slot, or the empty one it would go in
+static SymbolSlot *symbols_slot(SymbolTable const *st, Id name)
+{
+	size_t mask = st->slot_cap - 1;
+	for(size_t j = name_slot(name, mask);; j = (j + 1) & mask) {
+		SymbolSlot *slot = &st->slots[j];
+		if(!slot->name || slot->name == name + 1) return slot;
+	}
+}
+
+static void symbols_grow_slots(SymbolTable *st, Error *err)
+{
+	SymbolSlot *old = st->slots;
+	size_t old_cap = st->slot_cap;
+
+	st->slot_cap = old_cap ? old_cap * 2 : 64;
+	st->slots = arena_alloc(st->arena, st->slot_cap * sizeof(SymbolSlot), err);
+	if(*err) goto RET;
+	memset(st->slots, 0, st->slot_cap * sizeof(SymbolSlot));
+
+	// Names with nothing in scope can go
+	st->slot_count = 0;
+	for(size_t i = 0; i < old_cap; i++) {
+		if(!old[i].symbol) continue;
+		*symbols_slot(st, old[i].name - 1) = old[i];
+		st->slot_count += 1;
+	}
+
+RET:
+	return;
+}
+
+// NULL == Not Found
+static Symbol *scope_lookup(Scope const *scope, Id name)
+{
+	SymbolTable const *st = scope->symbols;
+	if(!st || !st->slot_cap) return NULL;
+	SymbolSlot const *slot = symbols_slot(st, name);
+	return slot->symbol ? &st->symbols[slot->symbol - 1] : NULL;
+}
+
+// Adds a symbol to the innermost scope, which has to be scope
+static void scope_push(Scope *scope, Symbol symbol, Error *err)
+{
+	SymbolTable *st = scope->symbols;
+	if(st->count == st->cap) {
+		size_t cap = st->cap ? st->cap * 2 : 32;
+		st->symbols = arena_realloc(st->arena, st->symbols, st->cap * sizeof(Symbol), cap * sizeof(Symbol), err);
+		if(*err) goto RET;
+		st->cap = cap;
+	}
+	if(2 * (st->slot_count + 1) > st->slot_cap) {
+		symbols_grow_slots(st, err);
+		if(*err) goto RET;
+	}
+
+	SymbolSlot *slot = symbols_slot(st, symbol.var.id);
+	Symbol const *hidden = slot->symbol ? &st->symbols[slot->symbol - 1] : NULL;
+	symbol.bound = !hidden || (hidden->param && !symbol.param);
+	if(symbol.bound) {
+		if(!slot->name) {
+			slot->name = symbol.var.id + 1;
+			st->slot_count += 1;
+		}
+		symbol.shadowed = slot->symbol;
+		slot->symbol = st->count + 1;
+	}
+	st->symbols[st->count++] = symbol;
+
+RET:
+	return;
+}
+
+// Indexes fn_sigs, which have to be done already
+static void fn_index_build(CodeGen *cg, Error *err)
+{
+	size_t cap = 16;
+	while(cap < 2 * cg->fn_count) cap *= 2;
+	cg->fn_slots = arena_alloc(&cg->arena, cap * sizeof(FnSlot), err);
+	if(*err) goto RET;
+	memset(cg->fn_slots, 0, cap * sizeof(FnSlot));
+	cg->fn_slot_cap = cap;
+
+	for(size_t i = 0; i < cg->fn_count; i++) {
+		size_t id = cg->fn_sigs[i].id;
+		for(size_t j = name_slot(id, cap - 1);; j = (j + 1) & (cap - 1)) {
+			FnSlot *slot = &cg->fn_slots[j];
+			if(slot->name == id + 1) break;
+			if(!slot->name) {
+				*slot = (FnSlot) {id + 1, i};
+				break;
+			}
+		}
+	}
+
+RET:
+	return;
+}
+
+size_t codegen_find_fn(CodeGen const *cg, size_t id)
+{
+	if(!cg->fn_slot_cap) return SIZE_MAX;
+
+	size_t mask = cg->fn_slot_cap - 1;
+	for(size_t j = name_slot(id, mask);; j = (j + 1) & mask) {
+		FnSlot slot = cg->fn_slots[j];
+		if(!slot.name) return SIZE_MAX;
+		if(slot.name == id + 1) return slot.fn;
+	}
+}
+
 static WyrtFunction *gen_fnsig(
 	CodeGen *cg,
 	FnSig *sig,
@@ -113,63 +230,67 @@ static WyrtFunction *gen_fnsig(
 )
 {
 	WyrtFunction fn = NULL;
-	DynArr args;
-	DynArr arg_ids;
-	DynArr arg_bes;
-	dynarr_init(&args, sizeof(Type));	
-	dynarr_init(&arg_ids, sizeof(size_t));
-	dynarr_init(&arg_bes, sizeof(WyrtParam));
+	Type *args = NULL;
+	size_t *arg_ids = NULL;
+	WyrtParam *arg_bes = NULL;
+	size_t arg_be_count = 0;
 
-	assert(cg->nodes[i].type == AST_FN_DEF);
-	Id id = cg->nodes[i].fn_def.id;
+	assert(cg->ast->types[i] == AST_FN_DEF);
+	Id id = ast_get(cg->ast, i).fn_def.id;
 
-	AstNode const *block = &cg->nodes[i + cg->nodes[i].fn_def.block];
+	size_t block_index = i + ast_get(cg->ast, i).fn_def.block;
 	bool imported;
 	size_t linkage_name;
 	
-	if(block->type == AST_EXTERN) {
-		AstNode const *name = block + block->extrn.name;
-		assert(name->type == AST_STRING_LIT);
-		linkage_name = name->string_lit.id;
+	if(cg->ast->types[block_index] == AST_EXTERN) {
+		size_t name_index = block_index + ast_get(cg->ast, block_index).extrn.name;
+		assert(cg->ast->types[name_index] == AST_STRING_LIT);
+		linkage_name = ast_get(cg->ast, name_index).string_lit.id;
 		imported = true;
 	} else {
 		linkage_name = id;
 		imported = false;
 	}
 
-	size_t type_index = i + cg->nodes[i].fn_def.fn_type;
-	AstNode type = cg->nodes[type_index];
+	size_t type_index = i + ast_get(cg->ast, i).fn_def.fn_type;
+	AstNode type = ast_get(cg->ast, type_index);
 	assert(type.type == AST_FN_TYPE);
 
 	Type ret = type_from_ast(
-		&scope->tc,
-		cg->nodes,
+		scope->tc,
+		cg->ast,
 		type.fn_type.ret_type + type_index,
 		err
 	);
 	if(*err) goto RET;
 
+	// The signature lives as long as cg, the backend's params are only needed for new_function
+	args = arena_alloc(&cg->arena, type.fn_type.arg_count * sizeof(*args), err);
+	if(*err) goto RET;
+	arg_ids = arena_alloc(&cg->arena, type.fn_type.arg_count * sizeof(*arg_ids), err);
+	if(*err) goto RET;
+	arg_bes = arena_alloc(&cg->fn_arena, 2 * type.fn_type.arg_count * sizeof(*arg_bes), err);
+	if(*err) goto RET;
+
 	size_t additional = 0;
-	AstNode const *arg = &cg->nodes[type_index + type.fn_type.args];
+	size_t arg = type_index + type.fn_type.args;
 	for(size_t i = 0; i < type.fn_type.arg_count; i++) {
-		assert(arg->type == AST_IDENT);
-		size_t arg_id = arg->ident.id;
+		assert(cg->ast->types[arg] == AST_IDENT);
+		size_t arg_id = ast_get(cg->ast, arg).ident.id;
 
-		arg += arg->com.next;
+		arg += cg->ast->next[arg];
 		Type arg_type = type_from_ast(
-			&scope->tc,
-			cg->nodes,
-			arg - cg->nodes,
+			scope->tc,
+			cg->ast,
+			arg,
 			err
 		);
 		if(*err) goto RET;
 
-		dynarr_push(&args, &arg_type, err);
-		if(*err) goto RET;
-		dynarr_push(&arg_ids, &arg_id, err);
-		if(*err) goto RET;
+		args[i] = arg_type;
+		arg_ids[i] = arg_id;
 
-		arg += arg->com.next;
+		arg += cg->ast->next[arg];
 		if(arg_type.type == TYPE_SLICE_CONST
 			|| arg_type.type == TYPE_SLICE_ABYSS
 			|| arg_type.type == TYPE_SLICE_VAR
@@ -183,45 +304,42 @@ static WyrtFunction *gen_fnsig(
 			Type ptr = arg_type;
 			ptr.type -= TYPE_SLICE_CONST - TYPE_POINTER_CONST;
 
-			WyrtParam arg_ptr_be = cg->be.new_param(
+			WyrtParam arg_ptr_be = BE(new_param)(
 				cg->ctx,
-				&arg->com.debug,
+				&AST_DEBUG(cg->ast, arg),
 				ptr,
-				&scope->tc,
+				scope->tc,
 				ptr_name,
 				err
 			);
 			if(*err) goto RET;
 
-			WyrtParam arg_len_be = cg->be.new_param(
+			WyrtParam arg_len_be = BE(new_param)(
 				cg->ctx,
-				&arg->com.debug,
+				&AST_DEBUG(cg->ast, arg),
 				(Type) {.type = TYPE_PRIMITIVE_U64},
-				&scope->tc,
+				scope->tc,
 				len_name,
 				err
 			);
 			if(*err) goto RET;
 
-			dynarr_push(&arg_bes, &arg_ptr_be, err);
-			if(*err) goto RET;
-			dynarr_push(&arg_bes, &arg_len_be, err);
-			if(*err) goto RET;
+			arg_bes[arg_be_count++] = arg_ptr_be;
+			arg_bes[arg_be_count++] = arg_len_be;
 
 			additional += 1;
 		} else {
-			WyrtParam arg_be = cg->be.new_param(
+			WyrtParam arg_be = BE(new_param)(
 				cg->ctx,
-				&arg->com.debug,
+				&AST_DEBUG(cg->ast, arg),
 				arg_type,
-				&scope->tc,
+				scope->tc,
 				id_get(cg->identifiers, arg_id),
 				err
 			);
 			if(*err) goto RET;
 
-			dynarr_push(&arg_bes, &arg_be, err);
-			if(*err) goto RET;
+			arg_bes[arg_be_count++] = arg_be;
 		}
 	}
 
@@ -229,18 +347,18 @@ static WyrtFunction *gen_fnsig(
 		.id = id,
 		.linkage_name = linkage_name,
 		.ret = ret,
-		.arg_count = args.count,
-		.args = args.data,
-		.arg_ids = arg_ids.data,
+		.arg_count = type.fn_type.arg_count,
+		.args = args,
+		.arg_ids = arg_ids,
 	};
 
-	fn = cg->be.new_function(
+	fn = BE(new_function)(
 		cg->ctx,
-		&cg->nodes[i].com.debug,
+		&AST_DEBUG(cg->ast, i),
 		ret,
-		&scope->tc,
-		(WyrtParam*)arg_bes.data,
-		arg_bes.count,
+		scope->tc,
+		arg_bes,
+		arg_be_count,
 		imported,
 		imported ? cg->strings[linkage_name] : id_get(cg->identifiers, id),
 		err
@@ -248,12 +366,6 @@ static WyrtFunction *gen_fnsig(
 	if(*err) goto RET;
 		
 RET:
-	if(*err) {
-		dynarr_clean(&args);
-		dynarr_clean(&arg_ids);
-	}
-	dynarr_clean(&arg_bes);
-
 	return fn;
 }
 
@@ -280,7 +392,7 @@ static WyrtRvalue gen_cast(
 	case TYPE_PRIMITIVE_S16:
 	case TYPE_PRIMITIVE_S32:
 	case TYPE_PRIMITIVE_S64:
-		new = cg->be.new_cast(
+		new = BE(new_cast)(
 			cg->ctx,
 			loc,
 			expr.expr,
@@ -316,11 +428,13 @@ static WyrtRvalue gen_cast(
 			Type ptr_to_elem = types_get_ptr(
 				tc,
 				tc->types[slice.slice.base],
-				expr.type.type
+				expr.type.type,
+				err
 			);
+			if(*err) goto RET;
 
 			WyrtRvalue rvalues[2];
-			rvalues[0] = cg->be.new_cast(
+			rvalues[0] = BE(new_cast)(
 				cg->ctx,
 				loc,
 				expr.expr,
@@ -330,7 +444,7 @@ static WyrtRvalue gen_cast(
 			);
 			if(*err) goto RET;
 
-			rvalues[1] = cg->be.rvalue_int_lit(
+			rvalues[1] = BE(rvalue_int_lit)(
 				cg->ctx,
 				tc->types[expr.type.pointer.base].array.len,
 				TYPE_PRIMITIVE_U64,
@@ -338,7 +452,7 @@ static WyrtRvalue gen_cast(
 			);
 			if(*err) goto RET;
 
-			new = cg->be.rvalue_struct_lit(
+			new = BE(rvalue_struct_lit)(
 				cg->ctx,
 				loc,
 				slice,
@@ -382,15 +496,29 @@ static WyrtRvalue gen_cast(
 
 RET:
 	return new;
-}	
+}
+
+// The backend keeps one copy of each literal's bytes, but every use is its
+// own rvalue, since it belongs to the function it's used in
+static WyrtRvalue gen_string_lit(CodeGen *cg, size_t id, const DebugInfo *debug, Error *err)
+{
+	return BE(rvalue_cstring_lit)(
+		cg->ctx,
+		debug,
+		id,
+		cg->strings[id],
+		intern_len(cg->strings, id),
+		err
+	);
+}
 
 static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Error *err)
 {
-	AstNode expr = cg->nodes[index];
+	AstNode expr = ast_get(cg->ast, index);
 	Expr ret;
 
 	Type maybe_typedef = expected;
-	expected = type_resolve(&scope->tc, expected);
+	expected = type_resolve(scope->tc, expected);
 
 	switch(expr.type) {
 	case AST_INT_LIT:
@@ -404,42 +532,39 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			ret.type.type = TYPE_PRIMITIVE_U64;
 		}
 
-		ret.expr = cg->be.rvalue_int_lit(cg->ctx, expr.int_lit.val, ret.type.type, err);
+		ret.expr = BE(rvalue_int_lit)(cg->ctx, expr.int_lit.val, ret.type.type, err);
 		if(*err) goto RET;
 		break;
 
 	case AST_IDENT: {
-		for(size_t i = 0; i < scope->var_count; i++) {
-			if(scope->vars[i].id == expr.ident.id) {
-				if(!scope->vars[i].declared) {
-					wyrt_diag(
-						stderr, cg->identifiers, cg->strings, &scope->tc,
-					   "Cannot use variable '%i' before it is declared at %l\n",
-				   		expr.ident.id,
-				 		&expr.com.debug
-					);		
-					*err = ERROR_UNEXPECTED_DATA;
-					goto RET;
-				}
-				ret.expr = cg->be.rvalue_from_lvalue(scope->be_vars[i]);
-				ret.type = scope->vars[i].type;
-				goto RET;
-			}
+		Symbol const *symbol = scope_lookup(scope, expr.ident.id);
+		if(!symbol) {
+			wyrt_diag(
+				stderr, cg->identifiers, cg->strings, scope->tc,
+				"Undeclared variable '%i' at %l\n",
+				expr.ident.id,
+				&expr.com.debug
+			);
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
 		}
-		for(size_t i = 0; i < scope->param_count; i++) {
-			if(scope->params[i].id == expr.ident.id) {
-				ret.expr = scope->be_params[i];
-				ret.type = scope->params[i].type;
-				goto RET;
-			}	
+		if(symbol->param) {
+			ret.expr = symbol->be_param;
+			ret.type = symbol->var.type;
+			goto RET;
 		}
-		wyrt_diag(
-			stderr, cg->identifiers, cg->strings, &scope->tc,
-			"Undeclared variable '%i' at %l\n",
-			expr.ident.id,
-			&expr.com.debug
-		);
-		*err = ERROR_UNEXPECTED_DATA;
+		if(!symbol->var.declared) {
+			wyrt_diag(
+				stderr, cg->identifiers, cg->strings, scope->tc,
+			   "Cannot use variable '%i' before it is declared at %l\n",
+		   		expr.ident.id,
+		 		&expr.com.debug
+			);		
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
+		}
+		ret.expr = BE(rvalue_from_lvalue)(symbol->be_var);
+		ret.type = symbol->var.type;
 		goto RET;
 	} break;
 
@@ -495,8 +620,8 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			if(*err) goto RET;
 		}
 
-		bool rhs_compatible = types_are_compatible(&scope->tc, rhs.type, lhs.type);
-		bool lhs_compatible = types_are_compatible(&scope->tc, lhs.type, rhs.type);
+		bool rhs_compatible = types_are_compatible(scope->tc, rhs.type, lhs.type);
+		bool lhs_compatible = types_are_compatible(scope->tc, lhs.type, rhs.type);
 
 		if(expected.type != TYPE_PAUL_CONST
 			&& expected.type != TYPE_PAUL_ABYSS
@@ -507,7 +632,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 		) {
 			if(!lhs_compatible && !rhs_compatible) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot Perform Arithmetic on Incompatible Types '%t' and '%t' at %l\n",
 					lhs.type,
 					rhs.type,
@@ -520,7 +645,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 
 		if(!type_is_arithmetic(lhs.type)) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Perform Arithmetic on non-arithmetic Type '%t' at %l\n",
 				lhs.type,
 				&expr.com.debug
@@ -531,7 +656,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 
 		if(!type_is_arithmetic(rhs.type)) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Perform Arithmetic on non-arithmetic Type '%t' at %l\n",
 				rhs.type,
 				&expr.com.debug
@@ -552,22 +677,22 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			} else {
 				ret.type = lhs.type;
 			}
-			rhs.expr = cg->be.new_cast(
+			rhs.expr = BE(new_cast)(
 				cg->ctx,
 				&expr.com.debug,
 				rhs.expr,
 				lhs.type,
-				&scope->tc,
+				scope->tc,
 				err
 			);
 			if(*err) goto RET;
 
-			ret.expr = cg->be.rvalue_binary_op(
+			ret.expr = BE(rvalue_binary_op)(
 				cg->ctx,
 				&expr.com.debug,
 				expr.type,
 				ret.type,
-				&scope->tc,
+				scope->tc,
 				lhs.expr,
 				rhs.expr,
 				err
@@ -590,7 +715,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			) {
 				if(rhs.type.type < TYPE_PRIMITIVE_U8 || rhs.type.type > TYPE_PRIMITIVE_S64) {
 					wyrt_diag(
-						stderr, cg->identifiers, cg->strings, &scope->tc,
+						stderr, cg->identifiers, cg->strings, scope->tc,
 						"Cannot add two pointers '%t' and '%t' together at %l\n",
 						lhs.type,
 						rhs.type,
@@ -606,12 +731,12 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 				if(rhs.type.type >= TYPE_PRIMITIVE_U8 && rhs.type.type <= TYPE_PRIMITIVE_U64) {
 					sign = rhs.type;
 					sign.type += TYPE_PRIMITIVE_S8 - TYPE_PRIMITIVE_U8;
-					offset = cg->be.new_cast(
+					offset = BE(new_cast)(
 						cg->ctx,
 						&expr.com.debug,
 						offset,
 						sign,
-						&scope->tc,
+						scope->tc,
 						err
 					);
 					if(*err) goto RET;
@@ -626,19 +751,19 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 				if(lhs.type.type >= TYPE_PRIMITIVE_U8 && lhs.type.type <= TYPE_PRIMITIVE_U64) {
 					sign = lhs.type;
 					sign.type += TYPE_PRIMITIVE_S8 - TYPE_PRIMITIVE_U8;
-					offset = cg->be.new_cast(
+					offset = BE(new_cast)(
 						cg->ctx,
 						&expr.com.debug,
 						offset,
 						sign,
-						&scope->tc,
+						scope->tc,
 						err
 					);
 					if(*err) goto RET;
 				}
 			} else {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot get pointer from arithmetic between non-pointer types '%t' and '%t' at %l\n",
 					lhs.type,
 					rhs.type,
@@ -652,15 +777,15 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			case AST_ADD:
 				break;
 			case AST_SUB: {
-				WyrtRvalue neg = cg->be.rvalue_int_lit(cg->ctx, -1, sign.type, err);
+				WyrtRvalue neg = BE(rvalue_int_lit)(cg->ctx, -1, sign.type, err);
 				if(*err) goto RET;
 
-				offset = cg->be.rvalue_binary_op(
+				offset = BE(rvalue_binary_op)(
 					cg->ctx,
 					&expr.com.debug,
 					AST_MUL,
 					sign,
-					&scope->tc,
+					scope->tc,
 					offset,
 					neg,
 					err
@@ -669,7 +794,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			} break;
 			default:
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Illegal operation between pointer type '%t' and integer type '%t' at %l\n",
 					lhs.type,
 					rhs.type,
@@ -679,7 +804,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 				goto RET;
 			}
 
-			WyrtLvalue elem = cg->be.lvalue_subscript(
+			WyrtLvalue elem = BE(lvalue_subscript)(
 				cg->ctx,
 				&expr.com.debug,
 				ptr,
@@ -688,7 +813,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			);
 			if(*err) goto RET;
 
-			ret.expr = cg->be.rvalue_address(cg->ctx, &expr.com.debug, elem, err);
+			ret.expr = BE(rvalue_address)(cg->ctx, &expr.com.debug, elem, err);
 			if(*err) goto RET;
 		} else {
 			if(expr.type == AST_COMP_EQ
@@ -702,22 +827,22 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			} else {
 				ret.type = rhs.type;
 			}
-			lhs.expr = cg->be.new_cast(
+			lhs.expr = BE(new_cast)(
 				cg->ctx,
 				&expr.com.debug,
 				lhs.expr,
 				rhs.type,
-				&scope->tc,
+				scope->tc,
 				err
 			);
 			if(*err) goto RET;
 
-			ret.expr = cg->be.rvalue_binary_op(
+			ret.expr = BE(rvalue_binary_op)(
 				cg->ctx,
 				&expr.com.debug,
 				expr.type,
 				ret.type,
-				&scope->tc,
+				scope->tc,
 				lhs.expr,
 				rhs.expr,
 				err
@@ -737,7 +862,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 				|| val.type.type == TYPE_POINTER_VAR
 		)) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Perform Arithmetic on non-arithmetic Type '%t' at %l\n",
 				val.type,
 				&expr.com.debug
@@ -746,7 +871,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			goto RET;
 		}
 
-		ret.expr = cg->be.rvalue_unary_op(
+		ret.expr = BE(rvalue_unary_op)(
 			cg->ctx,
 			&expr.com.debug,
 			expr.type,
@@ -765,7 +890,8 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 		break;
 
 	case AST_DEREF: {
-		Type ptr_type = types_get_ptr(&scope->tc, expected, TYPE_POINTER_CONST);
+		Type ptr_type = types_get_ptr(scope->tc, expected, TYPE_POINTER_CONST, err);
+		if(*err) goto RET;
 		Expr ptr = gen_expr(cg, ptr_type, index + expr.unary_op.val, scope, err);
 		if(*err) goto RET;
 
@@ -778,7 +904,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 				|| ptr.type.type == TYPE_PAUL_ABYSS
 			) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot read data from Abyssal Pointer at %l\n",
 					&expr.com.debug
 				);
@@ -786,7 +912,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 				goto RET;
 			}
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Dereference non-Pointer Type '%t' at %l\n",
 				ptr.type,
 				&expr.com.debug
@@ -795,28 +921,30 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			goto RET;
 		}
 		
-		WyrtLvalue *lval = cg->be.lvalue_deref(cg->ctx, &expr.com.debug, ptr.expr, err);
+		WyrtLvalue *lval = BE(lvalue_deref)(cg->ctx, &expr.com.debug, ptr.expr, err);
 		if(*err) goto RET;
-		ret.expr = cg->be.rvalue_from_lvalue(lval);
-		ret.type = scope->tc.types[ptr.type.pointer.base];
+		ret.expr = BE(rvalue_from_lvalue)(lval);
+		ret.type = scope->tc->types[ptr.type.pointer.base];
 	} break;
 	
 	case AST_ADDR: {
 		Lvalue val = gen_lvalue(cg, index + expr.unary_op.val, scope, err);
 		if(*err) goto RET;
 
-		ret.expr = cg->be.rvalue_address(cg->ctx, &expr.com.debug, val.lvalue, err);
+		ret.expr = BE(rvalue_address)(cg->ctx, &expr.com.debug, val.lvalue, err);
 		if(*err) goto RET;
 
 		ret.type = types_get_ptr(
-			&scope->tc,
+			scope->tc,
 			val.type,
-			val.read ? (val.mut ? TYPE_POINTER_VAR : TYPE_POINTER_CONST) : TYPE_POINTER_ABYSS
+			val.read ? (val.mut ? TYPE_POINTER_VAR : TYPE_POINTER_CONST) : TYPE_POINTER_ABYSS,
+			err
 		);
+		if(*err) goto RET;
 	} break;
 
 	case AST_CHAR_LIT: {
-		ret.expr = cg->be.rvalue_int_lit(cg->ctx, expr.char_lit.val, TYPE_PRIMITIVE_U8, err);
+		ret.expr = BE(rvalue_int_lit)(cg->ctx, expr.char_lit.val, TYPE_PRIMITIVE_U8, err);
 		if(*err) goto RET;
 		ret.type.type = TYPE_PRIMITIVE_U8;
 	} break;
@@ -824,7 +952,7 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 	case AST_ARRAY_LIT: {
 		if(expected.type != TYPE_ARRAY) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Coerce Array Literal to non-Array Type '%t' at %l\n",
 				expected,
 				&expr.com.debug
@@ -835,9 +963,9 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 
 		if(expected.array.len && expected.array.len != expr.array_lit.elem_count) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Coerce Array Literal of Length %z to Array of Length %z at %l\n",
-				expr.array_lit.elem_count,
+				(size_t) expr.array_lit.elem_count,
 				expected.array.len,
 				&expr.com.debug
 			);
@@ -845,10 +973,10 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			goto RET;
 		}
 
-		Type elem_type = scope->tc.types[expected.array.base];
+		Type elem_type = scope->tc->types[expected.array.base];
 
-		WyrtRvalue *elems = malloc(sizeof(*elems) * expr.array_lit.elem_count);
-		CHECK_MALLOC(elems);
+		WyrtRvalue *elems = arena_alloc(&cg->fn_arena, sizeof(*elems) * expr.array_lit.elem_count, err);
+		if(*err) goto RET;
 
 		size_t elem_index = index + expr.array_lit.elems;
 		for(size_t i = 0; i < expr.array_lit.elem_count; i++) {
@@ -859,15 +987,15 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 				scope,
 				err
 			).expr;
-			if(*err) goto ARRAY_LIT_CLEAN;
-			elem_index += cg->nodes[elem_index].com.next;
+			if(*err) goto RET;
+			elem_index += cg->ast->next[elem_index];
 		}
 
-		ret.expr = cg->be.rvalue_array_lit(
+		ret.expr = BE(rvalue_array_lit)(
 			cg->ctx,
 			&expr.com.debug,
 			expected,
-			&scope->tc,
+			scope->tc,
 			elems,
 			expr.array_lit.elem_count,
 			err
@@ -881,10 +1009,6 @@ static Expr gen_expr(CodeGen *cg, Type expected, size_t index, Scope *scope, Err
 			   	.len = expr.array_lit.elem_count	
 			},
 		};
-
-ARRAY_LIT_CLEAN:
-		free(elems);
-		goto RET;
 	} break;
 
 	case AST_SUBSCRIPT: {
@@ -896,9 +1020,9 @@ ARRAY_LIT_CLEAN:
 			err
 		);
 		if(*err) goto RET;
-		if(!type_is_subscriptable(&scope->tc, arr.type)) {
+		if(!type_is_subscriptable(scope->tc, arr.type)) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Subscript non-Subscriptable Type '%t' at %l\n",
 				arr.type,
 				&expr.com.debug
@@ -910,7 +1034,7 @@ ARRAY_LIT_CLEAN:
 			|| arr.type.type == TYPE_POINTER_ABYSS
 		) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Read Data from abyssal Pointer at %l\n",
 				&expr.com.debug
 			);
@@ -930,12 +1054,12 @@ ARRAY_LIT_CLEAN:
 		if(arr.type.type == TYPE_SLICE_CONST
 			|| arr.type.type == TYPE_SLICE_VAR
 		) {
-			arr.expr = cg->be.rvalue_field(
+			arr.expr = BE(rvalue_field)(
 				cg->ctx,
 				&expr.com.debug,
 				arr.expr,
 				arr.type,
-				&scope->tc,
+				scope->tc,
 				0,
 				err
 			);
@@ -943,7 +1067,7 @@ ARRAY_LIT_CLEAN:
 			arr.type.type -= TYPE_SLICE_CONST - TYPE_POINTER_CONST;
 		}
 
-		WyrtLvalue subs = cg->be.lvalue_subscript(
+		WyrtLvalue subs = BE(lvalue_subscript)(
 			cg->ctx,
 			&expr.com.debug,
 			arr.expr,
@@ -952,14 +1076,14 @@ ARRAY_LIT_CLEAN:
 		);
 		if(*err) goto RET;
 
-		ret.expr = cg->be.rvalue_from_lvalue(subs);
-		ret.type = scope->tc.types[arr.type.pointer.base];
+		ret.expr = BE(rvalue_from_lvalue)(subs);
+		ret.type = scope->tc->types[arr.type.pointer.base];
 	} break;
 
 	case AST_STRUCT_LIT: {
 		if(expected.type != TYPE_STRUCT) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Coerce Struct-Literal to non-struct Type '%t' at %l\n",
 				expected,
 				&expr.com.debug
@@ -971,7 +1095,7 @@ ARRAY_LIT_CLEAN:
 		if(!expr.struct_lit.parent_id) {
 			if(!expected.type) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot Instantiate Anonymous Struct Literal without any Destination Type "
 					"at %l\n",
 					&expr.com.debug
@@ -983,10 +1107,10 @@ ARRAY_LIT_CLEAN:
 
 			if(expr.struct_lit.member_count > expected.struct_type.member_count) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot Coerce Struct-Literal with %z members to struct Type '%t' "
 					"with %z members at %l\n",
-					expr.struct_lit.member_count,
+					(size_t) expr.struct_lit.member_count,
 					expected,
 					expected.struct_type.member_count,
 					&expr.com.debug
@@ -995,10 +1119,10 @@ ARRAY_LIT_CLEAN:
 				goto RET;
 			}
 		} else {
-			size_t named = type_lookup_id(&scope->tc, expr.struct_lit.parent_id);
-			if(named == SIZE_MAX) {
+			TypeId named = type_lookup_id(scope->tc, expr.struct_lit.parent_id);
+			if(named == TYPE_ID_NONE) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Could not find a type called '%i' at %l\n",
 					expr.struct_lit.parent_id,
 					&expr.com.debug
@@ -1007,11 +1131,11 @@ ARRAY_LIT_CLEAN:
 				goto RET;
 			}
 
-			if(scope->tc.types[named].type != TYPE_STRUCT) {
+			if(scope->tc->types[named].type != TYPE_STRUCT) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot create Struct Literal of non-Struct Type '%t' at %l\n",
-					named,
+					scope->tc->types[named],
 					&expr.com.debug
 				);
 				*err = ERROR_UNEXPECTED_DATA;
@@ -1019,14 +1143,14 @@ ARRAY_LIT_CLEAN:
 			}
 
 			if(maybe_typedef.type == TYPE_TYPEDEF) {
-				size_t name = maybe_typedef.typdef.id;
+				Id name = maybe_typedef.typdef.id;
 				while(expr.struct_lit.parent_id != maybe_typedef.typdef.id) {
-					maybe_typedef = scope->tc.types[maybe_typedef.typdef.backing];
+					maybe_typedef = scope->tc->types[maybe_typedef.typdef.backing];
 					if(maybe_typedef.type != TYPE_TYPEDEF) break;
 				}	
 				if(maybe_typedef.type != TYPE_TYPEDEF) {
 					wyrt_diag(
-						stderr, cg->identifiers, cg->strings, &scope->tc,
+						stderr, cg->identifiers, cg->strings, scope->tc,
 						"Cannot Coerce Named Struct Literal ('%i') into "
 						"different name ('%i') at %l\n",
 						expr.struct_lit.parent_id,
@@ -1038,11 +1162,11 @@ ARRAY_LIT_CLEAN:
 				}
 			}
 
-			if(!types_are_compatible(&scope->tc, maybe_typedef, scope->tc.types[named])) {
+			if(!types_are_compatible(scope->tc, maybe_typedef, scope->tc->types[named])) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Struct Literal of type '%t' cannot be coerced into Struct Type '%t' at %l\n",
-					scope->tc.types[named],
+					scope->tc->types[named],
 					maybe_typedef,
 					&expr.com.debug
 				);
@@ -1051,29 +1175,27 @@ ARRAY_LIT_CLEAN:
 			}
 		}
 
-		WyrtRvalue *members = malloc(sizeof(*members) * expected.struct_type.member_count);
-		CHECK_MALLOC(members);
+		WyrtRvalue *members = arena_alloc(&cg->fn_arena, sizeof(*members) * expected.struct_type.member_count, err);
+		if(*err) goto RET;
+		memset(members, 0, sizeof(*members) * expected.struct_type.member_count);
 
-		AstNode const *member_name = &cg->nodes[index + expr.struct_lit.member_names];
+		size_t member_name = index + expr.struct_lit.member_names;
 		size_t member_value_index = index + expr.struct_lit.member_values;
 		for(size_t i = 0; i < expr.struct_lit.member_count; i++) {
 			bool found = false;
-			assert(member_name->type == AST_IDENT);
-			size_t id = member_name->ident.id;
+			assert(cg->ast->types[member_name] == AST_IDENT);
+			Id id = ast_get(cg->ast, member_name).ident.id;
 
 			for(size_t j = 0; j < expected.struct_type.member_count; j++) {
 				if(expected.struct_type.member_name_ids[j] == id) {
 					members[j] = gen_expr(
 						cg,
-						scope->tc.types[expected.struct_type.member_types[i]],
+						scope->tc->types[expected.struct_type.member_types[i]],
 						member_value_index,
 						scope,
 						err
 					).expr;
-					if(*err) {
-						free(members);
-						goto RET;
-					}
+					if(*err) goto RET;
 					found = true;
 					break;
 				}
@@ -1081,49 +1203,44 @@ ARRAY_LIT_CLEAN:
 
 			if(!found) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"No member '%i' in Struct-Type '%t' at %l\n",
 					id,
-					expected
+					expected,
+					&expr.com.debug
 				);
 				*err = ERROR_UNEXPECTED_DATA;
-				free(members);
 				goto RET;
 			}
 
-			member_value_index += cg->nodes[member_value_index].com.next;
-			member_name += member_name->com.next;
+			member_value_index += cg->ast->next[member_value_index];
+			member_name += cg->ast->next[member_name];
 		}
 
 		for(size_t i = 0; i < expected.struct_type.member_count; i++) {
 			if(!members[i]) {
-				members[i] = cg->be.rvalue_null(
+				members[i] = BE(rvalue_null)(
 					cg->ctx,
-					scope->tc.types[expected.struct_type.member_types[i]],
-					&scope->tc,
+					scope->tc->types[expected.struct_type.member_types[i]],
+					scope->tc,
 					err
 				);
 
-				if(*err) {
-					free(members);
-					goto RET;
-				}
+				if(*err) goto RET;
 			}
 		}
 
-		ret.expr = cg->be.rvalue_struct_lit(
+		ret.expr = BE(rvalue_struct_lit)(
 			cg->ctx,
 			&expr.com.debug,
 			expected,
-			&scope->tc,
+			scope->tc,
 			members,
 			expected.struct_type.member_count,
 			err
 		);
 		if(*err) goto RET;
 		ret.type = expected;
-
-		free(members);
 	} break;
 
 	case AST_STRUCT_ACCESS: {
@@ -1141,24 +1258,24 @@ ARRAY_LIT_CLEAN:
 		case TYPE_STRUCT: {
 			for(size_t i = 0; i < parent.type.struct_type.member_count; i++) {
 				if(parent.type.struct_type.member_name_ids[i] == expr.struct_access.member_id) {
-					ret.expr = cg->be.rvalue_field(
+					ret.expr = BE(rvalue_field)(
 						cg->ctx,
 						&expr.com.debug,
 						parent.expr,
 						parent.type,
-						&scope->tc,
+						scope->tc,
 						i,
 						err
 					);
 					if(*err) goto RET;
-					ret.type = scope->tc.types[parent.type.struct_type.member_types[i]];
+					ret.type = scope->tc->types[parent.type.struct_type.member_types[i]];
 					break;
 				}
 			}
 
 			if(!ret.expr) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"No Member '%i' in struct '%t' at %l\n",
 					expr.struct_access.member_id,
 					parent.type,
@@ -1173,12 +1290,12 @@ ARRAY_LIT_CLEAN:
 		case TYPE_SLICE_ABYSS:
 		case TYPE_SLICE_VAR:
 			if(expr.struct_access.member_id == ID_BUILTIN_PTR) {
-				ret.expr = cg->be.rvalue_field(
+				ret.expr = BE(rvalue_field)(
 					cg->ctx,
 					&expr.com.debug,
 					parent.expr,
 					parent.type,
-					&scope->tc,
+					scope->tc,
 					0,
 					err
 				);
@@ -1186,12 +1303,12 @@ ARRAY_LIT_CLEAN:
 				ret.type = parent.type;
 				ret.type.type += TYPE_PAUL_CONST - TYPE_SLICE_CONST;
 			} else if(expr.struct_access.member_id == ID_BUILTIN_LEN) {
-				ret.expr = cg->be.rvalue_field(
+				ret.expr = BE(rvalue_field)(
 					cg->ctx,
 					&expr.com.debug,
 					parent.expr,
 					parent.type,
-					&scope->tc,
+					scope->tc,
 					0,
 					err
 				);
@@ -1199,7 +1316,7 @@ ARRAY_LIT_CLEAN:
 				ret.type.type = TYPE_PRIMITIVE_U64;
 			} else {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"No Member '%i' in slice at %l\n",
 					expr.struct_access.member_id,
 					&expr.com.debug
@@ -1211,7 +1328,7 @@ ARRAY_LIT_CLEAN:
 
 		default:
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Access Member of non-struct and non-slice Type %t at %l\n",
 				parent.type,
 				&expr.com.debug
@@ -1224,30 +1341,26 @@ ARRAY_LIT_CLEAN:
 
 	case AST_STRING_LIT:
 	case AST_ZSTRING_LIT: {
-		ret.type = types_get_ptr(&scope->tc, (Type) {.type = TYPE_PRIMITIVE_U8}, TYPE_SLICE_CONST);
+		ret.type = types_get_ptr(scope->tc, (Type) {.type = TYPE_PRIMITIVE_U8}, TYPE_SLICE_CONST, err);
+		if(*err) goto RET;
 
 		WyrtRvalue vals[2];
-		vals[0] = cg->be.rvalue_cstring_lit(
-			cg->ctx,
-			&expr.com.debug,
-			cg->strings[expr.string_lit.id],
-			err
-		);
+		vals[0] = gen_string_lit(cg, expr.string_lit.id, &expr.com.debug, err);
 		if(*err) goto RET;
 
-		vals[1] = cg->be.rvalue_int_lit(
+		vals[1] = BE(rvalue_int_lit)(
 			cg->ctx,
-			strlen(cg->strings[expr.string_lit.id]),
+			intern_len(cg->strings, expr.string_lit.id),
 			TYPE_PRIMITIVE_U64,
 			err
 		);
 		if(*err) goto RET;
 
-		ret.expr = cg->be.rvalue_struct_lit(
+		ret.expr = BE(rvalue_struct_lit)(
 			cg->ctx,
 			&expr.com.debug,
 			ret.type,
-			&scope->tc,
+			scope->tc,
 			vals,
 			2,
 			err
@@ -1256,15 +1369,11 @@ ARRAY_LIT_CLEAN:
 	} break;
 
 	case AST_CSTRING_LIT: {
-		ret.type = types_get_ptr(&scope->tc, (Type) {.type = TYPE_PRIMITIVE_U8}, TYPE_PAUL_CONST);
+		ret.type = types_get_ptr(scope->tc, (Type) {.type = TYPE_PRIMITIVE_U8}, TYPE_PAUL_CONST, err);
+		if(*err) goto RET;
 
-		ret.expr = cg->be.rvalue_cstring_lit(
-			cg->ctx,
-			&expr.com.debug,
-			cg->strings[expr.string_lit.id],
-			err
-		);
-		if(*err) goto RET;	
+		ret.expr = gen_string_lit(cg, expr.string_lit.id, &expr.com.debug, err);
+		if(*err) goto RET;
 	} break;
 
 	case AST_ARROW: {
@@ -1281,7 +1390,7 @@ ARRAY_LIT_CLEAN:
 			&& parent.type.type != TYPE_POINTER_VAR
 		) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Dereference non-pointer Type '%t' at %l\n",
 				parent.type,
 				&expr.com.debug
@@ -1290,12 +1399,12 @@ ARRAY_LIT_CLEAN:
 			goto RET;
 		}
 
-		Type parent_struct = scope->tc.types[parent.type.pointer.base];
-		parent_struct = type_resolve(&scope->tc, parent_struct);
+		Type parent_struct = scope->tc->types[parent.type.pointer.base];
+		parent_struct = type_resolve(scope->tc, parent_struct);
 
 		if(parent_struct.type != TYPE_STRUCT) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Access Member of non-struct Type '%t' at %l\n",
 				parent_struct,
 				&expr.com.debug
@@ -1307,23 +1416,23 @@ ARRAY_LIT_CLEAN:
 		ret.expr = NULL;
 		for(size_t i = 0; i < parent_struct.struct_type.member_count; i++) {
 			if(parent_struct.struct_type.member_name_ids[i] == expr.struct_access.member_id) {
-				WyrtLvalue *lval = cg->be.lvalue_deref_field(
+				WyrtLvalue *lval = BE(lvalue_deref_field)(
 					cg->ctx,
 					&expr.com.debug,
 					parent.expr,
 					parent_struct,
-					&scope->tc,
+					scope->tc,
 					i,
 					err
 				);
 				if(*err) goto RET;
-				ret.expr = cg->be.rvalue_from_lvalue(lval);
-				ret.type = scope->tc.types[parent_struct.struct_type.member_types[i]];
+				ret.expr = BE(rvalue_from_lvalue)(lval);
+				ret.type = scope->tc->types[parent_struct.struct_type.member_types[i]];
 			}
 		}
 		if(!ret.expr) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"No Members '%i' in struct '%t' at %l\n",
 				expr.struct_access.member_id,
 				parent.type,
@@ -1336,7 +1445,7 @@ ARRAY_LIT_CLEAN:
 
 	default:
 		wyrt_diag(
-			stderr, cg->identifiers, cg->strings, &scope->tc,
+			stderr, cg->identifiers, cg->strings, scope->tc,
 			"Expected Expression at %l\n",
 			&expr.com.debug
 		);
@@ -1347,12 +1456,12 @@ ARRAY_LIT_CLEAN:
 
 RET:
 	if(!*err) {
-		types_register_nexist(&scope->tc, ret.type, err);
+		types_register(scope->tc, ret.type, err);
 		if(*err) goto RET_FAIL;
-		ret.type = type_resolve(&scope->tc, ret.type);
-		if(expected.type && !types_are_compatible(&scope->tc, ret.type, expected)) {
+		ret.type = type_resolve(scope->tc, ret.type);
+		if(expected.type && !types_are_compatible(scope->tc, ret.type, expected)) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Coerce between Expression Type '%t' and Expected '%t' at %l\n",
 				ret.type,
 				expected,
@@ -1361,7 +1470,7 @@ RET:
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET_FAIL;
 		} else if(expected.type && !types_are_equal(ret.type, expected)) {
-			ret.expr = gen_cast(cg, ret, expected, &scope->tc, &expr.com.debug, err);
+			ret.expr = gen_cast(cg, ret, expected, scope->tc, &expr.com.debug, err);
 			ret.type = expected;
 		}
 	}
@@ -1372,22 +1481,12 @@ RET_FAIL:
 static Expr gen_fn_call(CodeGen *cg, size_t index, Scope *scope, Error *err)
 {
 	Expr ret;
-	DynArr args;
-	dynarr_init(&args, sizeof(WyrtRvalue));
+	WyrtRvalue *args;
+	size_t be_arg_count = 0;
 
-	AstNode expr = cg->nodes[index];
-	bool found = false;
-	FnSig sig;
-	WyrtFunction fn;
-	for(size_t i = 0; i < cg->fn_count; i++) {
-		if(cg->fn_sigs[i].id == expr.fn_call.fn_id) {
-			found = true;
-			sig = cg->fn_sigs[i];
-			fn = cg->fns[i]; 
-			break;
-		}
-	}
-	if(!found) {
+	AstNode expr = ast_get(cg->ast, index);
+	size_t fn_index = codegen_find_fn(cg, expr.fn_call.fn_id);
+	if(fn_index == SIZE_MAX) {
 		wyrt_diag(
 			stderr, cg->identifiers, NULL, NULL,
 			"No Function '%i' at %l\n",
@@ -1397,21 +1496,27 @@ static Expr gen_fn_call(CodeGen *cg, size_t index, Scope *scope, Error *err)
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
 	}
+	FnSig sig = cg->fn_sigs[fn_index];
+	WyrtFunction fn = cg->fns[fn_index];
 	
 	ret.type = sig.ret;
 
 	if(expr.fn_call.arg_count != sig.arg_count) {
 		wyrt_diag(
-			stderr, cg->identifiers, cg->strings, &scope->tc,
+			stderr, cg->identifiers, cg->strings, scope->tc,
 			"Expected %z arguments to function call, found %z at %l\n",
 			sig.arg_count,
-			expr.fn_call.arg_count,
+			(size_t) expr.fn_call.arg_count,
 			&expr.com.debug
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;	
 	}
 
+	// Slices are passed as two arguments
+	args = arena_alloc(&cg->fn_arena, 2 * sig.arg_count * sizeof(*args), err);
+	if(*err) goto RET;
+
 	size_t arg_idx = index + expr.fn_call.args;
 	for(size_t i = 0; i < sig.arg_count; i++) {
 		Expr arg = gen_expr(cg, sig.args[i], arg_idx, scope, err);
@@ -1421,53 +1526,48 @@ static Expr gen_fn_call(CodeGen *cg, size_t index, Scope *scope, Error *err)
 			|| arg.type.type == TYPE_SLICE_ABYSS
 			|| arg.type.type == TYPE_SLICE_VAR
 		) {
-			WyrtRvalue ptr = cg->be.rvalue_field(
+			WyrtRvalue ptr = BE(rvalue_field)(
 				cg->ctx,
 				&expr.com.debug,
 				arg.expr,
 				arg.type,
-				&scope->tc,
+				scope->tc,
 				0,
 				err
 			);
 			if(*err) goto RET;
 
-			WyrtRvalue len = cg->be.rvalue_field(
+			WyrtRvalue len = BE(rvalue_field)(
 				cg->ctx,
 				&expr.com.debug,
 				arg.expr,
 				arg.type,
-				&scope->tc,
+				scope->tc,
 				1,
 				err
 			);
 			if(*err) goto RET;
 			
-			dynarr_push(&args, &ptr, err);
-			if(*err) goto RET;
-
-			dynarr_push(&args, &len, err);
-			if(*err) goto RET;
+			args[be_arg_count++] = ptr;
+			args[be_arg_count++] = len;
 		} else {
-			dynarr_push(&args, &arg.expr, err);
-			if(*err) goto RET;
+			args[be_arg_count++] = arg.expr;
 		}
 
-		arg_idx += cg->nodes[arg_idx].com.next;
+		arg_idx += cg->ast->next[arg_idx];
 	}
 
-	ret.expr = cg->be.rvalue_fn_call(
+	ret.expr = BE(rvalue_fn_call)(
 		cg->ctx,
 		&expr.com.debug,
 		fn,
-		args.data,
-		args.count,
+		args,
+		be_arg_count,
 		err
 	);
 	if(*err) goto RET;
 
 RET:
-	dynarr_clean(&args);
 	return ret;
 }
 
@@ -1482,11 +1582,11 @@ static WyrtLvalue gen_var_decl(
 {
 	WyrtLvalue be_var = NULL;
 
-	AstNode statement = cg->nodes[index];
+	AstNode statement = ast_get(cg->ast, index);
 
 	Type type = type_from_ast(
-		&scope->tc,
-		cg->nodes,
+		scope->tc,
+		cg->ast,
 		index + statement.var_decl.data_type,
 		err
 	);
@@ -1496,7 +1596,7 @@ static WyrtLvalue gen_var_decl(
 		if(type.array.len == 0) {
 			if(!statement.var_decl.initial) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot Infer Length of Array '%i' when no Initializer is present at %l\n",
 					statement.var_decl.id,
 					&statement.com.debug
@@ -1505,9 +1605,9 @@ static WyrtLvalue gen_var_decl(
 				goto RET;
 			}
 
-			if(cg->nodes[index + statement.var_decl.initial].type != AST_ARRAY_LIT) {
+			if(cg->ast->types[index + statement.var_decl.initial] != AST_ARRAY_LIT) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope->tc,
+					stderr, cg->identifiers, cg->strings, scope->tc,
 					"Cannot Initialize Array '%i' with Value that is not an array literal at %l\n",
 					statement.var_decl.id,
 					&statement.com.debug
@@ -1516,7 +1616,7 @@ static WyrtLvalue gen_var_decl(
 				goto RET;
 			}
 
-			type.array.len = cg->nodes[index + statement.var_decl.initial].array_lit.elem_count;
+			type.array.len = ast_get(cg->ast, index + statement.var_decl.initial).array_lit.elem_count;
 		}
 	}
 
@@ -1527,12 +1627,12 @@ static WyrtLvalue gen_var_decl(
 		.declared = false,
 	};
 
-	be_var = cg->be.block_new_variable(
+	be_var = BE(block_new_variable)(
 		cg->ctx,
 		&statement.com.debug,
 		block,
 		type,
-		&scope->tc,
+		scope->tc,
 		id_get(cg->identifiers, statement.var_decl.id),
 		err
 	);
@@ -1545,38 +1645,36 @@ RET:
 static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 {
 	Lvalue ret = { 0 };
-	AstNode var = cg->nodes[index];
+	AstNode var = ast_get(cg->ast, index);
 
 	switch(var.type) {
 	case AST_IDENT: {
-		for(size_t i = 0; i < scope->var_count; i++) {
-			if(scope->vars[i].id == var.ident.id) {
-				if(!scope->vars[i].declared) {
-					wyrt_diag(
-						stderr, cg->identifiers, cg->strings, &scope->tc,
-						"Cannot Assign to Variable '%i' at %l before it is Declared!\n",
-						var.ident.id,
-						&var.com.debug
-					);
-					*err = ERROR_UNEXPECTED_DATA;
-					goto RET;
-				}
-
-				ret.type = scope->vars[i].type;
-				ret.lvalue = scope->be_vars[i];
-				ret.mut = scope->vars[i].mut;
-				ret.read = true;
-				goto RET;
-			}
+		Symbol const *symbol = scope_lookup(scope, var.ident.id);
+		if(!symbol || symbol->param) {
+			wyrt_diag(
+				stderr, cg->identifiers, cg->strings, scope->tc,
+				"Cannot Assign to Undeclared Variable '%i' at %l\n",
+				var.ident.id,
+				&var.com.debug
+			);
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
+		}
+		if(!symbol->var.declared) {
+			wyrt_diag(
+				stderr, cg->identifiers, cg->strings, scope->tc,
+				"Cannot Assign to Variable '%i' at %l before it is Declared!\n",
+				var.ident.id,
+				&var.com.debug
+			);
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
 		}
 
-		wyrt_diag(
-			stderr, cg->identifiers, cg->strings, &scope->tc,
-			"Cannot Assign to Undeclared Variable '%i' at %l\n",
-			var.ident.id,
-			&var.com.debug
-		);
-		*err = ERROR_UNEXPECTED_DATA;
+		ret.type = symbol->var.type;
+		ret.lvalue = symbol->be_var;
+		ret.mut = symbol->var.mut;
+		ret.read = true;
 		goto RET;
 	} break;	
 
@@ -1588,7 +1686,7 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 			&& ptr.type.type != TYPE_POINTER_VAR
 		) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Dereference non-Pointer Type '%t' at %l\n",
 				ptr.type,
 				&var.com.debug
@@ -1597,14 +1695,14 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 			goto RET;
 		}
 
-		ret.lvalue = cg->be.lvalue_deref(
+		ret.lvalue = BE(lvalue_deref)(
 			cg->ctx,
 			&var.com.debug,
 			ptr.expr,
 			err
 		);
 		if(*err) goto RET;
-		ret.type = scope->tc.types[ptr.type.pointer.base];
+		ret.type = scope->tc->types[ptr.type.pointer.base];
 		ret.mut = !(ptr.type.type == TYPE_POINTER_CONST);
 		ret.read = !(ptr.type.type == TYPE_POINTER_ABYSS);
 	} break;
@@ -1620,7 +1718,7 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 
 		if(parent.type.type != TYPE_STRUCT) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Access Member in non-struct Type '%t' at %l\n",
 				parent.type,
 				&var.com.debug
@@ -1633,14 +1731,14 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 		for(size_t i = 0; i < parent.type.struct_type.member_count; i++) {
 			if(parent.type.struct_type.member_name_ids[i] == var.struct_access.member_id) {
 				field = i;
-				ret.type = scope->tc.types[parent.type.struct_type.member_types[i]];
+				ret.type = scope->tc->types[parent.type.struct_type.member_types[i]];
 				break;
 			}
 		}
 
 		if(field == SIZE_MAX) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"No Member '%i' in struct '%t' at %l\n",
 				var.struct_access.member_id,
 				parent.type,
@@ -1650,12 +1748,12 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 			goto RET;
 		}
 
-		ret.lvalue = cg->be.lvalue_field(
+		ret.lvalue = BE(lvalue_field)(
 			cg->ctx,
 			&var.com.debug,
 			parent.lvalue,
 			parent.type,
-			&scope->tc,
+			scope->tc,
 			field,
 			err
 		);
@@ -1674,9 +1772,9 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 		);
 		if(*err) goto RET;
 
-		if(!type_is_subscriptable(&scope->tc, arr.type)) {
+		if(!type_is_subscriptable(scope->tc, arr.type)) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot subscript non-Subscriptable Type '%t' at %l\n",
 				arr.type,
 				&var.com.debug
@@ -1694,7 +1792,7 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 		);
 		if(*err) goto RET;
 
-		ret.lvalue = cg->be.lvalue_subscript(
+		ret.lvalue = BE(lvalue_subscript)(
 			cg->ctx,
 			&var.com.debug,
 			arr.expr,
@@ -1727,7 +1825,7 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 		} break;
 		default: assert(0);
 		}
-		ret.type = scope->tc.types[arr.type.pointer.base];
+		ret.type = scope->tc->types[arr.type.pointer.base];
 	} break;
 
 	case AST_ARROW: {
@@ -1745,7 +1843,7 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 			&& parent.type.type != TYPE_POINTER_VAR
 		) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Dereference non-pointer Type '%t' at %l\n",
 				parent.type,
 				&var.com.debug
@@ -1754,13 +1852,13 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 			goto RET;
 		}
 
-		Type parent_struct = scope->tc.types[parent.type.pointer.base];
+		Type parent_struct = scope->tc->types[parent.type.pointer.base];
 
-		parent_struct = type_resolve(&scope->tc, parent_struct);
+		parent_struct = type_resolve(scope->tc, parent_struct);
 
 		if(parent_struct.type != TYPE_STRUCT) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"Cannot Access Member in non-struct Type '%t' at %l\n",
 				parent_struct,
 				&var.com.debug
@@ -1773,14 +1871,14 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 		for(size_t i = 0; i < parent_struct.struct_type.member_count; i++) {
 			if(parent_struct.struct_type.member_name_ids[i] == var.struct_access.member_id) {
 				field = i;
-				ret.type = scope->tc.types[parent_struct.struct_type.member_types[i]];
+				ret.type = scope->tc->types[parent_struct.struct_type.member_types[i]];
 				break;
 			}
 		}
 
 		if(field == SIZE_MAX) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope->tc,
+				stderr, cg->identifiers, cg->strings, scope->tc,
 				"No Member '%i' in struct '%t' at %l\n",
 				var.struct_access.member_id,
 				parent_struct,
@@ -1790,12 +1888,12 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 			goto RET;
 		}
 
-		ret.lvalue = cg->be.lvalue_deref_field(
+		ret.lvalue = BE(lvalue_deref_field)(
 			cg->ctx,
 			&var.com.debug,
 			parent.expr,
 			parent_struct,
-			&scope->tc,
+			scope->tc,
 			field,
 			err
 		);
@@ -1806,7 +1904,7 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 	
 	default:
 		wyrt_diag(
-			stderr, cg->identifiers, cg->strings, &scope->tc,
+			stderr, cg->identifiers, cg->strings, scope->tc,
 			"Expected Lvalue at %l\n",
 			&var.com.debug
 		);
@@ -1817,7 +1915,7 @@ static Lvalue gen_lvalue(CodeGen *cg, size_t index, Scope *scope, Error *err)
 
 RET:
 	if(!*err) {
-		types_register_nexist(&scope->tc, ret.type, err);
+		types_register(scope->tc, ret.type, err);
 		if(*err) goto RET_FAIL;
 	}
 RET_FAIL:
@@ -1847,27 +1945,20 @@ static void gen_if(
 )
 {
 	Scope new;
-	scope_init(&new, parent, err);
-	if(*err) goto RET;
+	scope_init(&new, parent);
 
-	AstNode statement = cg->nodes[index];
+	AstNode statement = ast_get(cg->ast, index);
 
 	Expr cond;
 	if(statement.if_statement.decl) {
-		new.var_count += 1;
-		new.vars = realloc(new.vars, sizeof(Var) * sizeof(new.var_count));
-		CHECK_MALLOC(new.vars);
-		new.be_vars = realloc(new.be_vars, sizeof(WyrtLvalue) * sizeof(new.var_count));
-		CHECK_MALLOC(new.be_vars);
-
 		size_t decl_index = index + statement.if_statement.decl;
-		AstNode decl = cg->nodes[decl_index];
+		AstNode decl = ast_get(cg->ast, decl_index);
 		assert(decl.type == AST_VAR_DECL);
-		new.vars[new.var_count - 1] = (Var) {
+		Var var = (Var) {
 			.id = decl.var_decl.id,
 			.type = type_from_ast(
-				&parent->tc,
-				cg->nodes,
+				parent->tc,
+				cg->ast,
 				decl_index + decl.var_decl.data_type,
 				err
 			),
@@ -1876,12 +1967,12 @@ static void gen_if(
 		};
 		if(*err) goto RET;
 
-		new.be_vars[new.var_count - 1] = cg->be.block_new_variable(
+		WyrtLvalue be_var = BE(block_new_variable)(
 			cg->ctx,
 			&decl.com.debug,
 			*be_block,
-			new.vars[new.var_count - 1].type,
-			&parent->tc,
+			var.type,
+			parent->tc,
 			id_get(cg->identifiers, decl.var_decl.id),
 			err
 		);
@@ -1889,7 +1980,7 @@ static void gen_if(
 
 		if(!decl.var_decl.initial) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &parent->tc,
+				stderr, cg->identifiers, cg->strings, parent->tc,
 				"Declaration in if-statement not initialized at %l\n",
 				&decl.com.debug
 			);
@@ -1899,26 +1990,30 @@ static void gen_if(
 
 		Expr init = gen_expr(
 			cg,
-			new.vars[new.var_count - 1].type,
+			var.type,
 			index + statement.if_statement.decl + decl.var_decl.initial,
 			parent,
 			err
 		);
 		if(*err) goto RET;
 
-		cg->be.block_add_assign(
+		BE(block_add_assign)(
 			cg->ctx,
 			&decl.com.debug,
 			*be_block,
-			new.be_vars[new.var_count - 1],
+			be_var,
 			init.expr,
 			err
 		);
 		if(*err) goto RET;
+
+		// Only now, the initializer can't see it
+		scope_push(&new, (Symbol) {.var = var, .be_var = be_var}, err);
+		if(*err) goto RET;
 	
 		if(!statement.if_statement.condition) {
-			cond.expr = cg->be.rvalue_from_lvalue(new.be_vars[new.var_count - 1]);
-			cond.type = new.vars[new.var_count - 1].type;
+			cond.expr = BE(rvalue_from_lvalue)(be_var);
+			cond.type = var.type;
 		} else {
 			cond = gen_expr(
 				cg,
@@ -1939,9 +2034,9 @@ static void gen_if(
 		);
 		if(*err) goto RET;
 	}
-	if(!types_are_compatible(&parent->tc, cond.type, (Type) { TYPE_PRIMITIVE_BOOL })) {
+	if(!types_are_compatible(parent->tc, cond.type, (Type) { TYPE_PRIMITIVE_BOOL })) {
 		wyrt_diag(
-			stderr, cg->identifiers, cg->strings, &parent->tc,
+			stderr, cg->identifiers, cg->strings, parent->tc,
 			"Cannot coerce value of type '%t' into 'bool' at %l\n",
 			cond.type,
 			&statement.com.debug
@@ -1950,17 +2045,17 @@ static void gen_if(
 		goto RET;
 	}
 
-	WyrtBlock true_block = cg->be.new_block(cg->ctx, fn, err);
+	WyrtBlock true_block = BE(new_block)(cg->ctx, fn, err);
 	if(*err) goto RET;
 
-	WyrtBlock after = cg->be.new_block(cg->ctx, fn, err);
+	WyrtBlock after = BE(new_block)(cg->ctx, fn, err);
 	if(*err) goto RET;
 
 	if(statement.if_statement.else_block) {
-		WyrtBlock else_block = cg->be.new_block(cg->ctx, fn, err);
+		WyrtBlock else_block = BE(new_block)(cg->ctx, fn, err);
 		if(*err) goto RET;
 
-		cg->be.block_end_with_cond(
+		BE(block_end_with_cond)(
 			cg->ctx,
 			&statement.com.debug,
 			*be_block,
@@ -1998,7 +2093,7 @@ static void gen_if(
 		if(*err) goto RET;
 
 		if(!true_returns) {
-			cg->be.block_end_with_jump(
+			BE(block_end_with_jump)(
 				cg->ctx,
 				&statement.com.debug,
 				true_block,
@@ -2009,7 +2104,7 @@ static void gen_if(
 		}
 
 		if(!false_returns) {
-			cg->be.block_end_with_jump(
+			BE(block_end_with_jump)(
 				cg->ctx,
 				&statement.com.debug,
 				else_block,
@@ -2021,7 +2116,7 @@ static void gen_if(
 
 		*returned = true_returns && false_returns;
 	} else {
-		cg->be.block_end_with_cond(
+		BE(block_end_with_cond)(
 			cg->ctx,
 			&statement.com.debug,
 			*be_block,
@@ -2044,7 +2139,7 @@ static void gen_if(
 		);
 		if(*err) goto RET;
 
-		cg->be.block_end_with_jump(
+		BE(block_end_with_jump)(
 			cg->ctx,
 			&statement.com.debug,
 			true_block,
@@ -2073,75 +2168,34 @@ static void gen_block(
 )
 {
 	Scope scope;
-	DynArr be_vars;
-	dynarr_init(&be_vars, sizeof(WyrtLvalue));
-	DynArr vars;
-	dynarr_init(&vars, sizeof(Var));
-
-	AstNode block = cg->nodes[index];
+	scope_init(&scope, parent);
 
-	scope_init(&scope, parent, err);
-	if(*err) goto RET;
+	AstNode block = ast_get(cg->ast, index);
 
+	// Every variable in the block is in scope from the start, but can't be used until it's declared
 	size_t statement_index = index + block.block.statements;
-	bool has_next;
-	do {
-		AstNode statement = cg->nodes[statement_index];
+	bool has_next = !!block.block.statements;
+	while(has_next) {
+		AstNode statement = ast_get(cg->ast, statement_index);
 
 		if(statement.type == AST_VAR_DECL) {
-			Var var;
-			WyrtLvalue be_var = gen_var_decl(cg, statement_index, *be_block, &var, &scope, err);
-			if(*err) {
-				dynarr_clean(&vars);
-				dynarr_clean(&be_vars);
-				goto RET;
-			}
-
-			dynarr_push(&be_vars, &be_var, err);
-			if(*err) {
-				dynarr_clean(&vars);
-				dynarr_clean(&be_vars);
-				goto RET;
-			}
+			Symbol symbol = { 0 };
+			symbol.be_var = gen_var_decl(cg, statement_index, *be_block, &symbol.var, &scope, err);
+			if(*err) goto RET;
 
-			dynarr_push(&vars, &var, err);
-			if(*err) {
-				dynarr_clean(&vars);
-				dynarr_clean(&be_vars);
-				goto RET;
-			}
+			scope_push(&scope, symbol, err);
+			if(*err) goto RET;
 		}
 
-		has_next = cg->nodes[statement_index].com.next != 0;
+		has_next = cg->ast->next[statement_index] != 0;
 		statement_index += statement.com.next;
-	} while(has_next);
-
-	if(vars.count > 0) {
-		scope.be_vars = realloc(
-			scope.be_vars,
-			sizeof(WyrtLvalue) * (scope.var_count + be_vars.count)
-		);
-		CHECK_MALLOC(scope.be_vars);
-		scope.vars = realloc(scope.vars, sizeof(Var) * (scope.var_count + vars.count));
-		CHECK_MALLOC(scope.vars);
-		memcpy(
-			scope.be_vars + scope.var_count * sizeof(WyrtLvalue),
-			be_vars.data,
-			sizeof(WyrtLvalue) * be_vars.count
-		);
-		memcpy(
-			scope.vars + scope.var_count * sizeof(Var),
-			vars.data,
-			sizeof(Var) * vars.count
-		);
-		scope.var_count = scope.var_count + vars.count;
 	}
 
-	size_t varnum = 0;
+	size_t varnum = scope.base;
 	statement_index = index + block.block.statements;
 	has_next = !!block.block.statements;
 	while (has_next) {
-		AstNode statement = cg->nodes[statement_index];
+		AstNode statement = ast_get(cg->ast, statement_index);
 
 		switch(statement.type) {
 		case AST_IF: {
@@ -2159,7 +2213,7 @@ static void gen_block(
 			);
 			if(*err) goto RET;
 						
-			cg->be.block_add_eval(
+			BE(block_add_eval)(
 				cg->ctx,
 				&statement.com.debug,
 				*be_block,
@@ -2170,69 +2224,63 @@ static void gen_block(
 		} break;
 
 		case AST_FN_CALL: {
-			bool found = false;
-			for(size_t i = 0; i < cg->fn_count; i++) {
-				if(cg->fn_sigs[i].id == statement.fn_call.fn_id) {
-					if(cg->fn_sigs[i].ret.type != TYPE_PRIMITIVE_VOID) {
-						wyrt_diag(
-							stderr, cg->identifiers, cg->strings, &scope.tc,
-							"Cannot implicitly discard return value of function '%i' at %l, "
-							"Consider using the 'discard' keyword\n",
-							statement.fn_call.fn_id,
-							&statement.com.debug
-						);
-						*err = ERROR_UNEXPECTED_DATA;
-						goto RET;
-					}
-					Expr val = gen_fn_call(cg, statement_index, &scope, err);
-					if(*err) goto RET;
-					cg->be.block_add_eval(
-						cg->ctx,
-						&statement.com.debug,
-						*be_block,
-						val.expr,
-						err
-					);
-					if(*err) goto RET;
-					found = true;
-					break;
-				}
+			size_t fn_index = codegen_find_fn(cg, statement.fn_call.fn_id);
+			if(fn_index == SIZE_MAX) {
+				wyrt_diag(
+					stderr, cg->identifiers, cg->strings, scope.tc,
+					"Undeclared Function '%i' at %l\n",
+					statement.fn_call.fn_id,
+					&statement.com.debug
+				);
+				*err = ERROR_UNEXPECTED_DATA;
+				goto RET;
 			}
 
-			if(found) break;
-
-			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope.tc,
-				"Undeclared Function '%i' at %l\n",
-				statement.fn_call.fn_id,
-				&statement.com.debug
+			if(cg->fn_sigs[fn_index].ret.type != TYPE_PRIMITIVE_VOID) {
+				wyrt_diag(
+					stderr, cg->identifiers, cg->strings, scope.tc,
+					"Cannot implicitly discard return value of function '%i' at %l, "
+					"Consider using the 'discard' keyword\n",
+					statement.fn_call.fn_id,
+					&statement.com.debug
+				);
+				*err = ERROR_UNEXPECTED_DATA;
+				goto RET;
+			}
+			Expr val = gen_fn_call(cg, statement_index, &scope, err);
+			if(*err) goto RET;
+			BE(block_add_eval)(
+				cg->ctx,
+				&statement.com.debug,
+				*be_block,
+				val.expr,
+				err
 			);
-			*err = ERROR_UNEXPECTED_DATA;
-			goto RET;
+			if(*err) goto RET;
 		} break;
 
 		case AST_VAR_DECL: {
 			if(statement.var_decl.initial) {
 				Expr expr = gen_expr(
 					cg,
-					scope.vars[varnum].type,
+					scope.symbols->symbols[varnum].var.type,
 					statement_index + statement.var_decl.initial,
 					&scope,
 					err
 				);
 				if(*err) goto RET;
 
-				cg->be.block_add_assign(
+				BE(block_add_assign)(
 					cg->ctx,
 					&statement.com.debug,
 					*be_block,
-					scope.be_vars[varnum],
+					scope.symbols->symbols[varnum].be_var,
 					expr.expr,
 					err
 				);
 				if(*err) goto RET;
 			} else {
-				if(!scope.vars[varnum].mut) {
+				if(!scope.symbols->symbols[varnum].var.mut) {
 					fprintf(stderr, "Error: const Variable uninitialized at ");
 					lexer_print_debug_to_file(stderr, &statement.com.debug);
 					fprintf(stderr, "\n");
@@ -2240,7 +2288,7 @@ static void gen_block(
 					goto RET;
 				}
 			}
-			scope.vars[varnum].declared = true;
+			scope.symbols->symbols[varnum].var.declared = true;
 			varnum += 1;
 		} break;
 
@@ -2255,7 +2303,7 @@ static void gen_block(
 
 			if(!lhs.mut) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope.tc,
+					stderr, cg->identifiers, cg->strings, scope.tc,
 					"Cannot assign to const value at %l\n",
 					&statement.com.debug
 				);
@@ -2272,7 +2320,7 @@ static void gen_block(
 			);
 			if(*err) goto RET;
 
-			cg->be.block_add_assign(
+			BE(block_add_assign)(
 				cg->ctx,
 				&statement.com.debug,
 				*be_block,
@@ -2297,7 +2345,7 @@ static void gen_block(
 
 			if(!lhs.mut || !lhs.read) {
 				wyrt_diag(
-					stderr, cg->identifiers, cg->strings, &scope.tc,
+					stderr, cg->identifiers, cg->strings, scope.tc,
 					"Cannot Perform Compound Assignment on non-'var' Value at %l\n",
 					&statement.com.debug
 				);
@@ -2314,7 +2362,7 @@ static void gen_block(
 			);
 			if(*err) goto RET;
 
-			cg->be.block_add_compound_assign(
+			BE(block_add_compound_assign)(
 				cg->ctx,
 				&statement.com.debug,
 				*be_block,
@@ -2337,7 +2385,7 @@ static void gen_block(
 					goto RET;
 				}
 
-				cg->be.block_end_with_return(
+				BE(block_end_with_return)(
 					cg->ctx,
 					&statement.com.debug,
 					*be_block,
@@ -2355,7 +2403,7 @@ static void gen_block(
 				);
 				if(*err) goto RET;
 
-				cg->be.block_end_with_return(
+				BE(block_end_with_return)(
 					cg->ctx,
 					&statement.com.debug,
 					*be_block,
@@ -2373,13 +2421,11 @@ static void gen_block(
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
-		has_next = cg->nodes[statement_index].com.next != 0;
-		statement_index += cg->nodes[statement_index].com.next;
+		has_next = cg->ast->next[statement_index] != 0;
+		statement_index += cg->ast->next[statement_index];
 	}
 
 RET:
-	dynarr_clean(&be_vars);
-	dynarr_clean(&vars);
 	scope_clean(&scope);
 	return;
 }
@@ -2393,43 +2439,34 @@ static void gen_fn(
 	Error *err
 )
 {
-	const AstNode def = cg->nodes[index];
+	const AstNode def = ast_get(cg->ast, index);
 	assert(def.type == AST_FN_DEF);
 	
 	size_t block_index = index + def.fn_def.block;
-	if(cg->nodes[block_index].type == AST_EXTERN) return;
+	if(cg->ast->types[block_index] == AST_EXTERN) return;
 	
-	DynArr be_vars;
-	DynArr vars;
-	dynarr_init(&be_vars, sizeof(WyrtLvalue));
-	dynarr_init(&vars, sizeof(Var));
+	SymbolTable symbols = { .arena = &cg->fn_arena };
+	Scope scope = { .symbols = &symbols, .tc = global->tc };
 
-	Scope scope;
-	scope_init(&scope, global, err);
-	if(*err) goto RET;
-
-	scope.be_params = malloc(sig.arg_count * sizeof(WyrtRvalue));	
-	CHECK_MALLOC(scope.be_params);
-	scope.params = malloc(sig.arg_count * sizeof(Var));
-	CHECK_MALLOC(scope.params);
-	scope.param_count = sig.arg_count;
-
-	assert(cg->nodes[block_index].type == AST_BLOCK);
+	assert(cg->ast->types[block_index] == AST_BLOCK);
 
 	size_t additional = 0;
 	for(size_t i = 0; i < sig.arg_count; i++) {
-		scope.params[i] = (Var) {
-			.id = sig.arg_ids[i],
-			.type = sig.args[i],
-			.mut = false,
-			.declared = true,
+		Symbol param = {
+			.var = {
+				.id = sig.arg_ids[i],
+				.type = sig.args[i],
+				.mut = false,
+				.declared = true,
+			},
+			.param = true,
 		};
 
 		if(sig.args[i].type == TYPE_SLICE_CONST
 			|| sig.args[i].type == TYPE_SLICE_ABYSS
 			|| sig.args[i].type == TYPE_SLICE_VAR
 		) {
-			WyrtParam ptr = cg->be.function_get_param(
+			WyrtParam ptr = BE(function_get_param)(
 				cg->ctx,
 				fn,
 				i + additional,
@@ -2437,7 +2474,7 @@ static void gen_fn(
 			);
 			if(*err) goto RET;
 
-			WyrtParam len = cg->be.function_get_param(
+			WyrtParam len = BE(function_get_param)(
 				cg->ctx,
 				fn,
 				i + additional + 1,
@@ -2446,24 +2483,24 @@ static void gen_fn(
 			if(*err) goto RET;
 
 			WyrtRvalue vals[2];
-			vals[0] = cg->be.rvalue_from_param(ptr);
-			vals[1] = cg->be.rvalue_from_param(len);
+			vals[0] = BE(rvalue_from_param)(ptr);
+			vals[1] = BE(rvalue_from_param)(len);
 
-			size_t type_refs[2];
+			TypeId type_refs[2];
 			Type ptr_type = (Type) {
 				.pointer = {
 					.type = TYPE_POINTER_CONST + (sig.args[i].type - TYPE_SLICE_CONST),
 					.base = sig.args[i].slice.base,
 				},
 			};
-			type_refs[0] = types_register_nexist(&scope.tc, ptr_type, err);
+			type_refs[0] = types_register(scope.tc, ptr_type, err);
 			if(*err) goto RET;
 
 			Type len_type = (Type) {.type = TYPE_PRIMITIVE_U64};
-			type_refs[1] = types_register_nexist(&scope.tc, len_type, err);
+			type_refs[1] = types_register(scope.tc, len_type, err);
 			if(*err) goto RET;
 
-			size_t ids[2] = {0, 1};
+			Id ids[2] = {0, 1};
 			Type s = (Type) {
 				.struct_type = {
 					.type = TYPE_STRUCT,
@@ -2473,11 +2510,11 @@ static void gen_fn(
 				},
 			};
 
-			scope.be_params[i] = cg->be.rvalue_struct_lit(
+			param.be_param = BE(rvalue_struct_lit)(
 				cg->ctx,
 				NULL,
 				s,
-				&scope.tc,
+				scope.tc,
 				vals,
 				2,
 				err
@@ -2486,19 +2523,22 @@ static void gen_fn(
 
 			additional += 1;
 		} else {
-			WyrtParam param = cg->be.function_get_param(
+			WyrtParam be_param = BE(function_get_param)(
 				cg->ctx,
 				fn,
 				i + additional,
 				err
 			);
 			if(*err) goto RET;
-			scope.be_params[i] = cg->be.rvalue_from_param(param);
+			param.be_param = BE(rvalue_from_param)(be_param);
 		}
+
+		scope_push(&scope, param, err);
+		if(*err) goto RET;
 	}
 
 
-	WyrtBlock be_block = cg->be.new_block(
+	WyrtBlock be_block = BE(new_block)(
 		cg->ctx,
 		fn,
 		err
@@ -2513,15 +2553,15 @@ static void gen_fn(
 	if(!returned) {
 		if(sig.ret.type != TYPE_PRIMITIVE_VOID) {
 			wyrt_diag(
-				stderr, cg->identifiers, cg->strings, &scope.tc,
+				stderr, cg->identifiers, cg->strings, scope.tc,
 				"Non-Void Function '%i' does not return a value!\n",
-				sig.id
+				(Id) sig.id
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
 
-		cg->be.block_end_with_return(
+		BE(block_end_with_return)(
 			cg->ctx,
 			NULL,
 			be_block,
@@ -2532,77 +2572,71 @@ static void gen_fn(
 	}
 
 RET:
-	scope_clean(&scope);
 	return;
 }
 
 void codegen_gen(CodeGen *cg, GenOptions options, const char *path, Error *err)
 {
-	assert(cg->nodes[0].type == AST_MODULE);
+	assert(cg->ast->types[0] == AST_MODULE);
 	DynArr sigs;
 	dynarr_init(&sigs, sizeof(FnSig));
 	DynArr fns;
 	dynarr_init(&fns, sizeof(WyrtFunction));
 
-	Scope global;
-	scope_init(&global, NULL, err);
+	size_t pass = pass_begin("codegen");
+	types_init(&cg->tc, &cg->arena, err);
 	if(*err) goto RET;
+	cg->tc.cache = arena_alloc(&cg->arena, cg->ast->len * sizeof(TypeId), err);
+	if(*err) goto RET;
+	memset(cg->tc.cache, 0, cg->ast->len * sizeof(TypeId));
+
+	Scope global = { .tc = &cg->tc };
 	
-	const AstNode module = cg->nodes[0];
+	const AstNode module = ast_get(cg->ast, 0);
 
 	size_t index = module.module.statements;
 	bool has_next;
 	do {
-		if(cg->nodes[index].type == AST_TYPEDEF) {
+		if(cg->ast->types[index] == AST_TYPEDEF) {
 			Type backing = type_from_ast(
-				&global.tc,
-				cg->nodes,
-				index + cg->nodes[index].typdef.backing,
+				global.tc,
+				cg->ast,
+				index + ast_get(cg->ast, index).typdef.backing,
 				err
 			);
 			if(*err) goto RET;
 
-			size_t type_index = SIZE_MAX;
-			for(size_t j = 0; j < global.tc.count; j++) {
-				if(types_are_equal(backing, global.tc.types[j])) {
-					type_index = j;
-					break;
-				}
-			}
-			for(size_t j = 0; j < global.tc.count; j++) {
-				if(global.tc.types[j].type == TYPE_TYPEDEF) {
-					if(global.tc.types[j].typdef.id == cg->nodes[index].typdef.id) {
-						wyrt_diag(
-							stderr, cg->identifiers, cg->strings, &global.tc,
-							"Cannot create Duplicate Typedef at %l\n",
-							&cg->nodes[index].com.debug
-						);
-						*err = ERROR_UNEXPECTED_DATA;
-						goto RET;
-					}
-				}	
+			TypeId type_index = types_find(global.tc, backing);
+			if(type_lookup_id(global.tc, ast_get(cg->ast, index).typdef.id) != TYPE_ID_NONE) {
+				wyrt_diag(
+					stderr, cg->identifiers, cg->strings, global.tc,
+					"Cannot create Duplicate Typedef at %l\n",
+					&AST_DEBUG(cg->ast, index)
+				);
+				*err = ERROR_UNEXPECTED_DATA;
+				goto RET;
 			}
 
-			assert(type_index != SIZE_MAX);
+			assert(type_index != TYPE_ID_NONE);
 
 			Type t = (Type) {
 				.typdef = {
 					.type = TYPE_TYPEDEF,
-					.id = cg->nodes[index].typdef.id,
+					.id = ast_get(cg->ast, index).typdef.id,
 					.backing = type_index,
 				},
 			};
 
-			types_register(&global.tc, t, err);
+			types_register(global.tc, t, err);
 			if(*err) goto RET;
 		}
-		has_next = cg->nodes[index].com.next != 0;
-		index += cg->nodes[index].com.next;
+		has_next = cg->ast->next[index] != 0;
+		index += cg->ast->next[index];
 	} while(has_next);
 
 	index = module.module.statements;
 	do {
-		if(cg->nodes[index].type == AST_FN_DEF) {
+		if(cg->ast->types[index] == AST_FN_DEF) {
 			dynarr_alloc(&sigs, 1, err);
 			if(*err) {
 				dynarr_clean(&sigs);
@@ -2618,6 +2652,7 @@ void codegen_gen(CodeGen *cg, GenOptions options, const char *path, Error *err)
 			
 			FnSig *sig = dynarr_from_back(&sigs, 0);
 			*(WyrtFunction*)dynarr_from_back(&fns, 0) = gen_fnsig(cg, sig, &global, index, err);
+			arena_reset(&cg->fn_arena, (ArenaMark) { 0 });
 			
 			if(*err) {
 				dynarr_clean(&sigs);
@@ -2625,19 +2660,25 @@ void codegen_gen(CodeGen *cg, GenOptions options, const char *path, Error *err)
 				goto RET;
 			}
 		}	
-		has_next = cg->nodes[index].com.next != 0;
-		index += cg->nodes[index].com.next;
+		has_next = cg->ast->next[index] != 0;
+		index += cg->ast->next[index];
 	} while(has_next);
 	cg->fn_sigs = sigs.data;
 	cg->fns = fns.data;
 	cg->fn_count = sigs.count;
+	counters.functions = cg->fn_count;
+	fn_index_build(cg, err);
+	if(*err) goto RET;
 
 	size_t fnnum = 0;
 	index = module.module.statements;
 	do {
-		switch(cg->nodes[index].type) {
+		switch(cg->ast->types[index]) {
 		case AST_FN_DEF:
+			span_begin(id_get(cg->identifiers, cg->fn_sigs[fnnum].id));
 			gen_fn(cg, cg->fn_sigs[fnnum], index, cg->fns[fnnum], &global, err);
+			arena_reset(&cg->fn_arena, (ArenaMark) { 0 });
+			span_end();
 			if(*err) goto RET;
 			fnnum += 1;
 			break;
@@ -2647,66 +2688,43 @@ void codegen_gen(CodeGen *cg, GenOptions options, const char *path, Error *err)
 
 		default:
 			fprintf(stderr, "Illegal File-Scope Statement at ");
-			lexer_print_debug_to_file(stderr, &cg->nodes[index].com.debug);
+			lexer_print_debug_to_file(stderr, &AST_DEBUG(cg->ast, index));
 			fprintf(stderr, "\n");
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
-		has_next = cg->nodes[index].com.next != 0;
-		index += cg->nodes[index].com.next;
+		has_next = cg->ast->next[index] != 0;
+		index += cg->ast->next[index];
 	} while(has_next);
+	pass_end(pass);
 
-	cg->be.compile(cg->ctx, options, path, err);
+	pass = pass_begin("backend compile");
+	BE(compile)(cg->ctx, options, path, err);
 	if(*err) goto RET;
 
 RET:
-	scope_clean(&global);
+	pass_end(pass);
 	return;
 }
 
-void scope_init(Scope *scope, const Scope *parent, Error *err)
+void scope_init(Scope *scope, const Scope *parent)
 {
-	*scope = (Scope) { 0 };
-	if(parent) {
-		if(parent->param_count) {
-			scope->param_count = parent->param_count;
-
-			scope->params = malloc(parent->param_count * sizeof(Var));
-			CHECK_MALLOC(scope->params);
-			memcpy(scope->params, parent->params, parent->param_count * sizeof(Var));
-
-			scope->be_params = malloc(parent->param_count * sizeof(WyrtRvalue));
-			CHECK_MALLOC(scope->be_params);
-			memcpy(scope->be_params, parent->be_params, parent->param_count * sizeof(WyrtRvalue));
-		}
-		if(parent->var_count) {
-			scope->var_count = parent->var_count;
-
-			scope->vars = malloc(parent->var_count * sizeof(Var));
-			CHECK_MALLOC(scope->vars);
-			memcpy(scope->vars, parent->vars, parent->var_count * sizeof(Var));
-
-			scope->be_vars = malloc(parent->var_count * sizeof(WyrtRvalue));
-			CHECK_MALLOC(scope->be_vars);
-			memcpy(scope->be_vars, parent->be_vars, parent->var_count * sizeof(WyrtRvalue));
-		}
-
-		types_copy(&scope->tc, &parent->tc, err);
-		if(*err) goto RET;
-	} else {
-		types_init(&scope->tc, err);
-		if(*err) goto RET;
-	}
-
-RET:
-	return;
+	counters.scopes += 1;
+	*scope = (Scope) {
+		.symbols = parent->symbols,
+		.base = parent->symbols ? parent->symbols->count : 0,
+		.tc = parent->tc,
+	};
 }
 
 void scope_clean(const Scope *scope)
 {
-	if(scope->params) free(scope->params);
-	if(scope->be_params) free(scope->be_params);
-	if(scope->vars) free(scope->vars);
-	if(scope->be_vars) free(scope->be_vars);
-	if(scope->tc.types) free(scope->tc.types);
+	SymbolTable *st = scope->symbols;
+	if(!st) return;
+
+	for(size_t i = st->count; i-- > scope->base;) {
+		Symbol const *symbol = &st->symbols[i];
+		if(symbol->bound) symbols_slot(st, symbol->var.id)->symbol = symbol->shadowed;
+	}
+	st->count = scope->base;
 }
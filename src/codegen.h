@@ -23,25 +23,61 @@ typedef struct {
 } Var;
 
 typedef struct {
-	Var *params;
-	size_t param_count;
-	Var *vars;
-	size_t var_count;
-	TypeContext tc;
-	
-	WyrtLvalue *be_vars;
-	WyrtRvalue *be_params;
+	Var var;
+	bool param; // be_param is set instead of be_var
+	bool bound; // False if an earlier variable of the same name hides this one
+	uint32_t shadowed; // The symbol this one hides while it's in scope, + 1, 0 == None
+	WyrtLvalue be_var;
+	WyrtRvalue be_param;
+} Symbol;
+
+typedef struct {
+	uint32_t name; // Id + 1, 0 == Empty
+	uint32_t symbol; // + 1, 0 == Nothing by that name is in scope
+} SymbolSlot;
+
+/*
+ * Every variable and parameter of the function being generated.
+ * symbols is a stack: each scope pushes its own on top of its parent's and
+ * pops them again in scope_clean, so a name's slot always has the symbol
+ * it means right now, and the symbols it hides are chained behind it.
+ * Variables hide parameters, but otherwise the first symbol with a name wins.
+ */
+typedef struct {
+	Symbol *symbols;
+	size_t count;
+	size_t cap;
+	SymbolSlot *slots; // Open-addressed, a name keeps its slot once it has one
+	size_t slot_count;
+	size_t slot_cap; // Power of 2
+	Arena *arena;
+} SymbolTable;
+
+typedef struct {
+	SymbolTable *symbols; // The function's, NULL at file scope
+	size_t base; // Where this scope's own symbols start
+	TypeContext *tc; // The CodeGen's, shared by every scope
 } Scope;
 
 typedef struct {
-	const AstNode *nodes;
-	size_t node_count;
+	uint32_t name; // Id + 1, 0 == Empty
+	uint32_t fn; // Index into fn_sigs and fns
+} FnSlot;
+
+typedef struct {
+	Ast const *ast;
 	char *const *identifiers;
 	char *const *strings;
 	size_t string_count;
 	FnSig *fn_sigs;
 	WyrtFunction **fns;
 	size_t fn_count;
+	FnSlot *fn_slots; // Open-addressed by name, extern functions too
+	size_t fn_slot_cap; // Power of 2
+	TypeContext tc;
+
+	Arena arena; // Lives as long as cg: types, the global scope, function signatures
+	Arena fn_arena; // Reset after each function: its symbols and temporary arrays
 
 	void *dl;
 	WyrtBackend be;
@@ -50,8 +86,7 @@ typedef struct {
 
 void codegen_init(
 	CodeGen *cg,
-	const AstNode *nodes,
-	size_t node_count,
+	Ast const *ast,
 	char *const *identifiers,
 	char *const *strings,
 	size_t string_count,
@@ -63,5 +98,10 @@ void codegen_clean(const CodeGen *cg);
 
 void codegen_gen(CodeGen *cg, GenOptions options, const char *path, Error *err);
 
-void scope_init(Scope *scope, const Scope *parent, Error *err);
+// Index into fn_sigs and fns of the function called id, SIZE_MAX == Not Found.
+// If there's more than one, it's the first.
+size_t codegen_find_fn(CodeGen const *cg, size_t id);
+
+// A new scope on top of parent, which is left alone until this one's cleaned
+void scope_init(Scope *scope, const Scope *parent);
 void scope_clean(const Scope *scope);
@@ -1,16 +1,82 @@
 #include "lexer.h"
 #include "util.h"
 #include "ui.h"
+#include "scan.h"
 
 #include <ctype.h>
 #include <string.h>
 #include <inttypes.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#endif
+
+// Every initialised lexer, indexed by DebugInfo.file.
+// This is what lets a DebugInfo be resolved without its lexer at hand.
+static Lexer **lexers;
+static uint32_t lexer_count;
+
+static void lexer_register(Lexer *lex, Error *err)
+{
+	Lexer **new = realloc(lexers, (lexer_count + 1) * sizeof(Lexer*));
+	CHECK_MALLOC(new);
+	lexers = new;
+	lex->file = lexer_count;
+	lexers[lexer_count++] = lex;
+RET:
+	return;
+}
+
+// Map the input read-only, so the lexer never copies the source.
+// Returns false if that's not possible, in which case it gets read instead.
+static bool lexer_map(Lexer *lex)
+{
+#ifdef _WIN32
+	(void) lex;
+	return false;
+#else
+	bool ok = false;
+	int fd = open(lex->file_path, O_RDONLY);
+	if(fd < 0) goto RET;
+
+	struct stat st;
+	if(fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size == 0) goto RET;
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(map == MAP_FAILED) goto RET;
+
+	lex->file_contents = map;
+	lex->file_length = st.st_size;
+	lex->mapped = true;
+	ok = true;
+RET:
+	if(fd >= 0) close(fd);
+	return ok;
+#endif
+}
+
 void lexer_init(Lexer *lex, char *file_path, Error *err)
 {
+	FILE *file = NULL;
 	lex->file_path = file_path;
+	lex->mapped = false;
+	lex->scan = scan_best();
+	lex->line_starts = NULL;
+	lex->line_count = 0;
+	lex->jobs = 1;
+	lex->base = 0;
+	lex->quiet = false;
+
+	lexer_register(lex, err);
+	if(*err) goto RET;
+
+	if(lexer_map(lex)) goto CHECK_LENGTH;
 
-	FILE *file = fopen(file_path, "rb");
+	file = fopen(file_path, "rb");
 	if(!file) {
 		fprintf(stderr, "Input File Does Not Exist.\n");
 		*err = ERROR_NOT_FOUND;
@@ -21,12 +87,13 @@ void lexer_init(Lexer *lex, char *file_path, Error *err)
 	lex->file_length = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	lex->file_contents = malloc(lex->file_length);
-	CHECK_MALLOC(lex->file_contents);
+	char *contents = malloc(lex->file_length);
+	CHECK_MALLOC(contents);
+	lex->file_contents = contents;
 
 	if(
 		fread(
-			lex->file_contents,
+			contents,
 			1, lex->file_length,
 			file
 		) < lex->file_length
@@ -36,6 +103,12 @@ void lexer_init(Lexer *lex, char *file_path, Error *err)
 		goto RET;
 	}
 
+CHECK_LENGTH:
+	if(lex->file_length > UINT32_MAX) {
+		fprintf(stderr, "Input File is too large (over 4GiB).\n");
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
 
 RET:
 	if(file) fclose(file);
@@ -44,100 +117,224 @@ RET:
 
 void lexer_clean(Lexer *lex)
 {
-	if(lex->file_contents) free(lex->file_contents);
+	if(lex->file < lexer_count && lexers[lex->file] == lex) {
+		lexers[lex->file] = NULL;
+		while(lexer_count && !lexers[lexer_count - 1]) lexer_count--;
+		if(!lexer_count) {
+			free(lexers);
+			lexers = NULL;
+		}
+	}
+	free(lex->line_starts);
+
+	if(!lex->file_contents) return;
+#ifndef _WIN32
+	if(lex->mapped) {
+		munmap((void*)lex->file_contents, lex->file_length);
+		return;
+	}
+#endif
+	free((void*)lex->file_contents);
 }
 
-void lexer_clean_strings(char **identifiers, size_t identifier_count)
+void lexer_clean_strings(char **strings)
 {
-	if(!identifiers) return;
-	for(size_t i = 0; i < identifier_count; i++) {
-		free(identifiers[i]);
-	}
-	free(identifiers);
+	free(strings); // Pointers and Data are one allocation, see intern_finish
 }
 
-static int get_char(
-	Lexer *lex,
-	size_t *pos, uint32_t *line, uint32_t *col, uint32_t *prev_col
-)
+static int get_char(Lexer *lex, size_t *pos)
 {
 	if(++*pos >= lex->file_length) {
 		return EOF;
 	}
-	*prev_col = *col;
 	char ret = lex->file_contents[*pos - 1];
-	if(ret == '\n') {
-		*col = 0;
-		*line += 1;
-	} else {
-		*col += 1;
-	}
 
 	return ret;
 }
 
-static int skip_whitespace(
-	Lexer *lex,
-	size_t *pos, uint32_t *line, uint32_t *col, uint32_t *prev_col
-)
+// Bytes get_char still hands out (it stops one short of file_length)
+static size_t remaining(Lexer const *lex, size_t pos)
+{
+	return pos + 1 < lex->file_length ? lex->file_length - 1 - pos : 0;
+}
+
+static int skip_whitespace(Lexer *lex, size_t *pos)
+{
+	*pos += lex->scan->whitespace(lex->file_contents + *pos, remaining(lex, *pos));
+	return get_char(lex, pos);
+}
+
+// Compare a (pointer, length) view of the source against a C string
+static bool view_eq(const char *view, size_t len, const char *str)
+{
+	return strlen(str) == len && !memcmp(view, str, len);
+}
+
+// Maps a word to its keyword TokenType, or TOKEN_IDENT.
+// Switches on length, then first char, so only one memcmp is ever done.
+// When adding a keyword that shares both with another, switch on another char.
+static TokenType keyword_lookup(const char *word, size_t len)
 {
-	int c = ' ';
-	while(isspace(c)) {
-		c = get_char(lex, pos, line, col, prev_col);
+	const char *kw = NULL;
+	TokenType type = TOKEN_IDENT;
+
+	switch(len) {
+	case 2:
+		switch(word[0]) {
+		case 'f': kw = "fn"; type = TOKEN_FN; break;
+		case 'i': kw = "if"; type = TOKEN_IF; break;
+		}
+		break;
+	case 3:
+		switch(word[0]) {
+		case 'v': kw = "var"; type = TOKEN_VAR; break;
+		}
+		break;
+	case 4:
+		switch(word[0]) {
+		case 'e': kw = "else"; type = TOKEN_ELSE; break;
+		}
+		break;
+	case 5:
+		switch(word[0]) {
+		case 'a': kw = "abyss"; type = TOKEN_ABYSS; break;
+		case 'c': kw = "const"; type = TOKEN_CONST; break;
+		}
+		break;
+	case 6:
+		switch(word[0]) {
+		case 'r': kw = "return"; type = TOKEN_RETURN; break;
+		case 's': kw = "struct"; type = TOKEN_STRUCT; break;
+		}
+		break;
+	case 7:
+		switch(word[0]) {
+		case 'd': kw = "discard"; type = TOKEN_DISCARD; break;
+		case 't': kw = "typedef"; type = TOKEN_TYPEDEF; break;
+		}
+		break;
 	}
 
-	return c;
+	if(!kw || memcmp(word, kw, len)) return TOKEN_IDENT;
+	return type;
 }
 
-static bool is_valid_in_identifier(char c)
+/*
+ * Operators and punctuation
+ * Recognised by a DFA whose transition table is generated from OPERATOR_LIST.
+ * Every prefix of an operator is an operator as well, so the longest match is
+ * found without ever backing up.
+ */
+#define OPERATOR_LIST \
+	X(":", TOKEN_COLON) \
+	X("(", TOKEN_LPAREN) \
+	X(")", TOKEN_RPAREN) \
+	X("{", TOKEN_LCURLY) \
+	X("}", TOKEN_RCURLY) \
+	X("[", TOKEN_LSQUARE) \
+	X("]", TOKEN_RSQUARE) \
+	X(";", TOKEN_SEMICOLON) \
+	X(",", TOKEN_COMMA) \
+	X(".", TOKEN_PERIOD) \
+	X("!", TOKEN_LOGIC_NOT) \
+	X("!=", TOKEN_COMP_NE) \
+	X(">", TOKEN_COMP_GT) \
+	X(">=", TOKEN_COMP_GE) \
+	X("<", TOKEN_COMP_LT) \
+	X("<=", TOKEN_COMP_LE) \
+	X("=", TOKEN_ASSIGN) \
+	X("==", TOKEN_COMP_EQ) \
+	X("|", TOKEN_BIT_OR) \
+	X("||", TOKEN_LOGIC_OR) \
+	X("&", TOKEN_AMPERSAND) \
+	X("&&", TOKEN_LOGIC_AND) \
+	X("*", TOKEN_STAR) \
+	X("*=", TOKEN_MUL_ASSIGN) \
+	X("/", TOKEN_FSLASH) \
+	X("/=", TOKEN_DIV_ASSIGN) \
+	X("+", TOKEN_PLUS) \
+	X("+=", TOKEN_ADD_ASSIGN) \
+	X("-", TOKEN_MINUS) \
+	X("-=", TOKEN_SUB_ASSIGN) \
+	X("->", TOKEN_ARROW)
+
+#define OP_STATE_MAX 64
+static uint8_t op_next[OP_STATE_MAX][256]; // 0 == no transition, 0 is also the start state
+static uint8_t op_accept[OP_STATE_MAX]; // TokenType
+static bool op_ready;
+
+// Not thread safe, called before lexer_tokenize starts any threads
+static void op_table_init(void)
 {
-	return isalnum(c) || c == '_' || c == '@';
+	if(op_ready) return;
+
+	static const struct {
+		const char *str;
+		TokenType type;
+	} ops[] = {
+#define X(str, type) {str, type},
+		OPERATOR_LIST
+#undef X
+	};
+
+	uint8_t states = 1;
+	for(size_t i = 0; i < (sizeof ops) / (sizeof ops[0]); i++) {
+		uint8_t state = 0;
+		for(const char *c = ops[i].str; *c; c++) {
+			uint8_t *next = &op_next[state][(unsigned char)*c];
+			if(!*next) *next = states++;
+			state = *next;
+		}
+		op_accept[state] = ops[i].type;
+	}
+
+	op_ready = true;
 }
 
-static void backup(
-	Lexer *lex,
-	size_t *pos,
-	uint32_t *line,
-	uint32_t *col,
-	uint32_t prev_col
-)
+// Longest operator starting with first (already read), TOKEN_NONE if there isn't one
+static TokenType lex_operator(Lexer const *lex, size_t *pos, char first)
 {
-	if(lex->file_contents[--*pos] == '\n') {
-		--*line;
-		*col = prev_col;
-	} else {
-		--*col;
+	uint8_t state = op_next[0][(unsigned char)first];
+	if(!state) return TOKEN_NONE;
+
+	for(size_t left = remaining(lex, *pos); left; left--) {
+		uint8_t next = op_next[state][(unsigned char)lex->file_contents[*pos]];
+		if(!next) break;
+		state = next;
+		*pos += 1;
 	}
+
+	return op_accept[state];
 }
 
-static int lex_char(
-	Lexer *lex,
-	size_t *pos,
-	uint32_t *line,
-	uint32_t *col,
-	uint32_t *prev_col,
-	Error *err
-)
+static void backup(size_t *pos)
 {
-	int c = get_char(lex, pos, line, col, prev_col);
+	--*pos;
+}
+
+static int lex_char(Lexer *lex, size_t *pos, Error *err)
+{
+	int c = get_char(lex, pos);
 
 	if(c == '\\') {
-		c = get_char(lex, pos, line, col, prev_col);
+		c = get_char(lex, pos);
 		switch(c) {
 		case 'n':
 			c = '\n';
 			break;
 		default:
-			fprintf(
-				stderr,
-				"Illegal Escape Sequence '\\%c' at ",
-				c
-			);
-			lexer_print_debug_to_file(
-				stderr,
-				&(DebugInfo) {lex->file_path, *line, *col}
-			);
-			fprintf(stderr, "\n");
+			if(!lex->quiet) {
+				fprintf(
+					stderr,
+					"Illegal Escape Sequence '\\%c' at ",
+					c
+				);
+				lexer_print_debug_to_file(
+					stderr,
+					&(DebugInfo) {lex->base + *pos - 1, lex->file}
+				);
+				fprintf(stderr, "\n");
+			}
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
@@ -147,503 +344,751 @@ RET:
 	return c;
 }
 
-static Token lex_string(
+// Interned first, so their ids match ID_BUILTIN_*
+static const char *primitive_types[] = {
+	"~NONE~",
+	"u8",
+	"s8",
+	"u16",
+	"s16",
+	"u32",
+	"s32",
+	"u64",
+	"s64",
+	"void",
+	"bool",
+	"ptr",
+	"len",
+};
+static const int primitive_type_count = (sizeof primitive_types) / (sizeof primitive_types[0]);
+
+// get_char never hands out the last byte, so that's where EOF is
+static uint32_t eof_offset(Lexer const *lex)
+{
+	return lex->file_length ? lex->file_length - 1 : 0;
+}
+
+// A token on its way into Tokens
+typedef struct {
+	TokenType type;
+	uint32_t offset;
+	uint32_t val;
+	intmax_t int_val; // TOKEN_INT_LIT only
+} LexToken;
+
+typedef struct {
+	DynArr types; // uint8_t
+	DynArr locs; // uint32_t
+	DynArr vals; // uint32_t
+	DynArr ints; // intmax_t
+} TokenBuilder;
+
+static void token_push(TokenBuilder *tb, LexToken const *tok, Error *err)
+{
+	uint32_t val = tok->val;
+	if(tok->type == TOKEN_INT_LIT) {
+		if(tok->int_val >= 0 && tok->int_val < TOKEN_INT_BIG) {
+			val = tok->int_val;
+		} else {
+			val = TOKEN_INT_BIG | tb->ints.count;
+			dynarr_push(&tb->ints, &tok->int_val, err);
+			if(*err) goto RET;
+		}
+	}
+
+	dynarr_push(&tb->types, &(uint8_t) {tok->type}, err);
+	if(*err) goto RET;
+	dynarr_push(&tb->locs, &tok->offset, err);
+	if(*err) goto RET;
+	dynarr_push(&tb->vals, &val, err);
+	if(*err) goto RET;
+RET:
+	return;
+}
+
+static LexToken lex_string(
 	Lexer *lex,
-	DynArr *strings,
+	InternTable *strings,
 	DynArr *string_builder,
 	size_t *pos,
-	uint32_t *line,
-	uint32_t *col,
-	uint32_t *prev_col,
 	Error *err
 )
 {
 	string_builder->count = 0;
-	Token tok = {
-		.debug = {
-			.debug_info = (DebugInfo) {
-				.file = lex->file_path,
-				.line = *line,
-				.col = *col,
-			}
-		}
+	LexToken tok = {
+		.offset = lex->base + *pos - 1,
 	};
 
-	int c = lex_char(lex, pos, line, col, prev_col, err);
-	if(*err) goto RET;
+	// Strings without escapes are interned straight from the source,
+	// string_builder is only needed once an escape changes the bytes.
+	size_t start = *pos;
+	bool escaped = false;
 
-	while(c != '"' && c != EOF) {
-		dynarr_push(string_builder, &c, err);
+	int c = EOF;
+	while(true) {
+		if(!escaped && *pos < lex->file_length && lex->file_contents[*pos] == '\\') {
+			escaped = true;
+			dynarr_alloc(string_builder, *pos - start, err);
+			if(*err) goto RET;
+			memcpy(string_builder->data, lex->file_contents + start, *pos - start);
+		}
+
+		c = lex_char(lex, pos, err);
 		if(*err) goto RET;
-		c = lex_char(lex, pos, line, col, prev_col, err);
-	   	if(*err) goto RET;
-	}
-	dynarr_push(string_builder, &(char){'\0'}, err);
-	if(*err) goto RET;
+		if(c == '"' || c == EOF) break;
 
-	size_t id = SIZE_MAX;
-	for(size_t i =0; i < strings->count; i++) {
-		if(
-			strcmp(
-				string_builder->data,
-				*(char**)dynarr_at(strings, i)
-			) == 0
-		) {
-			id = i;
-			break;
+		if(escaped) {
+			dynarr_push(string_builder, &(char) {c}, err);
+			if(*err) goto RET;
 		}
 	}
-	if(id == SIZE_MAX) {
-		id = strings->count;
-		char *str = malloc(string_builder->count);
-		CHECK_MALLOC(str);
-		strcpy(str, string_builder->data);
-		dynarr_push(strings, &str, err);
-		if(*err) goto RET;
-	}
 
-	tok.string_lit.type = TOKEN_STRING_LIT;
-	tok.string_lit.id = id;
+	size_t id = escaped
+		? intern(strings, string_builder->data, string_builder->count, err)
+		: intern(strings, lex->file_contents + start, *pos - 1 - start, err);
+	if(*err) goto RET;
+
+	tok.type = TOKEN_STRING_LIT;
+	tok.val = id;
 
 RET:
 	return tok;
 }
 
-void lexer_tokenize(
+static void token_builder_init(TokenBuilder *tb)
+{
+	dynarr_init(&tb->types, sizeof(uint8_t));
+	dynarr_init(&tb->locs, sizeof(uint32_t));
+	dynarr_init(&tb->vals, sizeof(uint32_t));
+	dynarr_init(&tb->ints, sizeof(intmax_t));
+}
+
+static void token_builder_clean(TokenBuilder const *tb)
+{
+	dynarr_clean(&tb->types);
+	dynarr_clean(&tb->locs);
+	dynarr_clean(&tb->vals);
+	dynarr_clean(&tb->ints);
+}
+
+// Lexes the token at *cursor into out, and moves past it.
+// Returns false once only whitespace is left, the EOF token is up to the caller.
+static bool lex_next(
 	Lexer *lex,
-	Token **tokens, size_t *token_count,
-	char ***identifiers, size_t *identifier_count,
-	char ***strings, size_t *string_count,
+	size_t *cursor,
+	LexToken *out,
+	InternTable *idents,
+	InternTable *strs,
+	DynArr *string_builder,
 	Error *err
 )
 {
-	DynArr toks;
-	DynArr idents;
-	DynArr strs;
-	dynarr_init(&toks, sizeof(Token));
-	dynarr_init(&idents, sizeof(char *));
-	dynarr_init(&strs, sizeof(char *));
+	size_t pos = *cursor;
+	bool more = false;
+	if(pos >= lex->file_length) goto RET;
 
-	size_t pos = 0;
-	uint32_t line = 1;
-	uint32_t col = 1;
-	uint32_t prev_col = 1;
-
-	const char *primitive_types[] = {
-		"~NONE~",
-		"u8",
-		"s8",
-		"u16",
-		"s16",
-		"u32",
-		"s32",
-		"u64",
-		"s64",
-		"void",
-		"bool",
-		"ptr",
-		"len",
-	};
-	const int primitive_type_count = (sizeof primitive_types) / (sizeof primitive_types[0]);
-
-	for(int i = 0; i < primitive_type_count; i++) {
-		char *str = malloc(strlen(primitive_types[i]) + 1);
-		CHECK_MALLOC(str);
-		strcpy(str, primitive_types[i]);
-		dynarr_push(&idents, &str, err);
-		if(*err) goto RET;
-	} 
-
-	DynArr string_builder;
-	dynarr_init(&string_builder, sizeof(char));
+	int c = skip_whitespace(lex, &pos);
+	if(c == EOF) goto RET;
+	more = true;
 
-	while(pos < lex->file_length) {
-		int c = skip_whitespace(lex, &pos, &line, &col, &prev_col);
-		if(c == EOF) {
-			goto RET;
-		}
-
-		string_builder.count = 0;
-		Token tok = (Token) {
-			.debug = {
-				.type = TOKEN_NONE,
-				.debug_info.line = line,
-				.debug_info.col = col,
-				.debug_info.file = lex->file_path,
-			}
-		};
+	size_t start = pos - 1;
+	char first = c;
+	LexToken tok = {
+		.type = TOKEN_NONE,
+		.offset = lex->base + start,
+	};
 
-		dynarr_push(&string_builder, &c, err);
-		if(*err) goto RET;
+	tok.type = lex_operator(lex, &pos, first);
+	if(tok.type != TOKEN_NONE) goto NEXT_TOK;
 
-		switch(*(char *)dynarr_at(&string_builder, 0)) {
-		case '!':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_COMP_NE;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_LOGIC_NOT;
-			goto NEXT_TOK;
-		case ':':
-			tok.type = TOKEN_COLON;
-			goto NEXT_TOK;
-		case '(':
-			tok.type = TOKEN_LPAREN;
-			goto NEXT_TOK;
-		case ')':
-			tok.type = TOKEN_RPAREN;
-			goto NEXT_TOK;
-		case '>':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_COMP_GE;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_COMP_GT;
-			goto NEXT_TOK;
-		case '<':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_COMP_LE;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_COMP_LT;
-			goto NEXT_TOK;
-		case '=':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_COMP_EQ;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_ASSIGN;
-			goto NEXT_TOK;
-		case '|':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '|') {
-				tok.type = TOKEN_LOGIC_OR;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_BIT_OR;
-			goto NEXT_TOK;
-		case '{':
-			tok.type = TOKEN_LCURLY;
-			goto NEXT_TOK;
-		case '}':
-			tok.type = TOKEN_RCURLY;
-			goto NEXT_TOK;
-		case ';':
-			tok.type = TOKEN_SEMICOLON;
-			goto NEXT_TOK;
-		case '*':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_MUL_ASSIGN;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_STAR;
-			goto NEXT_TOK;
-		case '/':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_DIV_ASSIGN;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_FSLASH;
-			goto NEXT_TOK;
-		case '+':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_ADD_ASSIGN;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_PLUS;
-			goto NEXT_TOK;
-		case '-':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '=') {
-				tok.type = TOKEN_SUB_ASSIGN;
-				goto NEXT_TOK;
-			} else if(c == '>') {
-				tok.type = TOKEN_ARROW;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_MINUS;
-			goto NEXT_TOK;
-		case ',':
-			tok.type = TOKEN_COMMA;
-			goto NEXT_TOK;
-		case '&':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '&') {
-				tok.type = TOKEN_LOGIC_AND;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			tok.type = TOKEN_AMPERSAND;
-			goto NEXT_TOK;
-		case '[':
-			tok.type = TOKEN_LSQUARE;
-			goto NEXT_TOK;
-		case ']':
-			tok.type = TOKEN_RSQUARE;
-			goto NEXT_TOK;
-		case '.':
-			tok.type = TOKEN_PERIOD;
-			goto NEXT_TOK;
-		case 'c':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '"') {
-				tok = lex_string(
-					lex,
-					&strs,
-					&string_builder,
-					&pos,
-					&line,
-					&col,
-					&prev_col,
-					err
-				);
-				if(*err) goto RET;
-				tok.type = TOKEN_CSTRING_LIT;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			c = 'c';
-			break;
-		case 'z':
-			c = get_char(lex, &pos, &line, &col, &prev_col);
-			if(c == '"') {
-				tok = lex_string(
-					lex,
-					&strs,
-					&string_builder,
-					&pos,
-					&line,
-					&col,
-					&prev_col,
-					err
-				);
-				if(*err) goto RET;
-				tok.type = TOKEN_ZSTRING_LIT;
-				goto NEXT_TOK;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			c = 'z';
-			break;
-		case '"':
+	switch(first) {
+	case 'c':
+		c = get_char(lex, &pos);
+		if(c == '"') {
 			tok = lex_string(
 				lex,
-				&strs,
-				&string_builder,
+				strs,
+				string_builder,
 				&pos,
-				&line,
-				&col,
-				&prev_col,
 				err
 			);
 			if(*err) goto RET;
+			tok.type = TOKEN_CSTRING_LIT;
 			goto NEXT_TOK;
-		case '\'':
-			tok.type = TOKEN_CHAR_LIT;
-			tok.char_lit.val = lex_char(lex, &pos, &line, &col, &prev_col, err);
+		}
+		backup(&pos);
+		c = 'c';
+		break;
+	case 'z':
+		c = get_char(lex, &pos);
+		if(c == '"') {
+			tok = lex_string(
+				lex,
+				strs,
+				string_builder,
+				&pos,
+				err
+			);
 			if(*err) goto RET;
-			if((c = get_char(lex, &pos, &line, &col, &prev_col)) != '\'') {
-				wyrt_diag(
-					stderr, NULL, NULL, NULL,
-					"Expected single-quote to end char literal at %l\n",
-					&tok.debug.debug_info
-				);
-				*err = ERROR_UNEXPECTED_DATA;
-				goto RET;
-			}
+			tok.type = TOKEN_ZSTRING_LIT;
 			goto NEXT_TOK;
-		default:
-			break;
 		}
+		backup(&pos);
+		c = 'z';
+		break;
+	case '"':
+		tok = lex_string(
+			lex,
+			strs,
+			string_builder,
+			&pos,
+			err
+		);
+		if(*err) goto RET;
+		goto NEXT_TOK;
+	case '\'':
+		tok.type = TOKEN_CHAR_LIT;
+		tok.val = (char) lex_char(lex, &pos, err);
+		if(*err) goto RET;
+		if((c = get_char(lex, &pos)) != '\'') {
+			if(!lex->quiet) wyrt_diag(
+				stderr, NULL, NULL, NULL,
+				"Expected single-quote to end char literal at %l\n",
+				&(DebugInfo) {tok.offset, lex->file}
+			);
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
+		}
+		goto NEXT_TOK;
+	default:
+		break;
+	}
 
-		if(isdigit(*(char *)dynarr_at(&string_builder, 0))) {
-			intmax_t val = *(char *)dynarr_at(&string_builder, 0) - '0';
-			while(
-				isdigit(
-					c = get_char(lex, &pos, &line, &col, &prev_col)
-				)
-			) {
-				val *= 10;
-				val += c - '0';
-			}
-			if(isalpha(c)) {
+	if(isdigit(first)) {
+		intmax_t val = first - '0';
+		size_t run = lex->scan->digits(lex->file_contents + pos, remaining(lex, pos));
+		for(size_t i = 0; i < run; i++) {
+			val *= 10;
+			val += lex->file_contents[pos + i] - '0';
+		}
+		pos += run;
+
+		c = get_char(lex, &pos);
+		if(isalpha(c)) {
+			if(!lex->quiet) {
 				fprintf(stderr, "Invalid Integer Literal at ");
-				lexer_print_debug_to_file(stderr, &tok.debug.debug_info);
+				lexer_print_debug_to_file(stderr, &(DebugInfo) {tok.offset, lex->file});
 				fputc('\n', stderr);
-				*err = ERROR_UNEXPECTED_DATA;
-				goto RET;
 			}
-
-			tok.type = TOKEN_INT_LIT;
-			tok.int_lit.val = val;
-			backup(lex, &pos, &line, &col, prev_col);
-			goto NEXT_TOK;
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
 		}
 
-		if(isalpha(c) || c == '_' || c == '@') {
-			while(
-				is_valid_in_identifier(
-					c = get_char(lex, &pos, &line, &col, &prev_col)
-				)
-				&& c != EOF
-			) {
-				dynarr_push(&string_builder, &c, err);
-				if(*err) goto RET;
-			}
-			backup(lex, &pos, &line, &col, prev_col);
-			if(string_builder.count == 1) {
-				if(*(char*)dynarr_at(&string_builder, 0) == '_') {
-					tok.type = TOKEN_UNDERSCORE;
-					goto NEXT_TOK;
-				}
-			}
-			dynarr_push(&string_builder, &(char){'\0'}, err);
-			if(*err) goto RET;
-
-			if(strcmp(string_builder.data, "return") == 0) {
-				tok.type = TOKEN_RETURN;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "const") == 0) {
-				tok.type = TOKEN_CONST;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "fn") == 0) {
-				tok.type = TOKEN_FN;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "var") == 0) {
-				tok.type = TOKEN_VAR;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "abyss") == 0) {
-				tok.type = TOKEN_ABYSS;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "struct") == 0) {
-				tok.type = TOKEN_STRUCT;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "discard") == 0) {
-				tok.type = TOKEN_DISCARD;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "typedef") == 0) {
-				tok.type = TOKEN_TYPEDEF;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "if") == 0) {
-				tok.type = TOKEN_IF;
-				goto NEXT_TOK;
-			} else if(strcmp(string_builder.data, "else") == 0) {
-				tok.type = TOKEN_ELSE;
-				goto NEXT_TOK;
-			}
+		tok.type = TOKEN_INT_LIT;
+		tok.int_val = val;
+		backup(&pos);
+		goto NEXT_TOK;
+	}
 
-			bool found = false;
-			size_t id;
-			for(size_t i = 0; i < idents.count; i++) {
-				if(
-					strcmp(
-						string_builder.data,
-						*(char **)dynarr_at(&idents, i)
-					) == 0
-				) {
-					found = true;
-					id = i;
-				}
-			}
-			if(!found) {
-				id = idents.count;
-				char *identifier = malloc(string_builder.count);
-				CHECK_MALLOC(identifier);
-				strcpy(identifier, string_builder.data);
-				dynarr_push(&idents, &identifier, err);
-				if(*err) goto RET;
-			}
+	if(isalpha(c) || c == '_' || c == '@') {
+		size_t run = lex->scan->ident(lex->file_contents + pos, remaining(lex, pos));
+		pos += run;
 
-			tok.ident.id = id;
-			tok.type = TOKEN_IDENT;
+		const char *ident = lex->file_contents + start;
+		size_t len = pos - start;
+		if(len == 1 && first == '_') {
+			tok.type = TOKEN_UNDERSCORE;
 			goto NEXT_TOK;
 		}
 
-		if(c == '#') {
-			string_builder.count = 0;
-			while(
-				is_valid_in_identifier(
-					c = get_char(lex, &pos, &line, &col, &prev_col)
-				)
-				&& c != EOF
-			) {
-				dynarr_push(&string_builder, &c, err);
-				if(*err) goto RET;
-			}
-			dynarr_push(&string_builder, &(char) {'\0'}, err);
-			if(*err) goto RET;
+		tok.type = keyword_lookup(ident, len);
+		if(tok.type != TOKEN_IDENT) goto NEXT_TOK;
 
-			backup(lex, &pos, &line, &col, prev_col);
+		size_t id = intern(idents, ident, len, err);
+		if(*err) goto RET;
 
-			if(strcmp(string_builder.data, "extern") == 0) {
-				tok.type = TOKEN_HASH_EXTERN;
-			} else {
+		tok.val = id;
+		tok.type = TOKEN_IDENT;
+		goto NEXT_TOK;
+	}
+
+	if(c == '#') {
+		size_t run = lex->scan->ident(lex->file_contents + pos, remaining(lex, pos));
+		pos += run;
+
+		const char *directive = lex->file_contents + start + 1;
+		size_t len = pos - start - 1;
+
+		if(view_eq(directive, len, "extern")) {
+			tok.type = TOKEN_HASH_EXTERN;
+		} else {
+			if(!lex->quiet) {
 				fprintf(
 					stderr,
-					"Illegal Directive '#%s' at ",
-					(char*)string_builder.data
+					"Illegal Directive '#%.*s' at ",
+					(int)len,
+					directive
 				);
-				lexer_print_debug_to_file(stderr, &tok.debug.debug_info);
+				lexer_print_debug_to_file(stderr, &(DebugInfo) {tok.offset, lex->file});
 				fprintf(stderr, "\n");
-				*err = ERROR_UNEXPECTED_DATA;
 			}
-			goto NEXT_TOK;
+			*err = ERROR_UNEXPECTED_DATA;
 		}
+		goto NEXT_TOK;
+	}
 
 NEXT_TOK:
-		dynarr_push(&toks, &tok, err);
+	*out = tok;
+RET:
+	*cursor = pos;
+	return more;
+}
+
+// Lexes everything but the final EOF, of the whole file or of one chunk
+static void lex_range(
+	Lexer *lex,
+	TokenBuilder *toks,
+	InternTable *idents,
+	InternTable *strs,
+	Error *err
+)
+{
+	DynArr string_builder;
+	dynarr_init(&string_builder, sizeof(char));
+
+	size_t pos = 0;
+	LexToken tok;
+	while(lex_next(lex, &pos, &tok, idents, strs, &string_builder, err) && !*err) {
+		token_push(toks, &tok, err);
+		if(*err) break;
+	}
+
+	dynarr_clean(&string_builder);
+}
+
+/*
+ * Parallel Lexing
+ * The file is split after newlines that aren't inside a string or char
+ * literal, so no token spans two chunks. Each chunk is lexed on its own
+ * thread, into its own TokenBuilder and InternTables, by a copy of the lexer
+ * whose file_contents starts at the chunk (Lexer.base puts the offsets back).
+ * The chunks are then merged in order. Ids are handed out by first occurrence,
+ * so interning each chunk's strings into the final tables in chunk order gives
+ * every string the id the serial lexer would have given it.
+ */
+
+#define LEX_CHUNK_MIN (256 * 1024) // Smaller files aren't worth a thread
+#define LEX_JOBS_MAX 64
+
+typedef struct {
+	Lexer lex;
+	TokenBuilder toks;
+	InternTable idents;
+	InternTable strs;
+	Error err;
+} LexChunk;
+
+// Fills bounds[0..count] with chunk boundaries and returns count (<= jobs).
+// Mirrors lex_string/lex_char only as far as valid input goes; if a literal
+// is malformed the chunk it lands in fails, and lexer_tokenize starts over.
+static size_t lexer_split(Lexer const *lex, size_t *bounds, size_t jobs)
+{
+	const char *src = lex->file_contents;
+	size_t len = lex->file_length;
+	size_t count = 0;
+	bounds[0] = 0;
+
+	for(size_t i = 0; i < len && count + 1 < jobs; i++) {
+		switch(src[i]) {
+		case '"':
+			for(i++; i < len && src[i] != '"'; i++) {
+				if(src[i] == '\\') i++;
+			}
+			break;
+		case '\'':
+			// 'c' or '\n', leaves i on the closing quote
+			i += i + 1 < len && src[i + 1] == '\\' ? 3 : 2;
+			break;
+		case '\n':
+			if(i + 1 >= len / jobs * (count + 1)) bounds[++count] = i + 1;
+			break;
+		}
+	}
+
+	bounds[++count] = len;
+	return count;
+}
+
+static void *lex_chunk(void *arg)
+{
+	LexChunk *chunk = arg;
+	lex_range(&chunk->lex, &chunk->toks, &chunk->idents, &chunk->strs, &chunk->err);
+	return NULL;
+}
+
+static void lex_chunks(LexChunk *chunks, size_t count)
+{
+#ifdef _WIN32
+	for(size_t i = 0; i < count; i++) lex_chunk(&chunks[i]);
+#else
+	pthread_t threads[LEX_JOBS_MAX];
+	bool started[LEX_JOBS_MAX];
+	for(size_t i = 1; i < count; i++) {
+		started[i] = !pthread_create(&threads[i], NULL, lex_chunk, &chunks[i]);
+	}
+
+	lex_chunk(&chunks[0]);
+
+	for(size_t i = 1; i < count; i++) {
+		// Couldn't get a thread, so it's done here instead
+		if(started[i]) pthread_join(threads[i], NULL);
+		else lex_chunk(&chunks[i]);
+	}
+#endif
+}
+
+// Appends a chunk's tokens, rewriting its local ids into the final tables
+static void lex_merge(
+	LexChunk const *chunk,
+	TokenBuilder *toks,
+	InternTable *idents,
+	InternTable *strs,
+	Error *err
+)
+{
+	size_t ident_count = chunk->idents.offsets.count;
+	size_t str_count = chunk->strs.offsets.count;
+	uint32_t *ids = malloc((ident_count + str_count + 1) * sizeof(uint32_t));
+	CHECK_MALLOC(ids);
+	uint32_t *ident_ids = ids;
+	uint32_t *str_ids = ids + ident_count;
+
+	for(size_t i = 0; i < ident_count; i++) {
+		size_t len;
+		const char *str = intern_get(&chunk->idents, i, &len);
+		ident_ids[i] = intern(idents, str, len, err);
+		if(*err) goto RET;
+	}
+	for(size_t i = 0; i < str_count; i++) {
+		size_t len;
+		const char *str = intern_get(&chunk->strs, i, &len);
+		str_ids[i] = intern(strs, str, len, err);
+		if(*err) goto RET;
+	}
+
+	size_t first = toks->types.count;
+	size_t count = chunk->toks.types.count;
+	size_t ints_base = toks->ints.count;
+	dynarr_append(&toks->types, chunk->toks.types.data, count, err);
+	if(*err) goto RET;
+	dynarr_append(&toks->locs, chunk->toks.locs.data, count, err);
+	if(*err) goto RET;
+	dynarr_append(&toks->vals, chunk->toks.vals.data, count, err);
+	if(*err) goto RET;
+	dynarr_append(&toks->ints, chunk->toks.ints.data, chunk->toks.ints.count, err);
+	if(*err) goto RET;
+
+	uint8_t const *types = (uint8_t*)toks->types.data + first;
+	uint32_t *vals = (uint32_t*)toks->vals.data + first;
+	for(size_t i = 0; i < count; i++) {
+		switch((TokenType) types[i]) {
+		case TOKEN_IDENT:
+			vals[i] = ident_ids[vals[i]];
+			break;
+		case TOKEN_STRING_LIT:
+		case TOKEN_ZSTRING_LIT:
+		case TOKEN_CSTRING_LIT:
+			vals[i] = str_ids[vals[i]];
+			break;
+		case TOKEN_INT_LIT:
+			if(vals[i] & TOKEN_INT_BIG) {
+				vals[i] = TOKEN_INT_BIG | (ints_base + (vals[i] & ~TOKEN_INT_BIG));
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+RET:
+	free(ids);
+}
+
+// Returns false, with the outputs untouched, if the file should be lexed
+// serially instead: it didn't split, or a chunk failed to lex.
+static bool lex_parallel(
+	Lexer *lex,
+	size_t jobs,
+	TokenBuilder *toks,
+	InternTable *idents,
+	InternTable *strs,
+	Error *err
+)
+{
+	bool ok = false;
+	size_t bounds[LEX_JOBS_MAX + 1];
+	LexChunk chunks[LEX_JOBS_MAX];
+
+	size_t count = lexer_split(lex, bounds, jobs);
+	if(count < 2) return false;
+
+	for(size_t i = 0; i < count; i++) {
+		LexChunk *chunk = &chunks[i];
+		chunk->lex = *lex;
+		chunk->lex.file_contents += bounds[i];
+		chunk->lex.file_length = bounds[i + 1] - bounds[i];
+		chunk->lex.base = bounds[i];
+		chunk->lex.quiet = true;
+		token_builder_init(&chunk->toks);
+		intern_init(&chunk->idents);
+		intern_init(&chunk->strs);
+		chunk->err = ERROR_OK;
+	}
+
+	lex_chunks(chunks, count);
+
+	for(size_t i = 0; i < count; i++) {
+		if(chunks[i].err) goto RET;
+	}
+
+	for(size_t i = 0; i < count; i++) {
+		lex_merge(&chunks[i], toks, idents, strs, err);
 		if(*err) goto RET;
 	}
+	ok = true;
 
 RET:
-	dynarr_push(
+	for(size_t i = 0; i < count; i++) {
+		token_builder_clean(&chunks[i].toks);
+		intern_clean(&chunks[i].idents);
+		intern_clean(&chunks[i].strs);
+	}
+	return ok;
+}
+
+void lexer_tokenize(
+	Lexer *lex,
+	Tokens *tokens,
+	char ***identifiers, size_t *identifier_count,
+	char ***strings, size_t *string_count,
+	Error *err
+)
+{
+	TokenBuilder toks;
+	InternTable idents;
+	InternTable strs;
+	token_builder_init(&toks);
+	intern_init(&idents);
+	intern_init(&strs);
+	op_table_init();
+
+	for(int i = 0; i < primitive_type_count; i++) {
+		intern(&idents, primitive_types[i], strlen(primitive_types[i]), err);
+		if(*err) goto RET;
+	}
+
+	size_t jobs = lex->jobs;
+	if(jobs > LEX_JOBS_MAX) jobs = LEX_JOBS_MAX;
+	if(jobs > lex->file_length / LEX_CHUNK_MIN) jobs = lex->file_length / LEX_CHUNK_MIN;
+
+	if(jobs > 1) {
+		bool done = lex_parallel(lex, jobs, &toks, &idents, &strs, err);
+		if(done || *err) goto RET;
+	}
+
+	lex_range(lex, &toks, &idents, &strs, err);
+
+RET:
+	token_push(
 		&toks,
-		&(Token) {
-			.debug = {
-				.type = TOKEN_EOF,
-				.debug_info = {
-					.file = lex->file_path,
-					.line = line,
-					.col = col,
-				},
-			},
+		&(LexToken) {
+			.type = TOKEN_EOF,
+			.offset = eof_offset(lex),
 		},
 		err
 	);
 
-	dynarr_clean(&string_builder);
-	*identifiers = (char **)idents.data;
-	*identifier_count = idents.count;
-	*strings = (char **)strs.data;
-	*string_count = strs.count;
-	*tokens = (Token *)toks.data;
-	*token_count = toks.count;
+	*identifier_count = idents.offsets.count;
+	*identifiers = intern_finish(&idents, err);
+	*string_count = strs.offsets.count;
+	*strings = intern_finish(&strs, err);
+	*tokens = (Tokens) {
+		.types = toks.types.data,
+		.locs = toks.locs.data,
+		.vals = toks.vals.data,
+		.ints = toks.ints.data,
+		.count = toks.types.count,
+		.file = lex->file,
+		.mask = SIZE_MAX,
+	};
 	return;
 }
 
+/*
+ * Streaming
+ * The parser only ever looks one token back or ahead, so instead of lexing
+ * the whole file up front, lex one token at a time into a ring of
+ * TOKEN_WINDOW tokens whenever tokens_at runs past what's been lexed.
+ */
+
+struct TokenStream {
+	Lexer *lex;
+	size_t pos;
+	bool done; // Every token after this is EOF
+	Error err;
+	InternTable idents;
+	InternTable strs;
+	DynArr string_builder;
+};
+
+void lexer_stream(Lexer *lex, Tokens *tokens, Error *err)
+{
+	op_table_init();
+	TokenStream *ts = malloc(sizeof(TokenStream));
+	CHECK_MALLOC(ts);
+	*ts = (TokenStream) {
+		.lex = lex,
+	};
+	intern_init(&ts->idents);
+	intern_init(&ts->strs);
+	dynarr_init(&ts->string_builder, sizeof(char));
+
+	*tokens = (Tokens) {
+		.types = malloc(TOKEN_WINDOW * sizeof(uint8_t)),
+		.locs = malloc(TOKEN_WINDOW * sizeof(uint32_t)),
+		.vals = malloc(TOKEN_WINDOW * sizeof(uint32_t)),
+		.ints = malloc(TOKEN_WINDOW * sizeof(intmax_t)),
+		.file = lex->file,
+		.mask = TOKEN_WINDOW - 1,
+		.stream = ts,
+	};
+	CHECK_MALLOC(tokens->types);
+	CHECK_MALLOC(tokens->locs);
+	CHECK_MALLOC(tokens->vals);
+	CHECK_MALLOC(tokens->ints);
+
+	for(int i = 0; i < primitive_type_count; i++) {
+		intern(&ts->idents, primitive_types[i], strlen(primitive_types[i]), err);
+		if(*err) goto RET;
+	}
+
+RET:
+	if(*err && ts) {
+		intern_clean(&ts->idents);
+		intern_clean(&ts->strs);
+		dynarr_clean(&ts->string_builder);
+		free(ts);
+		tokens->stream = NULL;
+	}
+	return;
+}
+
+void tokens_pull(Tokens *toks, size_t i)
+{
+	TokenStream *ts = toks->stream;
+	while(toks->count <= i) {
+		LexToken tok;
+		if(
+			ts->done
+			|| !lex_next(
+				ts->lex, &ts->pos, &tok,
+				&ts->idents, &ts->strs, &ts->string_builder,
+				&ts->err
+			)
+			|| ts->err
+		) {
+			ts->done = true;
+			tok = (LexToken) {
+				.type = TOKEN_EOF,
+				.offset = eof_offset(ts->lex),
+			};
+		}
+
+		// Big ints go in the same slot of ints instead of being appended
+		size_t slot = toks->count & toks->mask;
+		uint32_t val = tok.val;
+		if(tok.type == TOKEN_INT_LIT) {
+			if(tok.int_val >= 0 && tok.int_val < TOKEN_INT_BIG) {
+				val = tok.int_val;
+			} else {
+				val = TOKEN_INT_BIG | slot;
+				toks->ints[slot] = tok.int_val;
+			}
+		}
+
+		toks->types[slot] = tok.type;
+		toks->locs[slot] = tok.offset;
+		toks->vals[slot] = val;
+		toks->count += 1;
+	}
+}
+
+void lexer_stream_finish(
+	Tokens *tokens,
+	char ***identifiers, size_t *identifier_count,
+	char ***strings, size_t *string_count,
+	Error *err
+)
+{
+	TokenStream *ts = tokens->stream;
+	*err = ts->err;
+	*identifier_count = ts->idents.offsets.count;
+	*identifiers = intern_finish(&ts->idents, err);
+	*string_count = ts->strs.offsets.count;
+	*strings = intern_finish(&ts->strs, err);
+
+	dynarr_clean(&ts->string_builder);
+	free(ts);
+	tokens->stream = NULL;
+}
+
+void tokens_clean(Tokens const *toks)
+{
+	free(toks->types);
+	free(toks->locs);
+	free(toks->vals);
+	free(toks->ints);
+}
+
+intmax_t tokens_int(Tokens const *toks, size_t i)
+{
+	uint32_t val = toks->vals[i];
+	if(val & TOKEN_INT_BIG) return toks->ints[val & ~TOKEN_INT_BIG];
+	return val;
+}
+
+// Until a stream is finished its strings are only in the lexer's tables
+static void print_interned(
+	FILE *file,
+	const char *kind,
+	Tokens const *toks,
+	size_t i,
+	char *const *table
+)
+{
+	const char *str;
+	size_t len;
+	if(table) {
+		str = table[toks->vals[i]];
+		len = intern_len(table, toks->vals[i]);
+	} else {
+		InternTable const *it = toks->types[i] == TOKEN_IDENT
+			? &toks->stream->idents
+			: &toks->stream->strs;
+		str = intern_get(it, toks->vals[i], &len);
+	}
+	fprintf(file, "%s '%.*s'", kind, (int)len, str);
+}
+
 void lexer_print_token_to_file(
 	FILE *file,
-	Token const *tok,
+	Tokens const *toks,
+	size_t i,
 	char *const *identifiers,
 	char *const *strings
 )
 {
-	switch(tok->type) {
+	switch((TokenType) toks->types[i]) {
 	case TOKEN_NONE:
 		fputs("NONE", file);
 		break;
@@ -697,39 +1142,24 @@ void lexer_print_token_to_file(
 		break;
 	case TOKEN_ABYSS:
 		fputs("abyss", file);
+		break;
 	case TOKEN_IDENT:
-		fprintf(
-			file,
-			"Identifier '%s'",
-			id_get(identifiers, tok->ident.id)
-		);
+		print_interned(file, "Identifier", toks, i, identifiers);
 		break;
 	case TOKEN_INT_LIT:
-		fprintf(file, "Int '%ji'", tok->int_lit.val);
+		fprintf(file, "Int '%ji'", tokens_int(toks, i));
 		break;
 	case TOKEN_CHAR_LIT:
-		fprintf(file, "Char '%c'", tok->char_lit.val);
+		fprintf(file, "Char '%c'", (char) toks->vals[i]);
 		break;
 	case TOKEN_STRING_LIT:
-		fprintf(
-			file,
-			"String '%s'",
-			strings[tok->string_lit.id]
-		);
+		print_interned(file, "String", toks, i, strings);
 		break;
 	case TOKEN_ZSTRING_LIT:
-		fprintf(
-			file,
-			"ZString '%s'",
-			strings[tok->string_lit.id]
-		);
+		print_interned(file, "ZString", toks, i, strings);
 		break;
 	case TOKEN_CSTRING_LIT:
-		fprintf(
-			file,
-			"CString '%s'",
-			strings[tok->string_lit.id]
-		);
+		print_interned(file, "CString", toks, i, strings);
 		break;
 	case TOKEN_STAR:
 		fprintf(file, "'*'");
@@ -815,15 +1245,72 @@ void lexer_print_token_to_file(
 	}
 
 	fputs(" at ", file);
-	lexer_print_debug_to_file(file, &tok->debug.debug_info);
+	lexer_print_debug_to_file(file, &TOKEN_DEBUG(toks, i));
+}
+
+static void lexer_index_lines(Lexer *lex, Error *err)
+{
+	DynArr starts;
+	dynarr_init(&starts, sizeof(uint32_t));
+
+	dynarr_push(&starts, &(uint32_t) {0}, err);
+	if(*err) goto RET;
+
+	const char *contents = lex->file_contents;
+	const char *end = contents + lex->file_length;
+	const char *nl = contents;
+	while((nl = memchr(nl, '\n', end - nl))) {
+		nl++;
+		dynarr_push(&starts, &(uint32_t) {nl - contents}, err);
+		if(*err) goto RET;
+	}
+
+	lex->line_starts = starts.data;
+	lex->line_count = starts.count;
+RET:
+	if(*err) dynarr_clean(&starts);
+	return;
+}
+
+SourcePos lexer_locate(DebugInfo const *debug)
+{
+	SourcePos pos = {"<unknown>", 0, 0};
+	if(debug->file >= lexer_count || !lexers[debug->file]) goto RET;
+
+	Lexer *lex = lexers[debug->file];
+	pos.file = lex->file_path;
+
+	if(!lex->line_starts) {
+		Error err = ERROR_OK;
+		lexer_index_lines(lex, &err);
+		if(err) goto RET;
+	}
+
+	// Last line starting at or before offset
+	size_t lo = 0;
+	size_t hi = lex->line_count;
+	while(hi - lo > 1) {
+		size_t mid = lo + (hi - lo) / 2;
+		if(lex->line_starts[mid] <= debug->offset) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	pos.line = lo + 1;
+	pos.col = debug->offset - lex->line_starts[lo] + 1;
+RET:
+	return pos;
 }
 
 void lexer_print_debug_to_file(FILE *file, DebugInfo const *debug)
 {
+	SourcePos pos = lexer_locate(debug);
 	fprintf(
 		file,
 		"%s:%"PRIu32":%"PRIu32,
-		debug->file, debug->line, debug->col
+		pos.file, pos.line, pos.col
 	);
 }
 
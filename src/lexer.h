@@ -1,5 +1,6 @@
 #pragma once
 #include "util.h"
+#include "scan.h"
 
 typedef uint32_t Id;
 enum {
@@ -95,68 +96,107 @@ typedef enum {
 	TOKEN_ELSE
 } TokenType;
 
+// Stored in every AstNode (and Tokens has it split up), see lexer_locate for line and column
+typedef struct {
+	uint32_t offset; // Byte offset into the source file
+	uint32_t file; // Lexer.file of the source file
+} DebugInfo;
+
 typedef struct {
 	char *file;
 	uint32_t line;
 	uint32_t col;
-} DebugInfo;
-
-typedef union {
-	TokenType type;
-
-	struct {
-		TokenType type;
-		DebugInfo debug_info;
-	} debug;
-
-	struct {
-		TokenType type;
-		DebugInfo debug_info;
-		Id id;
-	} ident;
-
-	struct {
-		TokenType type;
-		DebugInfo debug_info;
-		intmax_t val;
-	} int_lit;
-
-	struct {
-		TokenType type;
-		DebugInfo debug_info;
-		size_t id;
-	} string_lit;
-
-	struct {
-		TokenType type;
-		DebugInfo debug_info;
-		char val;
-	} char_lit;
-} Token;
+} SourcePos;
+
+/*
+ * Token stream, stored as parallel arrays indexed by token.
+ * vals holds the Id of an identifier, the id of a string literal, the value of
+ * a char literal, or the value of an int literal. Int literals that don't fit
+ * in 31 bits store (TOKEN_INT_BIG | index into ints) instead.
+ *
+ * When streamed (see lexer_stream) the arrays are a ring of TOKEN_WINDOW
+ * tokens that is lexed into as the parser asks for tokens. Only
+ * index into them with tokens_at.
+ */
+#define TOKEN_INT_BIG 0x80000000u
+#define TOKEN_WINDOW 16 // Power of 2, the parser looks at most one token back
+typedef struct TokenStream TokenStream;
+typedef struct {
+	uint8_t *types; // TokenType
+	uint32_t *locs; // DebugInfo.offset
+	uint32_t *vals;
+	intmax_t *ints;
+	size_t count; // Lexed so far, if streaming
+	uint32_t file; // DebugInfo.file, the same for every token
+	size_t mask; // Token i is at [i & mask]
+	TokenStream *stream; // NULL unless streaming
+} Tokens;
+
+void tokens_clean(Tokens const *toks);
+intmax_t tokens_int(Tokens const *toks, size_t i);
+void tokens_pull(Tokens *toks, size_t i);
+
+// Where token i is in toks' arrays. Lexes up to it first, if streaming.
+static inline size_t tokens_at(Tokens *toks, size_t i)
+{
+	if(i >= toks->count && toks->stream) tokens_pull(toks, i);
+	return i & toks->mask;
+}
+
+// Evaluates to an lvalue, so &TOKEN_DEBUG(...) is fine
+#define TOKEN_DEBUG(toks, i) ((DebugInfo) {(toks)->locs[i], (toks)->file})
 
 typedef struct {
-	char *file_contents;
+	const char *file_contents;
 	size_t file_length;
 	char *file_path;
+	bool mapped; // file_contents is a read-only mmap of the input
+	Scanner const *scan;
+	uint32_t file; // Index of this lexer, for DebugInfo.file
+	unsigned jobs; // Threads lexer_tokenize may use, see lexer_split
+
+	// Only set on the per-chunk copies of a parallel lexer_tokenize
+	size_t base; // Offset of file_contents into the whole file
+	bool quiet; // Don't print errors, the serial retry will
+
+	// Built the first time a location in this file is resolved
+	uint32_t *line_starts;
+	size_t line_count;
 } Lexer;
 
 void lexer_init(Lexer *lex, char *file_path, Error *err);
 void lexer_clean(Lexer *lex);
-void lexer_clean_strings(char **identifiers, size_t identifier_count);
+void lexer_clean_strings(char **strings);
 
 void lexer_tokenize(
 	Lexer *lex,
-	Token **tokens, size_t *token_count,
+	Tokens *tokens,
+	char ***identifiers, size_t *identifier_count,
+	char ***strings, size_t *string_count,
+	Error *err
+);
+
+// Lexes on demand instead of up front, so memory for tokens stays constant.
+// identifiers and strings are only finished by lexer_stream_finish, which
+// reports any error the lexer ran into. Until then, tokens end at that error.
+void lexer_stream(Lexer *lex, Tokens *tokens, Error *err);
+void lexer_stream_finish(
+	Tokens *tokens,
 	char ***identifiers, size_t *identifier_count,
 	char ***strings, size_t *string_count,
 	Error *err
 );
 
+// identifiers and strings can be NULL while toks is still streaming
 void lexer_print_token_to_file(
 	FILE *file,
-	Token const *tok,
+	Tokens const *toks,
+	size_t i,
 	char *const *identifiers,
 	char *const *strings
 );
 
+// Lines and columns are 1-based.
+// Only valid while the lexer that produced debug hasn't been cleaned.
+SourcePos lexer_locate(DebugInfo const *debug);
 void lexer_print_debug_to_file(FILE *file, DebugInfo const *debug);
@@ -5,6 +5,8 @@
 #include "lexer.h"
 #include "parser.h"
 #include "codegen.h"
+#include "cache.h"
+#include "stats.h"
 
 #include "../config.h"
 
@@ -17,7 +19,12 @@ typedef struct {
 	bool do_not_link;
 	bool do_not_assemble;
 	bool debug;
+	bool stream_tokens;
+	bool ast_cache;
+	bool time_passes;
+	char *time_trace_file; // NULL == No trace
 	int opt_level;
+	int jobs;
 } CmdlineOptions;
 
 int match_arg(const char *query, const char *arg)
@@ -36,19 +43,24 @@ int main(int argc, char **argv)
 {
 	CmdlineOptions options = { 0 };
 	options.backend_path = backends[0].path;
+	options.jobs = 1;
 
 	Error err = ERROR_OK;
 
-	Token *tokens = NULL;
+	Tokens tokens = { 0 };
 	char **identifiers = NULL;
 	size_t identifier_count = 0;
 	char **strings = NULL;
 	size_t string_count = 0;
-	size_t token_count = 0;
 
 	Lexer lexer = { 0 };
 	Parser parser = { 0 };
 	CodeGen codegen = { 0 };
+	AstCache cache = { 0 };
+	char *cache_file = NULL;
+	uint64_t source_hash = 0;
+	Ast const *tree = &parser.tree;
+	size_t pass;
 
 	for(int i = 1; i < argc; i++) {
 		char garbage;
@@ -74,6 +86,11 @@ int main(int argc, char **argv)
 
 				"\t-g\t\t\t\t\t\tEmit Debug Symbols\n"
 				"\t-O<0,1,2,3>\t\t\t\t\tOptimization Level (0 = lowest, 3 = highest)\n"
+				"\t-j<N>\t\t\t\t\t\tLex and parse large files on up to <N> threads\n"
+				"\t--stream-tokens\t\t\t\t\tLex while parsing, keeping only a few tokens in memory\n"
+				"\t--ast-cache\t\t\t\t\tReuse the AST saved in <src>c if <src> hasn't changed\n"
+				"\t--time-passes\t\t\t\t\tPrint how long each phase took, and some counters\n"
+				"\t--time-trace=<path>\t\t\t\tWrite phase and per-function timings to <path> as a Chrome trace\n"
 
 				"\t--backend-path=<path>\t\t\t\tUse the Backend Dynamic Library at <path>\n"
 				"\t--backend=<name>\t\t\t\tUse a pre-configured backend\n"
@@ -100,6 +117,14 @@ int main(int argc, char **argv)
 				"--ast-dump=",
 				argv[i]
 			) + argv[i];
+		} else if(match_arg("--stream-tokens", argv[i])) {
+			options.stream_tokens = true;
+		} else if(match_arg("--ast-cache", argv[i])) {
+			options.ast_cache = true;
+		} else if(match_arg("--time-passes", argv[i])) {
+			options.time_passes = true;
+		} else if(match_arg("--time-trace=", argv[i])) {
+			options.time_trace_file = argv[i] + match_arg("--time-trace=", argv[i]);
 		} else if(match_arg("-S", argv[i])) {
 			options.do_not_assemble = true;
 			options.do_not_link = true;
@@ -130,6 +155,17 @@ int main(int argc, char **argv)
 				err = ERROR_UNEXPECTED_DATA;
 				goto RET;
 			}
+		} else if(match_arg("-j", argv[i])) {
+			if(!sscanf(argv[i], "-j%d", &options.jobs)) {
+				fprintf(stderr, "Expected integer after -j!\n");
+				err = ERROR_UNEXPECTED_DATA;
+				goto RET;
+			}
+			if(options.jobs < 1) {
+				fprintf(stderr, "Invalid Job Count '%d', need at least 1\n", options.jobs);
+				err = ERROR_UNEXPECTED_DATA;
+				goto RET;
+			}
 		} else if(match_arg("--backend=", argv[i])) {
 			bool found = false;
 			const char *name = argv[i] + match_arg("--backend=", argv[i]);
@@ -167,16 +203,63 @@ int main(int argc, char **argv)
 		goto RET;
 	}
 
+	if(options.time_passes || options.time_trace_file) {
+		stats_init(options.time_trace_file, &err);
+		if(err) goto RET;
+	}
+
+	pass = pass_begin("read source");
 	lexer_init(&lexer, options.src_file, &err);
+	pass_end(pass);
 	if(err) goto RET;
+	lexer.jobs = options.jobs;
+
+	if(options.ast_cache) {
+		pass = pass_begin("load AST cache");
+		cache_file = cache_path(options.src_file, &err);
+		if(err) goto RET;
+		source_hash = cache_hash(lexer.file_contents, lexer.file_length);
+
+		// Tokens aren't cached, so dumping them needs a fresh lex
+		bool hit = !options.token_dump_file
+			&& cache_load(
+				&cache,
+				cache_file,
+				source_hash,
+				lexer.file_length,
+				lexer.file,
+				&identifiers, &identifier_count,
+				&strings, &string_count,
+				&err
+			);
+		pass_end(pass);
+		if(hit) {
+			tree = &cache.tree;
+			goto PARSED;
+		}
+		if(err) goto RET;
+	}
+
+	// Streamed tokens are lexed as they're parsed, so that's timed as parsing
+	pass = pass_begin("lex");
 
-	lexer_tokenize(
-		&lexer,
-		&tokens, &token_count,
-		&identifiers, &identifier_count,
-		&strings, &string_count,
-		&err
-	);
+	if(options.stream_tokens) {
+		if(options.token_dump_file) {
+			fprintf(stderr, "Can't dump tokens while streaming them.\n");
+			err = ERROR_UNEXPECTED_DATA;
+			goto RET;
+		}
+		lexer_stream(&lexer, &tokens, &err);
+	} else {
+		lexer_tokenize(
+			&lexer,
+			&tokens,
+			&identifiers, &identifier_count,
+			&strings, &string_count,
+			&err
+		);
+	}
+	pass_end(pass);
 	if(err) goto RET;
 
 	if(options.token_dump_file) {
@@ -187,11 +270,12 @@ int main(int argc, char **argv)
 			goto RET;
 		}
 
-		printf("INFO: %zi Tokens.\n", token_count);
-		for(size_t i = 0; i < token_count; i++) {
+		printf("INFO: %zi Tokens.\n", tokens.count);
+		for(size_t i = 0; i < tokens.count; i++) {
 			lexer_print_token_to_file(
 				file,
-				&tokens[i],
+				&tokens,
+				i,
 				identifiers,
 				strings
 			);
@@ -200,11 +284,48 @@ int main(int argc, char **argv)
 		fclose(file);
 	}
 
-	parser_init(&parser, tokens, identifiers, strings);
+	parser_init(&parser, &tokens, identifiers, strings);
+	parser.jobs = options.jobs;
 
+	pass = pass_begin("parse");
 	parser_parse(&parser, &err);
+	if(parser.tokens.stream) {
+		// The lexer failing is what went wrong first, if it did
+		Error lex_err = ERROR_OK;
+		lexer_stream_finish(
+			&parser.tokens,
+			&identifiers, &identifier_count,
+			&strings, &string_count,
+			&lex_err
+		);
+		parser.identifiers = identifiers;
+		parser.strings = strings;
+		if(lex_err) err = lex_err;
+	}
+	pass_end(pass);
+	counters.tokens = parser.tokens.count;
 	if(err) goto RET;
 
+	if(options.ast_cache) {
+		pass = pass_begin("store AST cache");
+		// Only costs the next run a parse, so carry on without it
+		Error cache_err = ERROR_OK;
+		cache_store(
+			cache_file,
+			source_hash,
+			lexer.file_length,
+			tree,
+			identifiers, identifier_count,
+			strings, string_count,
+			&cache_err
+		);
+		if(cache_err) fprintf(stderr, "Unable to Write AST Cache '%s'.\n", cache_file);
+		pass_end(pass);
+	}
+
+PARSED:
+	counters.nodes = tree->len;
+
 	if(options.ast_dump_file) {
 		FILE *file = fopen(options.ast_dump_file, "w");
 		if(!file) {
@@ -213,8 +334,8 @@ int main(int argc, char **argv)
 			goto RET;
 		}
 
-		parser_print_ast(&parser, file);
-		printf("INFO: %zi AST Nodes.\n", parser.ast.len);
+		parser_print_ast(tree, identifiers, strings, file);
+		printf("INFO: %zi AST Nodes.\n", tree->len);
 		fclose(file);
 	}
 
@@ -227,16 +348,17 @@ int main(int argc, char **argv)
 	}
 
 	if(options.backend_path) {
+		pass = pass_begin("load backend");
 		codegen_init(
 			&codegen,
-			parser.ast.nodes,
-			parser.ast.len,
+			tree,
 			identifiers,
 			strings,
 			string_count,
 			options.backend_path,
 			&err
 		);
+		pass_end(pass);
 		if(err) goto RET;
 
 		GenOptions gen_options = 0;
@@ -246,6 +368,7 @@ int main(int argc, char **argv)
 		if(options.debug) gen_options += GEN_DBG;
 
 		gen_options += GEN_OPT1 * options.opt_level;
+		if(options.time_passes) gen_options += GEN_TIME;
 
 		codegen_gen(
 			&codegen,
@@ -257,11 +380,15 @@ int main(int argc, char **argv)
 	}
 
 RET:
+	if(options.time_passes) stats_report(stderr);
+	stats_finish();
 	lexer_clean(&lexer);
-	lexer_clean_strings(identifiers, identifier_count);
-	lexer_clean_strings(strings, string_count);
+	lexer_clean_strings(identifiers);
+	lexer_clean_strings(strings);
 	parser_clean(&parser);
-	if(tokens) free(tokens);
+	tokens_clean(&tokens);
 	codegen_clean(&codegen);
+	cache_clean(&cache);
+	free(cache_file);
 	return err;
 }
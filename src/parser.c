@@ -3,9 +3,24 @@
 #include "ui.h"
 
 #include <assert.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+// Token i of prs->tokens, which may be streamed (see tokens_at)
+#define TOK(i) tokens_at(&prs->tokens, (i))
+#define TOK_TYPE(i) prs->tokens.types[TOK(i)]
+#define TOK_VAL(i) prs->tokens.vals[TOK(i)]
+#define TOK_DEBUG(i) TOKEN_DEBUG(&prs->tokens, TOK(i))
+#define TOK_INT(i) tokens_int(&prs->tokens, TOK(i))
 
 void nodelist_alloc(NodeList *list, size_t n, Error *err)
 {
+	if(list->len + n > OFFSET_MAX) {
+		fprintf(stderr, "Too many AST Nodes, Offset can't reach them all.\n");
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
 	list->len += n;
 	if(list->len > list->cap) {
 		do {
@@ -16,6 +31,9 @@ void nodelist_alloc(NodeList *list, size_t n, Error *err)
 		CHECK_MALLOC(ptr);
 		list->nodes = ptr; 
 	}
+	// Statements are linked in before they're parsed, parse_recover relies on
+	// one that failed early still ending its chain
+	memset(&list->nodes[list->len - n], 0, n * sizeof(AstNode));
 
 RET:
 	return;
@@ -35,6 +53,42 @@ AstNode nodelist_pop(NodeList *list)
 	return list->nodes[--list->len];
 }
 
+void ast_pack(Ast *ast, NodeList const *list, Error *err)
+{
+	*ast = (Ast) {
+		.types = malloc(list->len),
+		.locs = malloc(sizeof(uint32_t) * list->len),
+		.next = malloc(sizeof(Offset) * list->len),
+		.data = malloc(sizeof(AstPayload) * list->len),
+		.len = list->len,
+		.file = list->len ? list->nodes[0].com.debug.file : 0,
+	};
+	CHECK_MALLOC(ast->types);
+	CHECK_MALLOC(ast->locs);
+	CHECK_MALLOC(ast->next);
+	CHECK_MALLOC(ast->data);
+
+	for(size_t i = 0; i < list->len; i++) {
+		AstNode const *node = &list->nodes[i];
+		assert(node->com.debug.file == ast->file);
+		ast->types[i] = node->type;
+		ast->locs[i] = node->com.debug.offset;
+		ast->next[i] = node->com.next;
+		memcpy(&ast->data[i], (char const*)node + sizeof(AstNodeCommon), sizeof(AstPayload));
+	}
+
+RET:
+	return;
+}
+
+void ast_clean(Ast const *ast)
+{
+	free(ast->types);
+	free(ast->locs);
+	free(ast->next);
+	free(ast->data);
+}
+
 void parsestack_alloc(ParseStack *ps, size_t n, Error *err)
 {
 	ps->len += n;
@@ -43,7 +97,7 @@ void parsestack_alloc(ParseStack *ps, size_t n, Error *err)
 			if(!ps->cap) ps->cap = 1;
 			ps->cap *= 2;
 		} while(ps->len > ps->cap);
-		void *ptr = realloc(ps->state, sizeof(AstNode) * ps->cap);
+		void *ptr = realloc(ps->state, sizeof(ParseState) * ps->cap);
 		CHECK_MALLOC(ptr);
 		ps->state = ptr; 
 	}
@@ -52,6 +106,18 @@ RET:
 	return;
 }
 
+void parsestack_reserve(ParseStack *ps, size_t n, Error *err)
+{
+	if(ps->len + n <= ps->cap) goto RET;
+	void *ptr = realloc(ps->state, sizeof(ParseState) * (ps->len + n));
+	CHECK_MALLOC(ptr);
+	ps->state = ptr;
+	ps->cap = ps->len + n;
+
+RET:
+	return;
+}
+
 void parsestack_push(ParseStack *ps, ParseState state, Error *err)
 {
 	parsestack_alloc(ps, 1, err);
@@ -78,29 +144,46 @@ ParseState *parsestack_from_top(ParseStack *ps, size_t i)
 
 void parser_init(
 	Parser *prs,
-	Token const *tokens,
+	Tokens const *tokens,
 	char *const *identifiers,
 	char *const *strings
 ) {
 	*prs = (Parser) {
-		.tokens = tokens,
+		.tokens = *tokens,
 		.identifiers = identifiers,
 		.strings = strings,
 		.ast = {0},
+		.jobs = 1,
+		.diag = stderr,
+		.end = SIZE_MAX,
+		.recovered_at = SIZE_MAX,
+		.type_refs = {.elem_size = sizeof(TypeRef)},
+		.type_stack = {.elem_size = sizeof(size_t)},
 	};
 }
 
 void parser_clean(Parser *prs)
 {
 	free(prs->ast.nodes);
+	ast_clean(&prs->tree);
 	free(prs->parse_stack.state);
+	free(prs->types.nodes);
+	free(prs->type_slots);
+	dynarr_clean(&prs->type_refs);
+	dynarr_clean(&prs->type_stack);
 }
 
-void parser_print_ast(Parser *prs, FILE *file)
+void parser_print_ast(
+	Ast const *ast,
+	char *const *identifiers,
+	char *const *strings,
+	FILE *file
+)
 {
-	for(size_t i = 0; i < prs->ast.len; i++) {
-		fprintf(file, "%zi(->%zi):\t", i, i + prs->ast.nodes[i].com.next);
-		switch(prs->ast.nodes[i].type) {
+	for(size_t i = 0; i < ast->len; i++) {
+		AstNode node = ast_get(ast, i);
+		fprintf(file, "%zi(->%zi):\t", i, i + node.com.next);
+		switch(node.type) {
 		case AST_NONE:
 			fprintf(file, "NONE");
 			break;
@@ -109,9 +192,9 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"FN_DEF '%s': %zi { %zi }",
-				id_get(prs->identifiers, prs->ast.nodes[i].fn_def.id),
-				i + prs->ast.nodes[i].fn_def.fn_type,
-				i + prs->ast.nodes[i].fn_def.block
+				id_get(identifiers, node.fn_def.id),
+				i + node.fn_def.fn_type,
+				i + node.fn_def.block
 			);
 			break;
 
@@ -119,8 +202,8 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"(%zi...) -> %zi",
-				i + prs->ast.nodes[i].fn_type.args,
-				i + prs->ast.nodes[i].fn_type.ret_type
+				i + node.fn_type.args,
+				i + node.fn_type.ret_type
 			);
 			break;
 			
@@ -128,23 +211,23 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"return %zi",
-				i + prs->ast.nodes[i].ret.return_val
+				i + node.ret.return_val
 			);
 			break;
 		case AST_INT_LIT:
-			fprintf(file, "%ji", prs->ast.nodes[i].int_lit.val);
+			fprintf(file, "%ji", node.int_lit.val);
 			break;
 		case AST_BLOCK:
-			fprintf(file, "%zi;...", i + prs->ast.nodes[i].block.statements); 
+			fprintf(file, "%zi;...", i + node.block.statements); 
 			break;
 		case AST_IDENT:
-			fprintf(file, "'%s'", id_get(prs->identifiers, prs->ast.nodes[i].ident.id));
+			fprintf(file, "'%s'", id_get(identifiers, node.ident.id));
 			break;  
 		case AST_MODULE:
 			fprintf(
 				file,
 				"MODULE[%zi...]",
-				i + prs->ast.nodes[i].module.statements
+				i + node.module.statements
 			);
 			break;
 
@@ -152,32 +235,32 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"%zi * %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_ADD:
 			fprintf(
 				file,
 				"%zi + %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_DIV:
 			fprintf(
 				file,
 				"%zi / %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_SUB:
 			fprintf(
 				file,
 				"%zi - %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 
@@ -185,10 +268,10 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"%s '%s': %zi [= %zi]", 
-				prs->ast.nodes[i].var_decl.mut ? "var" : "const",
-				id_get(prs->identifiers, prs->ast.nodes[i].var_decl.id),
-				i + prs->ast.nodes[i].var_decl.data_type,
-				i + prs->ast.nodes[i].var_decl.initial
+				node.var_decl.mut ? "var" : "const",
+				id_get(identifiers, node.var_decl.id),
+				i + node.var_decl.data_type,
+				i + node.var_decl.initial
 			);
 			break;
 
@@ -196,8 +279,8 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"%s(%zi...)",
-				id_get(prs->identifiers, prs->ast.nodes[i].fn_call.fn_id),
-				prs->ast.nodes[i].fn_call.args + i
+				id_get(identifiers, node.fn_call.fn_id),
+				node.fn_call.args + i
 			);
 			break;
 
@@ -205,81 +288,81 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"%zi = %zi",
-				i + prs->ast.nodes[i].assign.var,
-				i + prs->ast.nodes[i].assign.expr
+				i + node.assign.var,
+				i + node.assign.expr
 			);
 			break;
 		case AST_ADD_ASSIGN:
 			fprintf(
 				file,
 				"%zi += %zi",
-				i + prs->ast.nodes[i].assign.var,
-				i + prs->ast.nodes[i].assign.expr
+				i + node.assign.var,
+				i + node.assign.expr
 			);
 			break;
 		case AST_SUB_ASSIGN:
 			fprintf(
 				file,
 				"%zi -= %zi",
-				i + prs->ast.nodes[i].assign.var,
-				i + prs->ast.nodes[i].assign.expr
+				i + node.assign.var,
+				i + node.assign.expr
 			);
 			break;
 		case AST_MUL_ASSIGN:
 			fprintf(
 				file,
 				"%zi *= %zi",
-				i + prs->ast.nodes[i].assign.var,
-				i + prs->ast.nodes[i].assign.expr
+				i + node.assign.var,
+				i + node.assign.expr
 			);
 			break;
 		case AST_DIV_ASSIGN:
 			fprintf(
 				file,
 				"%zi /= %zi",
-				i + prs->ast.nodes[i].assign.var,
-				i + prs->ast.nodes[i].assign.expr
+				i + node.assign.var,
+				i + node.assign.expr
 			);
 			break;
 
 		case AST_ADDR:
-			fprintf(file, "&%zi", i + prs->ast.nodes[i].unary_op.val);
+			fprintf(file, "&%zi", i + node.unary_op.val);
 			break;
 		case AST_POINTER_CONST:
-			fprintf(file, "&const %zi", i + prs->ast.nodes[i].pointer_type.base_type);
+			fprintf(file, "&const %zi", i + node.pointer_type.base_type);
 			break;
 		case AST_POINTER_VAR:
-			fprintf(file, "&var %zi", i + prs->ast.nodes[i].pointer_type.base_type);
+			fprintf(file, "&var %zi", i + node.pointer_type.base_type);
 			break;
 		case AST_POINTER_ABYSS:
-			fprintf(file, "&abyss %zi", i + prs->ast.nodes[i].pointer_type.base_type);
+			fprintf(file, "&abyss %zi", i + node.pointer_type.base_type);
 			break;
 		case AST_DEREF:
-			fprintf(file, "*%zi", i + prs->ast.nodes[i].unary_op.val);
+			fprintf(file, "*%zi", i + node.unary_op.val);
 			break;
 		case AST_ARRAY:
 			fprintf(
 				file,
 				"[%zi]%zi",
-				prs->ast.nodes[i].array.len,
-				i + prs->ast.nodes[i].array.elem_type
+				node.array.len,
+				i + node.array.elem_type
 			);
 			break;
 		case AST_SLICE_CONST:
-			fprintf(file, "[]const %zi", i + prs->ast.nodes[i].slice.elem_type);
+			fprintf(file, "[]const %zi", i + node.slice.elem_type);
 			break;
 		case AST_SLICE_VAR:
-			fprintf(file, "[]var %zi", i + prs->ast.nodes[i].slice.elem_type);
+			fprintf(file, "[]var %zi", i + node.slice.elem_type);
 			break;
 		case AST_SLICE_ABYSS:
-			fprintf(file, "[]abyss %zi", i + prs->ast.nodes[i].slice.elem_type);
+			fprintf(file, "[]abyss %zi", i + node.slice.elem_type);
 			break;
 		case AST_SUBSCRIPT:
 			fprintf(
 				file,
 				"%zi[%zi]",
-				i + prs->ast.nodes[i].subscript.arr,
-				i + prs->ast.nodes[i].subscript.index
+				i + node.subscript.arr,
+				i + node.subscript.index
 			);
 			break;
 
@@ -287,34 +370,34 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"{%zi...}",
-				i + prs->ast.nodes[i].array_lit.elems
+				i + node.array_lit.elems
 			);
 			break;
 		case AST_STRUCT_TYPE:
 			fprintf(
 				file,
 				"struct {%zi: %zi...}",
-				i + prs->ast.nodes[i].struct_type.member_names,
-				i + prs->ast.nodes[i].struct_type.member_types
+				i + node.struct_type.member_names,
+				i + node.struct_type.member_types
 			);
 			break;
 		case AST_STRUCT_LIT:
 			fprintf(
 				file,
 				"(struct) '%s' {%zi: %zi...}",
-				prs->ast.nodes[i].struct_lit.parent_id
-					? id_get(prs->identifiers, prs->ast.nodes[i].struct_lit.parent_id)
+				node.struct_lit.parent_id
+					? id_get(identifiers, node.struct_lit.parent_id)
 					: "_",
-				i + prs->ast.nodes[i].struct_lit.member_names,
-				i + prs->ast.nodes[i].struct_lit.member_values
+				i + node.struct_lit.member_names,
+				i + node.struct_lit.member_values
 			);
 			break;
 		case AST_STRUCT_ACCESS:
 			fprintf(
 				file,
 				"%zi.%s",
-				i + prs->ast.nodes[i].struct_access.parent,
-				id_get(prs->identifiers, prs->ast.nodes[i].struct_access.member_id)
+				i + node.struct_access.parent,
+				id_get(identifiers, node.struct_access.member_id)
 			);
 			break;
 
@@ -322,135 +405,138 @@ void parser_print_ast(Parser *prs, FILE *file)
 			fprintf(
 				file,
 				"String \"%s\"",
-				prs->strings[prs->ast.nodes[i].string_lit.id]
+				strings[node.string_lit.id]
 			);
 			break;
 		case AST_ZSTRING_LIT:
 			fprintf(
 				file,
 				"ZString \"%s\"",
-				prs->strings[prs->ast.nodes[i].string_lit.id]
+				strings[node.string_lit.id]
 			);
 			break;
 		case AST_CSTRING_LIT:
 			fprintf(
 				file,
 				"CString \"%s\"",
-				prs->strings[prs->ast.nodes[i].string_lit.id]
+				strings[node.string_lit.id]
 			);
 			break;
 		case AST_EXTERN:
 			fprintf(
 				file,
 				"#extern(%zi)",
-				i + prs->ast.nodes[i].extrn.name
+				i + node.extrn.name
 			);
 			break;
 		case AST_DISCARD:
 			fprintf(
 				file,
 				"discard %zi",
-				i + prs->ast.nodes[i].discard.value
+				i + node.discard.value
 			);
 			break;
 		case AST_ARROW:
 			fprintf(
 				file,
-				"%zi -> %zi",
-				i + prs->ast.nodes[i].arrow.parent,
-				i + prs->ast.nodes[i].arrow.member
+				"%zi->%s",
+				i + node.struct_access.parent,
+				id_get(identifiers, node.struct_access.member_id)
 			);
 			break;
 		case AST_TYPEDEF:
 			fprintf(
 				file,
 				"typedef \"%s\" = %zi",
-				id_get(prs->identifiers, prs->ast.nodes[i].typdef.id),
-				i + prs->ast.nodes[i].typdef.backing
+				id_get(identifiers, node.typdef.id),
+				i + node.typdef.backing
 			);
 			break;
 		case AST_CHAR_LIT:
 			fprintf(
 				file,
 				"Char %02X",
-				prs->ast.nodes[i].char_lit.val
+				node.char_lit.val
 			);
 			break;
 		case AST_COMP_EQ:
 			fprintf(
 				file,
 				"%zi == %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_COMP_GE:
 			fprintf(
 				file,
 				"%zi >= %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_COMP_LE:
 			fprintf(
 				file,
 				"%zi <= %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_COMP_NE:
 			fprintf(
 				file,
 				"%zi != %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_COMP_GT:
 			fprintf(
 				file,
 				"%zi > %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_COMP_LT:
 			fprintf(
 				file,
 				"%zi < %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_LOGIC_AND:
 			fprintf(
 				file,
 				"%zi && %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_LOGIC_OR:
 			fprintf(
 				file,
 				"%zi || %zi",
-				i + prs->ast.nodes[i].binop.lhs,
-				i + prs->ast.nodes[i].binop.rhs
+				i + node.binop.lhs,
+				i + node.binop.rhs
 			);
 			break;
 		case AST_LOGIC_NOT:
-			fprintf(file, "!%zi", i + prs->ast.nodes[i].unary_op.val);
+			fprintf(file, "!%zi", i + node.unary_op.val);
+			break;
+		case AST_ERROR:
+			fprintf(file, "ERROR");
 			break;
 		case AST_IF:
 			fprintf(
 				file,
 				"if(%zi; %zi) {%zi} else {%zi}\n",
-				i + prs->ast.nodes[i].if_statement.decl,
-				i + prs->ast.nodes[i].if_statement.condition,
-				i + prs->ast.nodes[i].if_statement.block,
-				i + prs->ast.nodes[i].if_statement.else_block
+				i + node.if_statement.decl,
+				i + node.if_statement.condition,
+				i + node.if_statement.block,
+				i + node.if_statement.else_block
 			);
 			break;
 		}
@@ -458,50 +544,404 @@ void parser_print_ast(Parser *prs, FILE *file)
 	}
 }
 
+/*
+ * Type Hash-Consing
+ * Type expressions that are spelled the same share their nodes. Once the type
+ * at ref is parsed, TYPE_CONS interns it into prs->types bottom-up, so every
+ * distinct type (and everything it's made of) is in there once, then drops
+ * the nodes it was parsed into. ref itself stays, since it can be part of a
+ * chain (function arguments link through its next). type_finish appends the
+ * types to the AST and makes each ref a copy of its type's root, so it shares
+ * the rest. Shared nodes keep the DebugInfo of the type's first occurrence.
+ * Types are interned in the order they're parsed, and parse_splice interns a
+ * chunk's types in that same order, so a parallel parse ends up the same.
+ */
+
+#define TYPE_HASH_MUL 0x9E3779B97F4A7C15u
+
+static uint32_t type_hash(NodeList const *types, size_t i)
+{
+	AstNode const *node = &types->nodes[i];
+	uint64_t hash = (node->type + 1) * TYPE_HASH_MUL;
+
+	switch(node->type) {
+	case AST_IDENT:
+		hash = (hash ^ node->ident.id) * TYPE_HASH_MUL;
+		break;
+
+	case AST_ARRAY:
+		hash = (hash ^ node->array.len) * TYPE_HASH_MUL;
+		// fallthrough
+	case AST_POINTER_CONST:
+	case AST_POINTER_VAR:
+	case AST_POINTER_ABYSS:
+	case AST_SLICE_CONST:
+	case AST_SLICE_VAR:
+	case AST_SLICE_ABYSS:
+		// Children are interned already, so where they are says what they are
+		hash = (hash ^ (i + node->pointer_type.base_type)) * TYPE_HASH_MUL;
+		break;
+
+	case AST_STRUCT_TYPE: {
+		size_t name = i + node->struct_type.member_names;
+		size_t type = i + node->struct_type.member_types;
+		for(size_t j = 0; j < node->struct_type.member_count; j++) {
+			hash = (hash ^ types->nodes[name].ident.id) * TYPE_HASH_MUL;
+			hash = (hash ^ type_hash(types, type)) * TYPE_HASH_MUL;
+			name += types->nodes[name].com.next;
+			type += types->nodes[type].com.next;
+		}
+	} break;
+
+	default:
+		break;
+	}
+	return hash ^ (hash >> 32);
+}
+
+static bool type_same(NodeList const *types, size_t a, size_t b)
+{
+	AstNode const *x = &types->nodes[a];
+	AstNode const *y = &types->nodes[b];
+	if(x->type != y->type) return false;
+
+	switch(x->type) {
+	case AST_IDENT:
+		return x->ident.id == y->ident.id;
+
+	case AST_ARRAY:
+		if(x->array.len != y->array.len) return false;
+		// fallthrough
+	case AST_POINTER_CONST:
+	case AST_POINTER_VAR:
+	case AST_POINTER_ABYSS:
+	case AST_SLICE_CONST:
+	case AST_SLICE_VAR:
+	case AST_SLICE_ABYSS:
+		return a + x->pointer_type.base_type == b + y->pointer_type.base_type;
+
+	case AST_STRUCT_TYPE: {
+		if(x->struct_type.member_count != y->struct_type.member_count) return false;
+		size_t name_x = a + x->struct_type.member_names;
+		size_t name_y = b + y->struct_type.member_names;
+		size_t type_x = a + x->struct_type.member_types;
+		size_t type_y = b + y->struct_type.member_types;
+		for(size_t j = 0; j < x->struct_type.member_count; j++) {
+			if(types->nodes[name_x].ident.id != types->nodes[name_y].ident.id) return false;
+			if(!type_same(types, type_x, type_y)) return false;
+			name_x += types->nodes[name_x].com.next;
+			name_y += types->nodes[name_y].com.next;
+			type_x += types->nodes[type_x].com.next;
+			type_y += types->nodes[type_y].com.next;
+		}
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+static void type_table_clean(Parser *prs)
+{
+	free(prs->types.nodes);
+	free(prs->type_slots);
+	dynarr_clean(&prs->type_refs);
+	dynarr_clean(&prs->type_stack);
+	prs->types = (NodeList) {0};
+	prs->type_slots = NULL;
+	prs->type_cap = 0;
+	prs->type_count = 0;
+	dynarr_init(&prs->type_refs, sizeof(TypeRef));
+	dynarr_init(&prs->type_stack, sizeof(size_t));
+}
+
+static void type_table_grow(Parser *prs, Error *err)
+{
+	size_t cap = prs->type_cap ? prs->type_cap * 2 : 64;
+	TypeSlot *slots = calloc(cap, sizeof(TypeSlot));
+	CHECK_MALLOC(slots);
+
+	for(size_t i = 0; i < prs->type_cap; i++) {
+		TypeSlot slot = prs->type_slots[i];
+		if(!slot.type) continue;
+		size_t j = slot.hash & (cap - 1);
+		while(slots[j].type) j = (j + 1) & (cap - 1);
+		slots[j] = slot;
+	}
+	free(prs->type_slots);
+	prs->type_slots = slots;
+	prs->type_cap = cap;
+
+RET:
+	return;
+}
+
+// The first type the same as types[i], which is i if it's new
+static size_t type_canonical(Parser *prs, size_t i, Error *err)
+{
+	if(2 * (prs->type_count + 1) > prs->type_cap) {
+		type_table_grow(prs, err);
+		if(*err) goto RET;
+	}
+
+	uint32_t hash = type_hash(&prs->types, i);
+	size_t mask = prs->type_cap - 1;
+	for(size_t j = hash & mask;; j = (j + 1) & mask) {
+		TypeSlot *slot = &prs->type_slots[j];
+		if(!slot->type) {
+			*slot = (TypeSlot) {hash, i + 1};
+			prs->type_count += 1;
+			break;
+		}
+		if(slot->hash == hash && type_same(&prs->types, slot->type - 1, i)) {
+			i = slot->type - 1;
+			break;
+		}
+	}
+
+RET:
+	return i;
+}
+
+static Offset type_offset(size_t from, size_t to)
+{
+	return (Offset) ((ptrdiff_t) to - (ptrdiff_t) from);
+}
+
+// nodes[from], moved to dest, still pointing at the same children
+static AstNode type_move(AstNode const *nodes, size_t from, size_t dest)
+{
+	AstNode node = nodes[from];
+
+	switch(node.type) {
+	case AST_ARRAY:
+	case AST_POINTER_CONST:
+	case AST_POINTER_VAR:
+	case AST_POINTER_ABYSS:
+	case AST_SLICE_CONST:
+	case AST_SLICE_VAR:
+	case AST_SLICE_ABYSS:
+		node.pointer_type.base_type += type_offset(dest, from);
+		break;
+
+	case AST_STRUCT_TYPE:
+		if(node.struct_type.member_count) {
+			node.struct_type.member_names += type_offset(dest, from);
+			node.struct_type.member_types += type_offset(dest, from);
+		}
+		break;
+
+	default:
+		break;
+	}
+	return node;
+}
+
+// Pushes node, whose children are interned already, as the type at start,
+// dropping it and everything after start again if it's a duplicate
+static size_t type_push(Parser *prs, AstNode node, size_t start, Error *err)
+{
+	size_t at = SIZE_MAX;
+	nodelist_push(&prs->types, node, err);
+	if(*err) goto RET;
+
+	at = type_canonical(prs, prs->types.len - 1, err);
+	if(*err) goto RET;
+	if(at != prs->types.len - 1) prs->types.len = start; // Seen it before, drop the copy
+
+RET:
+	return at;
+}
+
+/*
+ * Interns the type at src->nodes[i], returning its index in prs->types.
+ * Anything it's made of is interned first, and it's pushed last, then
+ * dropped again if it turns out to be a duplicate.
+ * Pointers, arrays and slices each wrap one type, so a chain of them is
+ * walked down and interned back up on type_stack. Only structs recurse,
+ * for each member, and they keep the members' indices on type_stack too.
+ */
+static size_t type_intern(Parser *prs, NodeList const *src, size_t i, Error *err)
+{
+	DynArr *stack = &prs->type_stack;
+	size_t mark = stack->count;
+	size_t at = SIZE_MAX;
+
+	for(;; i += src->nodes[i].pointer_type.base_type) {
+		AstNodeType type = src->nodes[i].type;
+		if(
+			type != AST_ARRAY
+			&& type != AST_POINTER_CONST
+			&& type != AST_POINTER_VAR
+			&& type != AST_POINTER_ABYSS
+			&& type != AST_SLICE_CONST
+			&& type != AST_SLICE_VAR
+			&& type != AST_SLICE_ABYSS
+		) break;
+
+		dynarr_push(stack, &i, err);
+		if(*err) goto RET;
+	}
+
+	AstNode node = src->nodes[i];
+	node.com.next = 0;
+	size_t start = prs->types.len;
+
+	if(node.type == AST_STRUCT_TYPE) {
+		size_t count = node.struct_type.member_count;
+		size_t type = i + node.struct_type.member_types;
+		for(size_t j = 0; j < count; j++) {
+			size_t member = type_intern(prs, src, type, err);
+			if(*err) goto RET;
+			dynarr_push(stack, &member, err);
+			if(*err) goto RET;
+			type += src->nodes[type].com.next;
+		}
+
+		// The member lists go right before the struct, chained with next = 1
+		start = prs->types.len;
+		nodelist_alloc(&prs->types, 2 * count, err);
+		if(*err) goto RET;
+
+		size_t const *members = dynarr_at(stack, stack->count - count);
+		size_t name = i + node.struct_type.member_names;
+		for(size_t j = 0; j < count; j++) {
+			AstNode *member_name = &prs->types.nodes[start + j];
+			AstNode *member_type = &prs->types.nodes[start + count + j];
+
+			*member_name = src->nodes[name];
+			*member_type = type_move(prs->types.nodes, members[j], start + count + j);
+			member_name->com.next = j + 1 < count;
+			member_type->com.next = j + 1 < count;
+			name += src->nodes[name].com.next;
+		}
+		stack->count -= count;
+
+		if(count) {
+			node.struct_type.member_names = -(Offset) (2 * count);
+			node.struct_type.member_types = -(Offset) count;
+		}
+	}
+
+	at = type_push(prs, node, start, err);
+	if(*err) goto RET;
+
+	// Back up the chain, each wrapping the one interned before it
+	while(stack->count > mark) {
+		node = src->nodes[*(size_t*) dynarr_pop(stack)];
+		node.com.next = 0;
+		start = prs->types.len;
+		node.pointer_type.base_type = type_offset(start, at);
+
+		at = type_push(prs, node, start, err);
+		if(*err) goto RET;
+	}
+
+RET:
+	stack->count = mark;
+	return at;
+}
+
+// Points the node at ref at the interned type, see type_finish
+static void type_ref(Parser *prs, size_t ref, size_t type, Error *err)
+{
+	dynarr_push(&prs->type_refs, &(TypeRef) {ref, type}, err);
+}
+
+// Parses a type into the node at ref, see TYPE_CONS
+static void parse_push_type(Parser *prs, size_t ref, Error *err)
+{
+	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_TYPE_CONS, ref}, err);
+	if(*err) goto RET;
+	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_TYPE, ref}, err);
+	if(*err) goto RET;
+
+RET:
+	return;
+}
+
+static void handle_TYPE_CONS(Parser *prs, size_t *index, Error *err)
+{
+	(void) index;
+	size_t ref = parsestack_pop(&prs->parse_stack).ref;
+
+	size_t type = type_intern(prs, &prs->ast, ref, err);
+	if(*err) goto RET;
+	prs->ast.len = ref + 1;
+
+	type_ref(prs, ref, type, err);
+	if(*err) goto RET;
+
+RET:
+	return;
+}
+
+// Appends the interned types to the AST, and fills in every node that holds one
+static void type_finish(Parser *prs, Error *err)
+{
+	size_t base = prs->ast.len;
+	nodelist_alloc(&prs->ast, prs->types.len, err);
+	if(*err) goto RET;
+	memcpy(&prs->ast.nodes[base], prs->types.nodes, prs->types.len * sizeof(AstNode));
+
+	TypeRef const *refs = prs->type_refs.data;
+	for(size_t i = 0; i < prs->type_refs.count; i++) {
+		AstNode *node = &prs->ast.nodes[refs[i].node];
+		AstNode type = type_move(prs->ast.nodes, base + refs[i].type, refs[i].node);
+		type.com.debug = node->com.debug;
+		type.com.next = node->com.next;
+		*node = type;
+	}
+
+RET:
+	type_table_clean(prs);
+}
+
 static void handle_MODULE(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type == TOKEN_EOF) {
+	if(*index > prs->end) {
+		// The last definition ran past the end of this chunk, see parser_split
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
+	if(*index == prs->end || TOK_TYPE(*index) == TOKEN_EOF) {
 		parsestack_pop(&prs->parse_stack);
 		goto RET;
 	}
 
-	{
-		AstNode *last_statement = &prs->ast.nodes[parsestack_top(&prs->parse_stack)->ref];
-		if(last_statement->module.statements) {
-			last_statement += last_statement->module.statements;
-			while(last_statement->com.next) {
-				last_statement += last_statement->com.next;
-			}
-			last_statement->com.next = prs->ast.len - (last_statement - prs->ast.nodes);
-		} else {
-			last_statement->module.statements = 1; // First Statement
-		}
+	if(prs->module_tail) {
+		prs->ast.nodes[prs->module_tail].com.next = prs->ast.len - prs->module_tail;
+	} else {
+		size_t module = parsestack_top(&prs->parse_stack)->ref;
+		prs->ast.nodes[module].module.statements = prs->ast.len - module; // First Statement
 	}
+	prs->module_tail = prs->ast.len;
 
-	const DebugInfo debug = prs->tokens[*index].debug.debug_info;
-	switch(prs->tokens[*index].type) {
+	const DebugInfo debug = TOK_DEBUG(*index);
+	switch(TOK_TYPE(*index)) {
 	case TOKEN_TYPEDEF: {
 		*index += 1;
 
-		if(prs->tokens[*index].type != TOKEN_IDENT) {
+		if(TOK_TYPE(*index) != TOKEN_IDENT) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected identifier after typedef, found %T\n",
-				&prs->tokens[*index]
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
 
-		const size_t id = prs->tokens[*index].ident.id;
+		const size_t id = TOK_VAL(*index);
 
 		*index += 1;
 
-		if(prs->tokens[*index].type != TOKEN_ASSIGN) {
+		if(TOK_TYPE(*index) != TOKEN_ASSIGN) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected '=' in typedef, found %T\n",
-				&prs->tokens[*index]
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
@@ -520,23 +960,23 @@ static void handle_MODULE(Parser *prs, size_t *index, Error *err)
 
 		parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_SEMICOLON}, err);
 		if(*err) goto RET;
-		parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_TYPE, prs->ast.len - 1}, err);
+		parse_push_type(prs, prs->ast.len - 1, err);
 		if(*err) goto RET;
 	} break;
 
 	case TOKEN_FN: {
 		*index += 1;
 
-		if(prs->tokens[*index].type != TOKEN_IDENT) {
+		if(TOK_TYPE(*index) != TOKEN_IDENT) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected identifier after fn, found %T\n",
-				&prs->tokens[*index]
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
-		Id id = prs->tokens[*index].ident.id;
+		Id id = TOK_VAL(*index);
 
 		nodelist_push(
 			&prs->ast,
@@ -560,9 +1000,9 @@ static void handle_MODULE(Parser *prs, size_t *index, Error *err)
 
 	default:
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Illegal Top-Level Statement %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -598,11 +1038,11 @@ RET:
 
 static void handle_IDENT(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type != TOKEN_IDENT) {
+	if(TOK_TYPE(*index) != TOKEN_IDENT) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected Identifier, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -610,8 +1050,8 @@ static void handle_IDENT(Parser *prs, size_t *index, Error *err)
 
 	prs->ast.nodes[parsestack_pop(&prs->parse_stack).ref] = (AstNode) {
 		.ident = {
-			.com = {AST_IDENT, prs->tokens[*index].debug.debug_info},
-			.id = prs->tokens[*index].ident.id,
+			.com = {AST_IDENT, TOK_DEBUG(*index)},
+			.id = TOK_VAL(*index),
 		},
 	};
 
@@ -622,11 +1062,11 @@ RET:
 
 static void handle_FN_TYPE(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type != TOKEN_LPAREN) {
+	if(TOK_TYPE(*index) != TOKEN_LPAREN) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected '(' to start Function Type, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -637,7 +1077,7 @@ static void handle_FN_TYPE(Parser *prs, size_t *index, Error *err)
 	size_t ref = parsestack_pop(&prs->parse_stack).ref;
 	prs->ast.nodes[ref] = (AstNode) {
 		.fn_type = {
-			.com = {AST_FN_TYPE, prs->tokens[*index-1].debug.debug_info},
+			.com = {AST_FN_TYPE, TOK_DEBUG(*index-1)},
 			.args = 0,
 			.arg_count = 0,
 			.ret_type = 0,
@@ -655,7 +1095,7 @@ RET:
 
 static void handle_FN_TYPE_LIST(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type == TOKEN_RPAREN) {
+	if(TOK_TYPE(*index) == TOKEN_RPAREN) {
 		parsestack_pop(&prs->parse_stack);
 		*index += 1;
 		goto RET;
@@ -664,11 +1104,11 @@ static void handle_FN_TYPE_LIST(Parser *prs, size_t *index, Error *err)
 	{
 		AstNode *fn_type = &prs->ast.nodes[parsestack_top(&prs->parse_stack)->ref];
 		
-		if(fn_type->fn_type.args && prs->tokens[(*index)++].type != TOKEN_COMMA) {
+		if(fn_type->fn_type.args && TOK_TYPE((*index)++) != TOKEN_COMMA) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected ',' after Function Argument, found %T\n",
-				&prs->tokens[*index - 1]
+				&prs->tokens, TOK(*index - 1)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
@@ -706,11 +1146,11 @@ RET:
 
 static void handle_FN_TYPE_ARG(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type != TOKEN_COLON) {
+	if(TOK_TYPE(*index) != TOKEN_COLON) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected ':' in Function Argument, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -729,7 +1169,7 @@ static void handle_FN_TYPE_ARG(Parser *prs, size_t *index, Error *err)
 	nodelist_alloc(&prs->ast, 1, err);
 	if(*err) goto RET;
 	
-	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_TYPE, prs->ast.len - 1}, err);
+	parse_push_type(prs, prs->ast.len - 1, err);
 	if(*err) goto RET;
 
 RET:
@@ -744,7 +1184,7 @@ static void handle_FN_TYPE_RET(Parser *prs, size_t *index, Error *err)
 	nodelist_alloc(&prs->ast, 1, err);
 	if(*err) goto RET;
 
-	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_TYPE, prs->ast.len - 1}, err);
+	parse_push_type(prs, prs->ast.len - 1, err);
 	if(*err) goto RET;
 
 RET:
@@ -755,13 +1195,13 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 {
 	size_t ref = parsestack_top(&prs->parse_stack)->ref;
 
-	switch(prs->tokens[*index].type) {
+	switch(TOK_TYPE(*index)) {
 	case TOKEN_STRUCT:
-		if(prs->tokens[++*index].type != TOKEN_LCURLY) {
+		if(TOK_TYPE(++*index) != TOKEN_LCURLY) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected '{' after 'struct', found %T\n",
-				&prs->tokens[*index]
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
@@ -769,7 +1209,7 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 
 		prs->ast.nodes[ref] = (AstNode) {
 			.struct_type = {
-				.com = {AST_STRUCT_TYPE, prs->tokens[*index-1].debug.debug_info},
+				.com = {AST_STRUCT_TYPE, TOK_DEBUG(*index-1)},
 				.member_names = 0,
 				.member_types = 0,
 				.member_count = 0,
@@ -787,14 +1227,14 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 
 	case TOKEN_AMPERSAND:
 		*index += 1;
-		if(prs->tokens[*index].type != TOKEN_CONST
-			&& prs->tokens[*index].type != TOKEN_VAR
-			&& prs->tokens[*index].type != TOKEN_ABYSS
+		if(TOK_TYPE(*index) != TOKEN_CONST
+			&& TOK_TYPE(*index) != TOKEN_VAR
+			&& TOK_TYPE(*index) != TOKEN_ABYSS
 		) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected access specifier in pointer type, found %T\n",
-				&prs->tokens[*index]
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
@@ -803,8 +1243,8 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 		prs->ast.nodes[ref] = (AstNode) {
 			.pointer_type = {
 				.com = {
-					AST_POINTER_CONST + prs->tokens[*index].type - TOKEN_CONST,
-					prs->tokens[*index].debug.debug_info,
+					AST_POINTER_CONST + TOK_TYPE(*index) - TOKEN_CONST,
+					TOK_DEBUG(*index),
 				},
 				.base_type = prs->ast.len - ref,
 			},
@@ -819,17 +1259,17 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 	
 	case TOKEN_LSQUARE:
 		*index += 1;
-		switch(prs->tokens[*index].type) {
+		switch(TOK_TYPE(*index)) {
 		case TOKEN_RSQUARE:
 			*index += 1;
 			
-			if(prs->tokens[*index].type < TOKEN_CONST
-				|| prs->tokens[*index].type > TOKEN_ABYSS
+			if(TOK_TYPE(*index) < TOKEN_CONST
+				|| TOK_TYPE(*index) > TOKEN_ABYSS
 			) {
 				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
+					prs->diag, prs->identifiers, prs->strings, NULL,
 					"Expected Access Specifier in Slice Type, found %T\n",
-					&prs->tokens[*index]
+					&prs->tokens, TOK(*index)
 				);
 				*err = ERROR_UNEXPECTED_DATA;
 				goto RET;
@@ -838,8 +1278,8 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 			prs->ast.nodes[ref] = (AstNode) {
 				.slice = {
 					.com = {
-						AST_SLICE_CONST + (prs->tokens[*index].type - TOKEN_CONST),
-						prs->tokens[*index].debug.debug_info,
+						AST_SLICE_CONST + (TOK_TYPE(*index) - TOKEN_CONST),
+						TOK_DEBUG(*index),
 					},
 					.elem_type = prs->ast.len - ref,
 				},
@@ -855,17 +1295,17 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 
 		case TOKEN_UNDERSCORE:
 		case TOKEN_INT_LIT: {
-			intmax_t len = prs->tokens[*index].type == TOKEN_INT_LIT
-				? prs->tokens[*index].int_lit.val 
+			intmax_t len = TOK_TYPE(*index) == TOKEN_INT_LIT
+				? TOK_INT(*index) 
 				: 0;
 
 			*index += 1;
 
-			if(prs->tokens[*index].type != TOKEN_RSQUARE) {
+			if(TOK_TYPE(*index) != TOKEN_RSQUARE) {
 				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
+					prs->diag, prs->identifiers, prs->strings, NULL,
 					"Expected ']' in Array Type, found %T\n",
-					&prs->tokens[*index]
+					&prs->tokens, TOK(*index)
 				);
 
 				*err = ERROR_UNEXPECTED_DATA;
@@ -876,7 +1316,7 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 				.array = {
 					.com = {
 						AST_ARRAY,
-						prs->tokens[*index].debug.debug_info,
+						TOK_DEBUG(*index),
 					},
 					.elem_type = prs->ast.len - ref,
 					.len = len,
@@ -898,9 +1338,9 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 		
 		default:
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected Count or ']' for Array/Slice Type, found %T\n",
-				&prs->tokens[*index]
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
@@ -913,9 +1353,9 @@ static void handle_TYPE(Parser *prs, size_t *index, Error *err)
 
 	default:
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected Type, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -927,11 +1367,11 @@ RET:
 
 static void handle_BLOCK(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type != TOKEN_LCURLY) {
+	if(TOK_TYPE(*index) != TOKEN_LCURLY) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected '{', found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -940,7 +1380,7 @@ static void handle_BLOCK(Parser *prs, size_t *index, Error *err)
 	prs->ast.nodes[parsestack_top(&prs->parse_stack)->ref] = (AstNode) {
 		.block = {
 			.com = {
-				AST_BLOCK, prs->tokens[*index].debug.debug_info
+				AST_BLOCK, TOK_DEBUG(*index)
 			},
 		},
 	};
@@ -953,24 +1393,31 @@ RET:
 	return;
 }
 
+// Last statement of the block a BLOCK_LIST state is parsing, 0 if it has none
+static size_t block_last(Parser const *prs, ParseState const *state)
+{
+	AstNode const *prev = &prs->ast.nodes[state->prev];
+	if(!prs->ast.nodes[state->ref].block.statements) return 0;
+	if(state->prev == state->ref) return state->ref + prev->block.statements;
+	return state->prev + prev->com.next;
+}
+
 static void handle_BLOCK_LIST(Parser *prs, size_t *index, Error *err)
 {
 	size_t last_index;
 	{
-		size_t ref = parsestack_top(&prs->parse_stack)->ref;
+		ParseState *top = parsestack_top(&prs->parse_stack);
+		size_t ref = top->ref;
 		AstNode *statement = &prs->ast.nodes[ref];
 		if(statement->block.statements) {
-			statement += statement->module.statements;
-			while(statement->com.next) {
-				statement += statement->com.next;
-			}
+			statement = &prs->ast.nodes[block_last(prs, top)];
 
-			if(prs->tokens[*index].type != TOKEN_SEMICOLON) {
-				if(prs->tokens[*index - 1].type != TOKEN_RCURLY) {
+			if(TOK_TYPE(*index) != TOKEN_SEMICOLON) {
+				if(TOK_TYPE(*index - 1) != TOKEN_RCURLY) {
 					wyrt_diag(
-						stderr, prs->identifiers, prs->strings, NULL,
+						prs->diag, prs->identifiers, prs->strings, NULL,
 						"Expected ';' after Statement, found %T\n",
-						&prs->tokens[*index]
+						&prs->tokens, TOK(*index)
 					);
 					*err = ERROR_UNEXPECTED_DATA;
 					goto RET;
@@ -979,7 +1426,7 @@ static void handle_BLOCK_LIST(Parser *prs, size_t *index, Error *err)
 				*index += 1;
 			}
 
-			if(prs->tokens[*index].type == TOKEN_RCURLY) {
+			if(TOK_TYPE(*index) == TOKEN_RCURLY) {
 				parsestack_pop(&prs->parse_stack);
 				*index += 1;
 				goto RET;
@@ -987,7 +1434,7 @@ static void handle_BLOCK_LIST(Parser *prs, size_t *index, Error *err)
 
 			statement->com.next = prs->ast.len - (statement - prs->ast.nodes);
 		} else {
-			if(prs->tokens[*index].type == TOKEN_RCURLY) {
+			if(TOK_TYPE(*index) == TOKEN_RCURLY) {
 				parsestack_pop(&prs->parse_stack);
 				*index += 1;
 				goto RET;
@@ -996,9 +1443,10 @@ static void handle_BLOCK_LIST(Parser *prs, size_t *index, Error *err)
 			statement->block.statements = prs->ast.len - ref;
 		}
 		last_index = statement - prs->ast.nodes;
+		top->prev = last_index;
 	}
 
-	switch(prs->tokens[*index].type) {
+	switch(TOK_TYPE(*index)) {
 	case TOKEN_IF: {
 		nodelist_alloc(&prs->ast, 1, err);
 		if(*err) goto RET;
@@ -1013,7 +1461,7 @@ static void handle_BLOCK_LIST(Parser *prs, size_t *index, Error *err)
 		prs->ast.nodes[prs->ast.len - 2] = (AstNode) {
 			.discard = {
 				.com = {
-					AST_DISCARD, prs->tokens[*index].debug.debug_info
+					AST_DISCARD, TOK_DEBUG(*index)
 				},
 				.value = 1,	
 			},
@@ -1025,13 +1473,13 @@ static void handle_BLOCK_LIST(Parser *prs, size_t *index, Error *err)
 		*index += 1;
 	} break;
 	case TOKEN_RETURN: {
-		if(prs->tokens[*index + 1].type == TOKEN_SEMICOLON) {
+		if(TOK_TYPE(*index + 1) == TOKEN_SEMICOLON) {
 			nodelist_push(
 				&prs->ast,
 				(AstNode) {
 					.ret = {
 						.com = {
-							AST_RET, prs->tokens[*index].debug.debug_info
+							AST_RET, TOK_DEBUG(*index)
 						},
 						.return_val = 0,
 					},
@@ -1048,7 +1496,7 @@ static void handle_BLOCK_LIST(Parser *prs, size_t *index, Error *err)
 
 		prs->ast.nodes[prs->ast.len - 2] = (AstNode) {
 			.ret = {
-				.com = {AST_RET, prs->tokens[*index].debug.debug_info},
+				.com = {AST_RET, TOK_DEBUG(*index)},
 				.return_val = 1,
 			},
 		};
@@ -1103,7 +1551,7 @@ static void handle_IF(Parser *prs, size_t *index, Error *err)
 
 	prs->ast.nodes[ref] = (AstNode) {
 		.if_statement = {
-			.com = {AST_IF, prs->tokens[*index].debug.debug_info},
+			.com = {AST_IF, TOK_DEBUG(*index)},
 			.decl = 0,
 			.condition = 0,
 			.block = prs->ast.len - ref,
@@ -1123,11 +1571,11 @@ static void handle_IF(Parser *prs, size_t *index, Error *err)
 
 	*index += 1;
 	
-	if(prs->tokens[*index].type != TOKEN_LPAREN) {
+	if(TOK_TYPE(*index) != TOKEN_LPAREN) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected '(' after 'if', found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -1142,8 +1590,8 @@ static void handle_IF(Parser *prs, size_t *index, Error *err)
 	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_RPAREN, ref}, err);
 	if(*err) goto RET;
 
-	if(prs->tokens[*index].type == TOKEN_CONST
-		|| prs->tokens[*index].type == TOKEN_VAR
+	if(TOK_TYPE(*index) == TOKEN_CONST
+		|| TOK_TYPE(*index) == TOKEN_VAR
 	) {
 		prs->ast.nodes[ref].if_statement.decl = prs->ast.len - ref;
 		parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_CONDITION, ref}, err);
@@ -1170,11 +1618,11 @@ static void handle_VAR_DECL(Parser *prs, size_t *index, Error *err)
 
 	*index += 1;
 
-	if(prs->tokens[*index].type != TOKEN_IDENT) {
+	if(TOK_TYPE(*index) != TOKEN_IDENT) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected Identifier after variable declaration, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -1182,20 +1630,20 @@ static void handle_VAR_DECL(Parser *prs, size_t *index, Error *err)
 
 	prs->ast.nodes[ref] = (AstNode) {
 		.var_decl = {
-			.com = {AST_VAR_DECL, prs->tokens[*index].debug.debug_info},
-			.mut = prs->tokens[*index - 1].type == TOKEN_VAR,
-			.id =  prs->tokens[*index].ident.id,
+			.com = {AST_VAR_DECL, TOK_DEBUG(*index)},
+			.mut = TOK_TYPE(*index - 1) == TOKEN_VAR,
+			.id =  TOK_VAL(*index),
 			.data_type = prs->ast.len - ref,
 		},
 	};
 
 	*index += 1;
 
-	if(prs->tokens[*index].type != TOKEN_COLON) {
+	if(TOK_TYPE(*index) != TOKEN_COLON) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected ':' in Variable Declaration, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -1206,7 +1654,7 @@ static void handle_VAR_DECL(Parser *prs, size_t *index, Error *err)
 
 	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_VAR_DECL_INIT, ref}, err);
 	if(*err) goto RET;	
-	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_TYPE, prs->ast.len - 1}, err);
+	parse_push_type(prs, prs->ast.len - 1, err);
 	if(*err) goto RET;
 
 	*index += 1;
@@ -1215,904 +1663,676 @@ RET:
 	return;
 }
 
-typedef enum {
-	EXPR_NONE,
-	EXPR_ADD,
-	EXPR_SUB,
-	EXPR_MUL,
-	EXPR_DIV,
-	EXPR_ADDR,
-	EXPR_DEREF,
-	EXPR_LPAREN,
-	EXPR_FN_CALL,
-	EXPR_ARRAY_LIT,
-	EXPR_SUBSCRIPT,
-	EXPR_STRUCT_LIT,
-	EXPR_STRUCT_ACCESS,
-	EXPR_ARROW,
-	EXPR_COMP_EQ,
-	EXPR_COMP_GE,
-	EXPR_COMP_LE,
-	EXPR_COMP_NE,
-	EXPR_COMP_GT,
-	EXPR_COMP_LT,
-	EXPR_LOGIC_AND,
-	EXPR_LOGIC_OR,
-	EXPR_LOGIC_NOT
-} ExprOpType;
+/*
+ * Expressions
+ * Precedence climbing. Every node is pushed after the nodes it refers to, so
+ * the root of an expression is always the last node pushed; handle_EXPR then
+ * moves it into the slot its parent reserved. Nesting recurses on the C stack,
+ * so parsing an expression doesn't allocate anything but AST nodes.
+ *
+ * From loosest to tightest: || && comparisons + - * / prefix(* & !)
+ * postfix(. -> []). Binary operators are left-associative.
+ */
 
-typedef struct {
-	ExprOpType type;
-	DebugInfo debug;
-	size_t extra;
-	size_t id;
-} ExprOp;
+#define EXPR_DEPTH_MAX 1024
+#define EXPR_PREFIX_PRECEDENCE 6
 
-static ExprOpType token_to_op(TokenType type)
-{
-	switch(type) {
-	case TOKEN_PLUS: return EXPR_ADD;
-	case TOKEN_MINUS: return EXPR_SUB;
-	case TOKEN_STAR: return EXPR_MUL;
-	case TOKEN_FSLASH: return EXPR_DIV;
-	case TOKEN_AMPERSAND: return EXPR_ADDR;
-	case TOKEN_PERIOD: return EXPR_STRUCT_ACCESS;
-	case TOKEN_ARROW: return EXPR_ARROW;
-	case TOKEN_COMP_EQ: return EXPR_COMP_EQ;
-	case TOKEN_COMP_GE: return EXPR_COMP_GE;
-	case TOKEN_COMP_LE: return EXPR_COMP_LE;
-	case TOKEN_COMP_NE: return EXPR_COMP_NE;
-	case TOKEN_COMP_GT: return EXPR_COMP_GT;
-	case TOKEN_COMP_LT: return EXPR_COMP_LT;
-	case TOKEN_LOGIC_AND: return EXPR_LOGIC_AND;
-	case TOKEN_LOGIC_OR: return EXPR_LOGIC_OR;
-	case TOKEN_LOGIC_NOT: return EXPR_LOGIC_NOT;
-	default: assert(0);
-	}
-}
+static size_t parse_expr(Parser *prs, size_t *index, int min_prec, unsigned depth, Error *err);
 
-static int op_precedence(ExprOpType type)
+// 0 if type isn't a binary operator
+static int infix_precedence(TokenType type)
 {
 	switch(type) {
-	case EXPR_FN_CALL:
-	case EXPR_LPAREN:
-	case EXPR_ARRAY_LIT:
-	case EXPR_STRUCT_LIT:
-		return 0;
-	case EXPR_LOGIC_OR:
+	case TOKEN_LOGIC_OR:
 		return 1;
-	case EXPR_LOGIC_AND:
+	case TOKEN_LOGIC_AND:
 		return 2;
-	case EXPR_COMP_EQ:
-	case EXPR_COMP_GE:
-	case EXPR_COMP_LE:
-	case EXPR_COMP_NE:
-	case EXPR_COMP_GT:
-	case EXPR_COMP_LT:
+	case TOKEN_COMP_EQ:
+	case TOKEN_COMP_GE:
+	case TOKEN_COMP_LE:
+	case TOKEN_COMP_NE:
+	case TOKEN_COMP_GT:
+	case TOKEN_COMP_LT:
 		return 3;
-	case EXPR_ADD:
-	case EXPR_SUB:
+	case TOKEN_PLUS:
+	case TOKEN_MINUS:
 		return 4;
-	case EXPR_MUL:
-	case EXPR_DIV:
+	case TOKEN_STAR:
+	case TOKEN_FSLASH:
 		return 5;
-	case EXPR_LOGIC_NOT:
-	case EXPR_ADDR:
-	case EXPR_DEREF:
-		return 6;
-	case EXPR_STRUCT_ACCESS:
-	case EXPR_ARROW:
-		return 7;
-	default: assert(0);
+	default:
+		return 0;
 	}
 }
 
-static AstNodeType op_to_ast(ExprOpType type)
+static AstNodeType infix_to_ast(TokenType type)
 {
 	switch(type) {
-	case EXPR_COMP_EQ: return AST_COMP_EQ;
-	case EXPR_COMP_GE: return AST_COMP_GE;
-	case EXPR_COMP_LE: return AST_COMP_LE;
-	case EXPR_COMP_NE: return AST_COMP_NE;
-	case EXPR_COMP_GT: return AST_COMP_GT;
-	case EXPR_COMP_LT: return AST_COMP_LT;
-	case EXPR_LOGIC_AND: return AST_LOGIC_AND;
-	case EXPR_LOGIC_OR: return AST_LOGIC_OR;
-	case EXPR_LOGIC_NOT: return AST_LOGIC_NOT;
-	case EXPR_ADD: return AST_ADD;
-	case EXPR_SUB: return AST_SUB;
-	case EXPR_MUL: return AST_MUL;
-	case EXPR_DIV: return AST_DIV;
-	case EXPR_ADDR: return AST_ADDR;
-	case EXPR_DEREF: return AST_DEREF;
-	case EXPR_STRUCT_ACCESS: return AST_STRUCT_ACCESS;
-	case EXPR_ARROW: return AST_ARROW;
+	case TOKEN_COMP_EQ: return AST_COMP_EQ;
+	case TOKEN_COMP_GE: return AST_COMP_GE;
+	case TOKEN_COMP_LE: return AST_COMP_LE;
+	case TOKEN_COMP_NE: return AST_COMP_NE;
+	case TOKEN_COMP_GT: return AST_COMP_GT;
+	case TOKEN_COMP_LT: return AST_COMP_LT;
+	case TOKEN_LOGIC_AND: return AST_LOGIC_AND;
+	case TOKEN_LOGIC_OR: return AST_LOGIC_OR;
+	case TOKEN_PLUS: return AST_ADD;
+	case TOKEN_MINUS: return AST_SUB;
+	case TOKEN_STAR: return AST_MUL;
+	case TOKEN_FSLASH: return AST_DIV;
 	default: assert(0);
 	}
 }
 
-static void pop_op(Parser *prs, ExprOp *op, DynArr *free_list, size_t index, size_t loc, Error *err)
+// Pushes a leaf node and returns its index
+static size_t parse_leaf(Parser *prs, AstNode node, Error *err)
 {
-	size_t *rhs;
-	size_t *lhs;
-
-	if(!loc) loc = prs->ast.len;
+	nodelist_push(&prs->ast, node, err);
+	return prs->ast.len - 1;
+}
 
-	switch(op->type) {
-	case EXPR_LOGIC_NOT:
-	case EXPR_ADDR:
-	case EXPR_DEREF:
-		rhs = dynarr_pop(free_list);
-		if(!rhs) {
-			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
-				"Expected operand for unary operator at %l\n",
-				&op->debug
-			);
-			*err = ERROR_UNEXPECTED_DATA;
-			goto RET;
+// fn(args...), *index is on the identifier
+static size_t parse_fn_call(Parser *prs, size_t *index, unsigned depth, Error *err)
+{
+	AstNode fn_call = {
+		.fn_call = {
+			.com = {AST_FN_CALL, TOK_DEBUG(*index + 1)},
+			.fn_id = TOK_VAL(*index),
+		},
+	};
+	*index += 2;
+
+	size_t count = 0;
+	size_t first = 0;
+	size_t prev = 0;
+	while(TOK_TYPE(*index) != TOKEN_RPAREN) {
+		if(count) {
+			if(TOK_TYPE(*index) != TOKEN_COMMA) {
+				wyrt_diag(
+					prs->diag, prs->identifiers, prs->strings, NULL,
+					"Expected ',' or ')' in function call, found %T\n",
+					&prs->tokens, TOK(*index)
+				);
+				*err = ERROR_UNEXPECTED_DATA;
+				goto RET;
+			}
+			*index += 1;
 		}
 
-		nodelist_push(
-			&prs->ast,
-			(AstNode) {
-				.unary_op = {
-					.com = {op_to_ast(op->type), op->debug},
-					.val = *rhs - loc
-				},
-			},
-			err
+		size_t arg = parse_expr(prs, index, 1, depth + 1, err);
+		if(*err) goto RET;
+
+		if(count) prs->ast.nodes[prev].com.next = arg - prev;
+		else first = arg;
+		prev = arg;
+		count++;
+	}
+	*index += 1;
+
+	fn_call.fn_call.arg_count = count;
+	fn_call.fn_call.args = count ? first - prs->ast.len : 0;
+	nodelist_push(&prs->ast, fn_call, err);
+
+RET:
+	return prs->ast.len - 1;
+}
+
+// {elems...}, *index is on the '{'
+static size_t parse_array_lit(Parser *prs, size_t *index, unsigned depth, Error *err)
+{
+	AstNode array_lit = {
+		.array_lit = {
+			.com = {AST_ARRAY_LIT, TOK_DEBUG(*index)},
+		},
+	};
+	*index += 1;
+
+	if(TOK_TYPE(*index) == TOKEN_RCURLY) {
+		wyrt_diag(
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Malformed array literal at %l\n",
+			&TOK_DEBUG(*index)
 		);
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
+
+	size_t count = 0;
+	size_t first = 0;
+	size_t prev = 0;
+	do {
+		if(count) *index += 1; // ','
+
+		size_t elem = parse_expr(prs, index, 1, depth + 1, err);
 		if(*err) goto RET;
-		break;
 
-	case EXPR_COMP_EQ:
-	case EXPR_COMP_GE:
-	case EXPR_COMP_LE:
-	case EXPR_COMP_NE:
-	case EXPR_COMP_GT:
-	case EXPR_COMP_LT:
-	case EXPR_LOGIC_AND:
-	case EXPR_LOGIC_OR:
-	case EXPR_ADD:
-	case EXPR_SUB:
-	case EXPR_MUL:
-	case EXPR_DIV:
-		rhs = dynarr_pop(free_list);
-		if(!rhs) {
+		if(count) prs->ast.nodes[prev].com.next = elem - prev;
+		else first = elem;
+		prev = elem;
+		count++;
+	} while(TOK_TYPE(*index) == TOKEN_COMMA);
+
+	if(TOK_TYPE(*index) != TOKEN_RCURLY) {
+		wyrt_diag(
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Expected ',' or '}' in array literal, found %T\n",
+			&prs->tokens, TOK(*index)
+		);
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
+	*index += 1;
+
+	array_lit.array_lit.elem_count = count;
+	array_lit.array_lit.elems = first - prs->ast.len;
+	nodelist_push(&prs->ast, array_lit, err);
+
+RET:
+	return prs->ast.len - 1;
+}
+
+// parent{.member = value, ...}, *index is on the '{'
+static size_t parse_struct_lit(Parser *prs, size_t *index, Id parent, DebugInfo debug, unsigned depth, Error *err)
+{
+	AstNode struct_lit = {
+		.struct_lit = {
+			.com = {AST_STRUCT_LIT, debug},
+			.parent_id = parent,
+		},
+	};
+	*index += 1;
+
+	if(TOK_TYPE(*index) == TOKEN_RCURLY) {
+		wyrt_diag(
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Malformed struct literal at %l\n",
+			&TOK_DEBUG(*index)
+		);
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
+
+	size_t count = 0;
+	size_t first_name = 0, first_value = 0;
+	size_t prev_name = 0, prev_value = 0;
+	do {
+		if(count) *index += 1; // ','
+
+		if(TOK_TYPE(*index) != TOKEN_PERIOD) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
-				"Expected operands for binary operator at %l\n",
-				&op->debug
+				prs->diag, prs->identifiers, prs->strings, NULL,
+				"Expected '.' in struct literal, found %T\n",
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
+		*index += 1;
 
-		lhs = dynarr_pop(free_list);
-		if(!lhs) {
+		if(TOK_TYPE(*index) != TOKEN_IDENT) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
-				"Expected second operand for binary operator at %l\n",
-				&op->debug
+				prs->diag, prs->identifiers, prs->strings, NULL,
+				"Expected identifier in struct literal, found %T\n",
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
 
-		nodelist_push(
-			&prs->ast,
+		size_t name = parse_leaf(
+			prs,
 			(AstNode) {
-				.binop = {
-					.com = {op_to_ast(op->type), op->debug},
-					.lhs = *lhs - loc,
-					.rhs = *rhs - loc
+				.ident = {
+					.com = {AST_IDENT, TOK_DEBUG(*index)},
+					.id = TOK_VAL(*index),
 				},
 			},
 			err
 		);
 		if(*err) goto RET;
-		break;
-	
-	case EXPR_STRUCT_ACCESS:
-	case EXPR_ARROW:
-		rhs = dynarr_pop(free_list);
-		if(!rhs) {
-			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
-				"Expected operands for binary operator at %l\n",
-				&op->debug
-			);
-			*err = ERROR_UNEXPECTED_DATA;
-			goto RET;
-		}
 
-		lhs = dynarr_pop(free_list);
-		if(!lhs) {
-			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
-				"Expected second operand for binary operator at %l\n",
-				&op->debug
-			);
-			*err = ERROR_UNEXPECTED_DATA;
-			goto RET;
-		}
+		*index += 1;
 
-		if(prs->ast.nodes[*rhs].type != AST_IDENT) {
+		if(TOK_TYPE(*index) != TOKEN_ASSIGN) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
-				"Expected Identifier for struct access at %l\n",
-				&prs->ast.nodes[*rhs].com.debug
+				prs->diag, prs->identifiers, prs->strings, NULL,
+				"Expected '=' in struct literal, found %T\n",
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
 
-		nodelist_push(
-			&prs->ast,
-			(AstNode) {
-				.struct_access = {
-					.com = {op_to_ast(op->type), op->debug},
-					.parent = *lhs - loc,
-					.member_id = prs->ast.nodes[*rhs].ident.id,
-				},
-			},
-			err
-		);
+		*index += 1;
+
+		size_t value = parse_expr(prs, index, 1, depth + 1, err);
 		if(*err) goto RET;
-		break;
 
+		if(count) {
+			prs->ast.nodes[prev_name].com.next = name - prev_name;
+			prs->ast.nodes[prev_value].com.next = value - prev_value;
+		} else {
+			first_name = name;
+			first_value = value;
+		}
+		prev_name = name;
+		prev_value = value;
+		count++;
+	} while(TOK_TYPE(*index) == TOKEN_COMMA);
 
-	case EXPR_NONE:
-	case EXPR_LPAREN:
-	case EXPR_FN_CALL:
-	case EXPR_ARRAY_LIT:
-	case EXPR_SUBSCRIPT:
-	case EXPR_STRUCT_LIT:
+	if(TOK_TYPE(*index) != TOKEN_RCURLY) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
-			"Malformed Expression at %l\n",
-			&prs->tokens[index].debug.debug_info
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Expected ',' or '}' in struct literal, found %T\n",
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
 	}
+	*index += 1;
 
-	dynarr_push(free_list, &(size_t) {prs->ast.len - 1}, err);
-	if(*err) goto RET;
+	struct_lit.struct_lit.member_count = count;
+	struct_lit.struct_lit.member_names = first_name - prs->ast.len;
+	struct_lit.struct_lit.member_values = first_value - prs->ast.len;
+	nodelist_push(&prs->ast, struct_lit, err);
 
 RET:
-	return;
+	return prs->ast.len - 1;
 }
 
-static void handle_EXPR(Parser *prs, size_t *index, Error *err)
+// Literals, identifiers, calls and parentheses
+static size_t parse_primary(Parser *prs, size_t *index, unsigned depth, Error *err)
 {
-	size_t ref = parsestack_top(&prs->parse_stack)->ref;
-	DynArr free_list;
-	DynArr op_stack;
-	dynarr_init(&free_list, sizeof(size_t));
-	dynarr_init(&op_stack, sizeof(ExprOp));
-
-	bool ended = false;
-
-	bool has_prev_op = true;
-	while(!ended) {
-		switch(prs->tokens[*index].type) {
-		case TOKEN_COMMA: {
-			bool found = false;
-			for(size_t i = 0; i < op_stack.count; i++) {
-				ExprOp *op = dynarr_from_back(&op_stack, i);
-
-				if(op->type == EXPR_FN_CALL
-					|| op->type == EXPR_ARRAY_LIT
-					|| op->type == EXPR_STRUCT_LIT
-				) {
-					op->extra += 1;
-					found = true;
-					break;
-				}
-			}
-			
-			if(!found) {
-				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
-					"Unexpected %T\n",
-					&prs->tokens[*index]
-				);
-				*err = ERROR_UNEXPECTED_DATA;
-				goto RET;
-			}
-			
-			*index += 1;
-			has_prev_op = true;
-		} break;
-
-		case TOKEN_ASSIGN:
-		case TOKEN_SEMICOLON:
-		case TOKEN_ADD_ASSIGN:
-		case TOKEN_SUB_ASSIGN:
-		case TOKEN_MUL_ASSIGN:
-		case TOKEN_DIV_ASSIGN:
-			ended = true;
-			break;
-
-		case TOKEN_LPAREN:
-			dynarr_push(&op_stack, &(ExprOp) {EXPR_LPAREN}, err);
-			if(*err) goto RET;
-			*index += 1;
-			has_prev_op = true;
-			break;
-		case TOKEN_RPAREN: {
-			ExprOp *op;
-			do {
-				op = (ExprOp*)dynarr_pop(&op_stack);
-				if(!op) {
-					ended = true;
-					*index -= 1;
-					break;
-				}
+	size_t node = 0;
+
+	switch(TOK_TYPE(*index)) {
+	case TOKEN_STRING_LIT:
+	case TOKEN_ZSTRING_LIT:
+	case TOKEN_CSTRING_LIT:
+		node = parse_leaf(
+			prs,
+			(AstNode) {
+				.string_lit = {
+					.com = {
+						.type = AST_STRING_LIT + (TOK_TYPE(*index) - TOKEN_STRING_LIT),
+						.debug = TOK_DEBUG(*index),
+					},
+					.id = TOK_VAL(*index),
+				},
+			},
+			err
+		);
+		*index += 1;
+		break;
 
-				if(op->type == EXPR_LPAREN) break;
-				if(op->type == EXPR_FN_CALL) {
-					AstNode fn_call = {
-						.fn_call = {
-							.com = {AST_FN_CALL, op->debug},
-							.fn_id = op->id,
-						},
-					};
-
-					if(!op->extra && has_prev_op) {
-						fn_call.fn_call.args = 0;
-						fn_call.fn_call.arg_count = 0;
-					} else {
-						fn_call.fn_call.arg_count = op->extra + 1;
-						fn_call.fn_call.args = *(size_t*)dynarr_from_back(&free_list, op->extra)
-							- prs->ast.len;
-
-						AstNode *arg = &prs->ast.nodes[fn_call.fn_call.args + prs->ast.len];
-						for(size_t i = 1; i < op->extra + 1; i++) {
-							arg->com.next = *(size_t*)dynarr_from_back(&free_list, op->extra - i)
-								- (arg - prs->ast.nodes);
-							arg += arg->com.next;
-						}
-						free_list.count -= op->extra + 1;
-					}
-
-					nodelist_push(&prs->ast, fn_call, err);
-					if(*err) goto RET;
-					dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-					if(*err) goto RET;
-					break;
-				}
+	case TOKEN_INT_LIT:
+		node = parse_leaf(
+			prs,
+			(AstNode) {
+				.int_lit = {
+					.com = {AST_INT_LIT, TOK_DEBUG(*index)},
+					.val = TOK_INT(*index),
+				},
+			},
+			err
+		);
+		*index += 1;
+		break;
 
-				size_t loc = op_stack.count == 0 ? ref : 0;
-				pop_op(prs, op, &free_list, *index, loc, err);
-				if(*err) goto RET;
-			} while(true);
-			has_prev_op = false;
-			*index += 1;
-		} break;
+	case TOKEN_CHAR_LIT:
+		node = parse_leaf(
+			prs,
+			(AstNode) {
+				.int_lit = {
+					.com = {AST_CHAR_LIT, TOK_DEBUG(*index)},
+					.val = (char) TOK_VAL(*index),
+				},
+			},
+			err
+		);
+		*index += 1;
+		break;
 
-		case TOKEN_RCURLY: {
-			ExprOp *op;
-			do {
-				op = (ExprOp*)dynarr_pop(&op_stack);
-				if(!op) {
-					wyrt_diag(
-						stderr, prs->identifiers, prs->strings, NULL,
-						"Extra %T\n",
-						&prs->tokens[*index]
-					);
-					*err = ERROR_UNEXPECTED_DATA;
-					goto RET;
-				}
+	case TOKEN_IDENT:
+		switch(TOK_TYPE(*index + 1)) {
+		case TOKEN_LPAREN:
+			node = parse_fn_call(prs, index, depth, err);
+			break;
 
-				if(op->type == EXPR_ARRAY_LIT) {
-					AstNode array_lit = {
-						.array_lit = {
-							.com = {AST_ARRAY_LIT, op->debug},
-							.elem_count = op->extra + 1,
-							.elems = 0,
-						},
-					};
-
-					if(free_list.count < op->extra + 1) {
-						wyrt_diag(
-							stderr, prs->identifiers, prs->strings, NULL,
-							"Malformed array literal at %l\n",
-							&prs->tokens[*index].debug.debug_info
-						);
-						*err = ERROR_UNEXPECTED_DATA;
-						goto RET;
-					}
-
-					array_lit.array_lit.elems = *(size_t*)dynarr_from_back(&free_list, op->extra)
-						- prs->ast.len;
-					AstNode *elem = &prs->ast.nodes[array_lit.array_lit.elems + prs->ast.len];
-					for(size_t i = 1; i < op->extra + 1; i++) {
-						elem->com.next = *(size_t*)dynarr_from_back(&free_list, op->extra - i)
-							- (elem - prs->ast.nodes);
-						elem += elem->com.next;
-					}
-					free_list.count -= op->extra + 1;
-
-					nodelist_push(&prs->ast, array_lit, err);
-					if(*err) goto RET;
-					dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-					if(*err) goto RET;
-					break;
-				} else if(op->type == EXPR_STRUCT_LIT) {
-					AstNode struct_lit = {
-						.struct_lit = {
-							.com = {AST_STRUCT_LIT, op->debug},
-							.parent_id = op->id,
-							.member_count = (op->extra + 1) / 2,
-							.member_names = 0,
-							.member_values = 0,
-						},
-					};
-
-					if(free_list.count < op->extra + 1) {
-						wyrt_diag(
-							stderr, prs->identifiers, prs->strings, NULL,
-							"Malformed struct literal at %l\n",
-							&prs->tokens[*index].debug.debug_info
-						);
-						*err = ERROR_UNEXPECTED_DATA;
-						goto RET;
-					}
-
-					size_t member_idx = *(size_t*)dynarr_from_back(&free_list, 1);
-					size_t value_idx = *(size_t*)dynarr_from_back(&free_list, 0);
-					for(size_t i = 2; i < op->extra + 1; i += 2) {
-						size_t new_member_idx = *(size_t*)dynarr_from_back(&free_list, i + 1);
-						size_t new_value_idx = *(size_t*)dynarr_from_back(&free_list, i);
-
-						prs->ast.nodes[new_member_idx].com.next = member_idx - new_member_idx;
-						prs->ast.nodes[new_value_idx].com.next = value_idx - new_value_idx;
-						member_idx = new_member_idx;
-						value_idx = new_value_idx;
-					}
-					struct_lit.struct_lit.member_names = member_idx - prs->ast.len;
-					struct_lit.struct_lit.member_values = value_idx - prs->ast.len;
-					free_list.count -= op->extra + 1;
-
-					nodelist_push(&prs->ast, struct_lit, err);
-					if(*err) goto RET;
-					dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-					if(*err) goto RET;
-					break;
-				} else {
-					pop_op(prs, op, &free_list, *index, 0, err);
-					if(*err) goto RET;
-				}
-			} while(true);
-			has_prev_op = false;
+		case TOKEN_LCURLY:
 			*index += 1;
-		} break;
-
-		case TOKEN_LSQUARE: {
-			ExprOp *top = dynarr_from_back(&op_stack, 0);
-			while(top && (top->type == EXPR_STRUCT_ACCESS || top->type == EXPR_ARROW)) {
-				pop_op(prs, top, &free_list, *index, 0, err);
-				op_stack.count -= 1;
-				top = dynarr_from_back(&op_stack, 0);
-				if(*err) goto RET;
-			}
-
-			if(!free_list.count) {
-				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
-					"Expected Parent of Subscript, found %T\n",
-					&prs->tokens[*index].debug.debug_info
-				);
-				*err = ERROR_UNEXPECTED_DATA;
-				goto RET;
-			}
+			node = parse_struct_lit(prs, index, TOK_VAL(*index - 1), TOK_DEBUG(*index), depth, err);
+			break;
 
-			size_t arr = *(size_t*)dynarr_pop(&free_list);
-			dynarr_push(
-				&op_stack,
-				&(ExprOp) {
-					.type = EXPR_SUBSCRIPT,
-					.debug = prs->tokens[*index].debug.debug_info,
-					.extra = arr,
+		default:
+			node = parse_leaf(
+				prs,
+				(AstNode) {
+					.ident = {
+						.com = {AST_IDENT, TOK_DEBUG(*index)},
+						.id = TOK_VAL(*index),
+					},
 				},
 				err
 			);
-			if(*err) goto RET;
-
 			*index += 1;
-			has_prev_op = true;
-		} break;
+			break;
+		}
+		break;
 
-		case TOKEN_RSQUARE: {
-			do {
-				ExprOp *op = dynarr_pop(&op_stack);
-				if(!op) {
-					wyrt_diag(
-						stderr, prs->identifiers, prs->strings, NULL,
-						"Extra ']' at %l\n",
-						&prs->tokens[*index].debug.debug_info
-					);
-					*err = ERROR_UNEXPECTED_DATA;
-					goto RET;
-				}
+	case TOKEN_UNDERSCORE:
+		*index += 1;
 
-				if(op->type == EXPR_SUBSCRIPT) {
-					size_t *idx = dynarr_pop(&free_list);
-
-					nodelist_push(
-						&prs->ast,
-						(AstNode) {
-							.subscript = {
-								.com = {AST_SUBSCRIPT, op->debug},
-								.arr = op->extra - prs->ast.len,
-								.index = *idx - prs->ast.len,
-							},
-						},
-						err
-					);
-					if(*err) goto RET;
+		if(TOK_TYPE(*index) != TOKEN_LCURLY) {
+			wyrt_diag(
+				prs->diag, prs->identifiers, prs->strings, NULL,
+				"Expected struct literal, found %T\n",
+				&prs->tokens, TOK(*index)
+			);
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
+		}
 
-					dynarr_push(&free_list, &(size_t){prs->ast.len - 1}, err);
-					if(*err) goto RET;
-					break;
-				}
+		// Anonymous struct literals are located at the token after the '{'
+		node = parse_struct_lit(prs, index, 0, TOK_DEBUG(*index + 1), depth, err);
+		break;
 
-				pop_op(prs, op, &free_list, *index, 0, err);
-				if(*err) goto RET;
-			} while(true);
-			*index += 1;
+	case TOKEN_LCURLY:
+		node = parse_array_lit(prs, index, depth, err);
+		break;
 
-		} break;
+	case TOKEN_LPAREN:
+		*index += 1;
+		node = parse_expr(prs, index, 1, depth + 1, err);
+		if(*err) goto RET;
 
-		case TOKEN_STRING_LIT:
-		case TOKEN_ZSTRING_LIT:
-		case TOKEN_CSTRING_LIT: {
-			nodelist_push(
-				&prs->ast,
-				(AstNode) {
-					.string_lit = {
-						.com = {
-							.type = AST_STRING_LIT + (prs->tokens[*index].type - TOKEN_STRING_LIT),
-							.debug = prs->tokens[*index].debug.debug_info,
-						},
-						.id = prs->tokens[*index].string_lit.id,
-					},
-				},
-				err
+		if(TOK_TYPE(*index) != TOKEN_RPAREN) {
+			wyrt_diag(
+				prs->diag, prs->identifiers, prs->strings, NULL,
+				"Expected ')', found %T\n",
+				&prs->tokens, TOK(*index)
 			);
-			if(*err) goto RET;
+			*err = ERROR_UNEXPECTED_DATA;
+			goto RET;
+		}
+		*index += 1;
+		break;
 
-			dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-			if(*err) goto RET;
+	default:
+		wyrt_diag(
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Expected Expression, found %T\n",
+			&prs->tokens, TOK(*index)
+		);
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
 
+RET:
+	return node;
+}
+
+// A primary followed by any number of .member ->member [index]
+static size_t parse_postfix(Parser *prs, size_t *index, unsigned depth, Error *err)
+{
+	size_t node = parse_primary(prs, index, depth, err);
+	if(*err) goto RET;
+
+	while(true) {
+		const DebugInfo debug = TOK_DEBUG(*index);
+
+		switch(TOK_TYPE(*index)) {
+		case TOKEN_PERIOD:
+		case TOKEN_ARROW: {
+			AstNodeType type = TOK_TYPE(*index) == TOKEN_PERIOD ? AST_STRUCT_ACCESS : AST_ARROW;
 			*index += 1;
-			has_prev_op = false;
-		} break;
 
-		case TOKEN_INT_LIT:
-			if(!has_prev_op) {
+			if(TOK_TYPE(*index) != TOKEN_IDENT) {
 				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
-					"Malformed Expression: extra %T\n",
-					&prs->tokens[*index]
+					prs->diag, prs->identifiers, prs->strings, NULL,
+					"Expected Identifier for struct access at %l\n",
+					&TOK_DEBUG(*index)
 				);
 				*err = ERROR_UNEXPECTED_DATA;
 				goto RET;
 			}
 
-			nodelist_push(
-				&prs->ast,
+			// The member's name gets a node of its own, codegen only reads member_id
+			Id member = TOK_VAL(*index);
+			parse_leaf(
+				prs,
 				(AstNode) {
-					.int_lit = {
-						.com = {AST_INT_LIT, prs->tokens[*index].debug.debug_info},
-						.val = prs->tokens[*index].int_lit.val,
+					.ident = {
+						.com = {AST_IDENT, TOK_DEBUG(*index)},
+						.id = member,
 					},
 				},
 				err
 			);
 			if(*err) goto RET;
-
-			dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-			if(*err) goto RET;
-
 			*index += 1;
-			has_prev_op = false;
-			break;
-
-		case TOKEN_CHAR_LIT:
-			if(!has_prev_op) {
-				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
-					"Malformed Expression: extra %T\n",
-					&prs->tokens[*index]
-				);
-				*err = ERROR_UNEXPECTED_DATA;
-				goto RET;
-			}
 
 			nodelist_push(
 				&prs->ast,
 				(AstNode) {
-					.int_lit = {
-						.com = {AST_CHAR_LIT, prs->tokens[*index].debug.debug_info},
-						.val = prs->tokens[*index].char_lit.val,
+					.struct_access = {
+						.com = {type, debug},
+						.parent = node - prs->ast.len,
+						.member_id = member,
 					},
 				},
 				err
 			);
 			if(*err) goto RET;
+		} break;
 
-			dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-			if(*err) goto RET;
-
-			*index += 1;
-			has_prev_op = false;
-			break;
-
-		case TOKEN_UNDERSCORE:
-			*index += 1;
-
-			if(prs->tokens[*index].type != TOKEN_LCURLY) {
-				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
-					"Expected struct literal, found %T\n",
-					&prs->tokens[*index]
-				);
-				*err = ERROR_UNEXPECTED_DATA;
-				goto RET;
-			}
-
+		case TOKEN_LSQUARE: {
 			*index += 1;
-
-			dynarr_push(
-				&op_stack,
-				&(ExprOp) {
-					.type = EXPR_STRUCT_LIT,
-					.debug = prs->tokens[*index].debug.debug_info,
-					.extra = 0,
-					.id = 0,
-				},
-				err
-			);
+			size_t subscript = parse_expr(prs, index, 1, depth + 1, err);
 			if(*err) goto RET;
-			break;
 
-		case TOKEN_IDENT:
-			if(!has_prev_op) {
+			if(TOK_TYPE(*index) != TOKEN_RSQUARE) {
 				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
-					"Malformed Expression: extra %T\n",
-					&prs->tokens[*index]
+					prs->diag, prs->identifiers, prs->strings, NULL,
+					"Expected ']', found %T\n",
+					&prs->tokens, TOK(*index)
 				);
 				*err = ERROR_UNEXPECTED_DATA;
 				goto RET;
 			}
-			switch(prs->tokens[*index + 1].type) {
-			case TOKEN_LPAREN:
-				*index += 1;
-				dynarr_push(
-					&op_stack,
-					&(ExprOp) {
-						.type = EXPR_FN_CALL,
-						.debug = prs->tokens[*index].debug.debug_info,
-						.extra = 0,
-						.id = prs->tokens[*index - 1].ident.id,
-					},
-					err
-				);
-				if(*err) goto RET;
-				break;
-
-			case TOKEN_LCURLY:
-				*index += 1;
-				dynarr_push(
-					&op_stack,
-					&(ExprOp) {
-						.type = EXPR_STRUCT_LIT,
-						.debug = prs->tokens[*index].debug.debug_info,
-						.extra = 0,
-						.id = prs->tokens[*index - 1].ident.id,
-					},
-					err
-				);
-				if(*err) goto RET;
-				break;
-
-			default:
-				nodelist_push(
-					&prs->ast,
-					(AstNode) {
-						.ident = {
-							.com = {AST_IDENT, prs->tokens[*index].debug.debug_info},
-							.id = prs->tokens[*index].ident.id,
-						},
-					},
-					err
-				);
-				if(*err) goto RET;
-				dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-				if(*err) goto RET;
-				has_prev_op = false;
-				break;
-			}
 			*index += 1;
-			break;
 
-		case TOKEN_LCURLY:
-			dynarr_push(
-				&op_stack,
-				&(ExprOp) {
-					.type = EXPR_ARRAY_LIT,
-					.debug = prs->tokens[*index].debug.debug_info,
-					.extra = 0,
+			nodelist_push(
+				&prs->ast,
+				(AstNode) {
+					.subscript = {
+						.com = {AST_SUBSCRIPT, debug},
+						.arr = node - prs->ast.len,
+						.index = subscript - prs->ast.len,
+					},
 				},
 				err
 			);
 			if(*err) goto RET;
-			*index += 1;
-			break;
+		} break;
 
-		case TOKEN_PERIOD:
-			if(prs->tokens[*index - 1].type == TOKEN_COMMA
-				|| prs->tokens[*index - 1].type == TOKEN_LCURLY
-			) {
-				*index += 1;
-				if(prs->tokens[*index].type != TOKEN_IDENT) {
-					wyrt_diag(
-						stderr, prs->identifiers, prs->strings, NULL,
-						"Expected identifier in struct literal, found %T\n",
-						&prs->tokens[*index]
-					);
-					*err = ERROR_UNEXPECTED_DATA;
-					goto RET;
-				}
+		default:
+			goto RET;
+		}
+		node = prs->ast.len - 1;
+	}
 
-				nodelist_push(
-					&prs->ast,
-					(AstNode) {
-						.ident = {
-							.com = {AST_IDENT, prs->tokens[*index].debug.debug_info},
-							.id = prs->tokens[*index].ident.id,
-						},
-					},
-					err
-				);
-				if(*err) goto RET;
+RET:
+	return node;
+}
 
-				*index += 1;
+// Prefix * & ! bind looser than postfix operators, tighter than binary ones
+static size_t parse_unary(Parser *prs, size_t *index, unsigned depth, Error *err)
+{
+	size_t node = 0;
+	if(depth > EXPR_DEPTH_MAX) {
+		wyrt_diag(
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Expression nested too deeply at %l\n",
+			&TOK_DEBUG(*index)
+		);
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
 
-				if(prs->tokens[*index].type != TOKEN_ASSIGN) {
-					wyrt_diag(
-						stderr, prs->identifiers, prs->strings, NULL,
-						"Expected '=' in struct literal, found %T\n",
-						&prs->tokens[*index]
-					);
-					*err = ERROR_UNEXPECTED_DATA;
-					goto RET;
-				}
+	AstNodeType type;
+	switch(TOK_TYPE(*index)) {
+	case TOKEN_STAR: type = AST_DEREF; break;
+	case TOKEN_AMPERSAND: type = AST_ADDR; break;
+	case TOKEN_LOGIC_NOT: type = AST_LOGIC_NOT; break;
+	default:
+		node = parse_postfix(prs, index, depth, err);
+		goto RET;
+	}
 
-				*index += 1;
+	const DebugInfo debug = TOK_DEBUG(*index);
+	*index += 1;
 
-				dynarr_push(&free_list, &(size_t) {prs->ast.len - 1}, err);
-				if(*err) goto RET;
+	size_t val = parse_unary(prs, index, depth + 1, err);
+	if(*err) goto RET;
 
-				ExprOp *op = dynarr_from_back(&op_stack, 0);
-				if(!op || op->type != EXPR_STRUCT_LIT) {
-					wyrt_diag(
-						stderr, prs->identifiers, prs->strings, NULL,
-						"Expected to be inside a struct literal at %l\n",
-						&prs->tokens[*index].debug.debug_info
-					);
-					*err = ERROR_UNEXPECTED_DATA;
-					goto RET;
-				}
+	nodelist_push(
+		&prs->ast,
+		(AstNode) {
+			.unary_op = {
+				.com = {type, debug},
+				.val = val - prs->ast.len,
+			},
+		},
+		err
+	);
+	node = prs->ast.len - 1;
 
-				op->extra += 1;
-				break;
-			}
-			//fallthrough
-		case TOKEN_COMP_EQ:
-		case TOKEN_COMP_GE:
-		case TOKEN_COMP_LE:
-		case TOKEN_COMP_NE:
-		case TOKEN_COMP_GT:
-		case TOKEN_COMP_LT:
-		case TOKEN_LOGIC_AND:
-		case TOKEN_LOGIC_OR:
-		case TOKEN_LOGIC_NOT:
-		case TOKEN_PLUS:
-		case TOKEN_MINUS:
-		case TOKEN_STAR:
-		case TOKEN_FSLASH:
-		case TOKEN_AMPERSAND:
-		case TOKEN_ARROW: {
-			ExprOpType this = token_to_op(prs->tokens[*index].type);
-			if(this == EXPR_MUL && has_prev_op) this = EXPR_DEREF;
-
-			ExprOp *top;
-			bool higher_prec;
-			do {
-				top = dynarr_from_back(&op_stack, 0);
-				if(!top) break;
-				higher_prec = op_precedence(top->type) >= op_precedence(this);
-				
-				if(higher_prec) {
-					ExprOp *op = dynarr_pop(&op_stack);
-
-					pop_op(prs, op, &free_list, *index, 0, err);
-					if(*err) goto RET;
-				}				
-			} while(higher_prec);
-
-			dynarr_push(&op_stack, &(ExprOp) {this, prs->tokens[*index].debug.debug_info}, err);
-			if(*err) goto RET;
-			has_prev_op = true;
-			*index += 1;
-		} break;
+RET:
+	return node;
+}
 
-		default:
-			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
-				"Expected Expression, found %T\n",
-				&prs->tokens[*index]
-			);
-			*err = ERROR_UNEXPECTED_DATA;
-			goto RET;
-		}
-	}
+// Parses operators that bind at least as tightly as min_prec.
+// Returns the index of the expression's root, which is the last node pushed.
+static size_t parse_expr(Parser *prs, size_t *index, int min_prec, unsigned depth, Error *err)
+{
+	size_t lhs = parse_unary(prs, index, depth, err);
+	if(*err) goto RET;
 
-	while(op_stack.count) {
-		ExprOp *op = dynarr_pop(&op_stack);
-		
-		size_t loc = op_stack.count == 0 ? ref : 0;
-		pop_op(prs, op, &free_list, *index, loc, err);
+	int prec;
+	while((prec = infix_precedence(TOK_TYPE(*index))) >= min_prec) {
+		const DebugInfo debug = TOK_DEBUG(*index);
+		AstNodeType type = infix_to_ast(TOK_TYPE(*index));
+		*index += 1;
+
+		size_t rhs = parse_expr(prs, index, prec + 1, depth + 1, err);
 		if(*err) goto RET;
-	}
 
-	if(free_list.count != 1) {
-		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
-			"Malformed Expression at %l\n",
-			prs->tokens[*index].debug.debug_info
+		nodelist_push(
+			&prs->ast,
+			(AstNode) {
+				.binop = {
+					.com = {type, debug},
+					.lhs = lhs - prs->ast.len,
+					.rhs = rhs - prs->ast.len,
+				},
+			},
+			err
 		);
-		*err = ERROR_UNEXPECTED_DATA;
-		goto RET;
+		if(*err) goto RET;
+		lhs = prs->ast.len - 1;
 	}
 
-	switch(prs->ast.nodes[prs->ast.len - 1].type) {
+RET:
+	return lhs;
+}
+
+// Moving node by delta moves what it refers to as well
+static void expr_relocate(AstNode *node, Offset delta)
+{
+	switch(node->type) {
 	case AST_FN_CALL:
-		prs->ast.nodes[prs->ast.len - 1].fn_call.args += prs->ast.len - 1 - ref;
+		node->fn_call.args += delta;
 		break;
 	case AST_ARRAY_LIT:
-		prs->ast.nodes[prs->ast.len - 1].array_lit.elems += prs->ast.len - 1 - ref;
+		node->array_lit.elems += delta;
 		break;
 	case AST_SUBSCRIPT:
-		prs->ast.nodes[prs->ast.len - 1].subscript.arr += prs->ast.len - 1 - ref;
-		prs->ast.nodes[prs->ast.len - 1].subscript.index += prs->ast.len - 1 - ref;
+		node->subscript.arr += delta;
+		node->subscript.index += delta;
 		break;
 	case AST_STRUCT_LIT:
-		prs->ast.nodes[prs->ast.len - 1].struct_lit.member_names += prs->ast.len - 1 - ref;
-		prs->ast.nodes[prs->ast.len - 1].struct_lit.member_values += prs->ast.len - 1 - ref;
+		node->struct_lit.member_names += delta;
+		node->struct_lit.member_values += delta;
+		break;
+	case AST_STRUCT_ACCESS:
+	case AST_ARROW:
+		node->struct_access.parent += delta;
+		break;
+	case AST_DEREF:
+	case AST_ADDR:
+	case AST_LOGIC_NOT:
+		node->unary_op.val += delta;
+		break;
+	case AST_MUL:
+	case AST_DIV:
+	case AST_ADD:
+	case AST_SUB:
+	case AST_COMP_EQ:
+	case AST_COMP_GE:
+	case AST_COMP_LE:
+	case AST_COMP_NE:
+	case AST_COMP_GT:
+	case AST_COMP_LT:
+	case AST_LOGIC_AND:
+	case AST_LOGIC_OR:
+		node->binop.lhs += delta;
+		node->binop.rhs += delta;
 		break;
 	default: break;
 	}
-	prs->ast.nodes[ref] = prs->ast.nodes[prs->ast.len - 1];
+}
+
+static void handle_EXPR(Parser *prs, size_t *index, Error *err)
+{
+	size_t ref = parsestack_top(&prs->parse_stack)->ref;
+
+	size_t root = parse_expr(prs, index, 1, 0, err);
+	if(*err) goto RET;
+
+	switch(TOK_TYPE(*index)) {
+	case TOKEN_ASSIGN:
+	case TOKEN_SEMICOLON:
+	case TOKEN_ADD_ASSIGN:
+	case TOKEN_SUB_ASSIGN:
+	case TOKEN_MUL_ASSIGN:
+	case TOKEN_DIV_ASSIGN:
+	case TOKEN_RPAREN: // Closes something the expression is in, like an if
+		break;
+	default:
+		wyrt_diag(
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Malformed Expression: extra %T\n",
+			&prs->tokens, TOK(*index)
+		);
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
+
+	assert(root == prs->ast.len - 1);
+	expr_relocate(&prs->ast.nodes[root], root - ref);
+	prs->ast.nodes[ref] = prs->ast.nodes[root];
 	prs->ast.len -= 1;
 
 	parsestack_pop(&prs->parse_stack);
 
 RET:
-	dynarr_clean(&free_list);
-	dynarr_clean(&op_stack);
 	return;
 }
 
 static void handle_VAR_DECL_INIT(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type == TOKEN_ASSIGN) {
+	if(TOK_TYPE(*index) == TOKEN_ASSIGN) {
 		*index += 1;
 
 		size_t ref = parsestack_pop(&prs->parse_stack).ref;
@@ -2133,7 +2353,7 @@ static void handle_ASSIGNMENT(Parser *prs, size_t *index, Error *err)
 {
 	size_t ref = parsestack_top(&prs->parse_stack)->ref;
 
-	switch(prs->tokens[*index].type) {
+	switch(TOK_TYPE(*index)) {
 	case TOKEN_ASSIGN:
 	case TOKEN_ADD_ASSIGN:
 	case TOKEN_SUB_ASSIGN:
@@ -2150,8 +2370,8 @@ static void handle_ASSIGNMENT(Parser *prs, size_t *index, Error *err)
 			(AstNode) {
 				.assign = {
 					.com = {
-						.type = AST_ASSIGN + prs->tokens[*index].type - TOKEN_ASSIGN,
-						.debug = prs->tokens[*index].debug.debug_info
+						.type = AST_ASSIGN + TOK_TYPE(*index) - TOKEN_ASSIGN,
+						.debug = TOK_DEBUG(*index)
 					},
 					.var = var - prs->ast.len,
 					.expr = 1,
@@ -2181,9 +2401,9 @@ static void handle_ASSIGNMENT(Parser *prs, size_t *index, Error *err)
 		}
 
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected assignment, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -2197,24 +2417,24 @@ static void handle_STRUCT_TYPE(Parser *prs, size_t *index, Error *err)
 {
 	size_t ref = parsestack_top(&prs->parse_stack)->ref;
 
-	if(prs->tokens[*index].type == TOKEN_RCURLY) {
+	if(TOK_TYPE(*index) == TOKEN_RCURLY) {
 		parsestack_pop(&prs->parse_stack);
 		*index += 1;
 		goto RET;
 	}
 
 	if(prs->ast.nodes[ref].struct_type.member_count) {
-		if(prs->tokens[*index].type != TOKEN_COMMA) {
+		if(TOK_TYPE(*index) != TOKEN_COMMA) {
 			wyrt_diag(
-				stderr, prs->identifiers, prs->strings, NULL,
+				prs->diag, prs->identifiers, prs->strings, NULL,
 				"Expected ',' after struct member, found %T\n",
-				&prs->tokens[*index]
+				&prs->tokens, TOK(*index)
 			);
 			*err = ERROR_UNEXPECTED_DATA;
 			goto RET;
 		}
 
-		if(prs->tokens[*index + 1].type == TOKEN_RCURLY) {
+		if(TOK_TYPE(*index + 1) == TOKEN_RCURLY) {
 			parsestack_pop(&prs->parse_stack);
 			*index += 2;
 			goto RET;
@@ -2223,26 +2443,26 @@ static void handle_STRUCT_TYPE(Parser *prs, size_t *index, Error *err)
 
 	*index += 1;
 
-	if(prs->tokens[*index].type != TOKEN_IDENT) {
+	if(TOK_TYPE(*index) != TOKEN_IDENT) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected Identifier for struct member, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
 	}
 
-	size_t id = prs->tokens[*index].ident.id;
-	DebugInfo name_debug = prs->tokens[*index].debug.debug_info;
+	size_t id = TOK_VAL(*index);
+	DebugInfo name_debug = TOK_DEBUG(*index);
 
 	*index += 1;
 
-	if(prs->tokens[*index].type != TOKEN_COLON) {
+	if(TOK_TYPE(*index) != TOKEN_COLON) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected ':' after struct member, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -2293,16 +2513,16 @@ RET:
 
 static void handle_EXTERN(Parser *prs, size_t *index, Error *err)
 {
-	const DebugInfo debug = prs->tokens[*index].debug.debug_info;
+	const DebugInfo debug = TOK_DEBUG(*index);
 	size_t ref = parsestack_pop(&prs->parse_stack).ref;
 
 	*index += 1;
 
-	if(prs->tokens[*index].type != TOKEN_LPAREN) {
+	if(TOK_TYPE(*index) != TOKEN_LPAREN) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected '(' after #extern, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -2310,11 +2530,11 @@ static void handle_EXTERN(Parser *prs, size_t *index, Error *err)
 
 	*index += 1;
 
-	if(prs->tokens[*index].type != TOKEN_STRING_LIT) {
+	if(TOK_TYPE(*index) != TOKEN_STRING_LIT) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected string literal in #extern, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -2324,8 +2544,8 @@ static void handle_EXTERN(Parser *prs, size_t *index, Error *err)
 		&prs->ast,
 		(AstNode) {
 			.string_lit = {
-				.com = {AST_STRING_LIT, prs->tokens[*index].debug.debug_info},
-				.id = prs->tokens[*index].string_lit.id,
+				.com = {AST_STRING_LIT, TOK_DEBUG(*index)},
+				.id = TOK_VAL(*index),
 			},
 		},
 		err
@@ -2334,11 +2554,11 @@ static void handle_EXTERN(Parser *prs, size_t *index, Error *err)
 
 	*index += 1;
 
-	if(prs->tokens[*index].type != TOKEN_RPAREN) {
+	if(TOK_TYPE(*index) != TOKEN_RPAREN) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected ')' to end #extern, found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -2359,7 +2579,7 @@ RET:
 
 static void handle_FN_BODY(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type == TOKEN_HASH_EXTERN) {
+	if(TOK_TYPE(*index) == TOKEN_HASH_EXTERN) {
 		parsestack_top(&prs->parse_stack)->type = PARSE_STATE_EXTERN;
 	} else {
 		parsestack_top(&prs->parse_stack)->type = PARSE_STATE_BLOCK;
@@ -2368,11 +2588,11 @@ static void handle_FN_BODY(Parser *prs, size_t *index, Error *err)
 
 static void handle_SEMICOLON(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type != TOKEN_SEMICOLON) {
+	if(TOK_TYPE(*index) != TOKEN_SEMICOLON) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected ';', found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -2386,11 +2606,11 @@ RET:
 
 static void handle_RPAREN(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type != TOKEN_RPAREN) {
+	if(TOK_TYPE(*index) != TOKEN_RPAREN) {
 		wyrt_diag(
-			stderr, prs->identifiers, prs->strings, NULL,
+			prs->diag, prs->identifiers, prs->strings, NULL,
 			"Expected ')', found %T\n",
-			&prs->tokens[*index]
+			&prs->tokens, TOK(*index)
 		);
 		*err = ERROR_UNEXPECTED_DATA;
 		goto RET;
@@ -2403,7 +2623,7 @@ RET:
 
 static void handle_ELSE(Parser *prs, size_t *index, Error *err)
 {
-	if(prs->tokens[*index].type == TOKEN_ELSE) {
+	if(TOK_TYPE(*index) == TOKEN_ELSE) {
 		size_t ref = parsestack_pop(&prs->parse_stack).ref;
 
 		*index += 1;
@@ -2412,10 +2632,10 @@ static void handle_ELSE(Parser *prs, size_t *index, Error *err)
 		nodelist_alloc(&prs->ast, 1, err);
 		if(*err) goto RET;
 
-		if(prs->tokens[*index].type == TOKEN_IF) {
+		if(TOK_TYPE(*index) == TOKEN_IF) {
 			prs->ast.nodes[prs->ast.len - 1] = (AstNode) {
 				.block = {
-					.com = {AST_BLOCK, prs->tokens[*index].debug.debug_info},
+					.com = {AST_BLOCK, TOK_DEBUG(*index)},
 					.statements = 1,
 				},
 			};
@@ -2425,11 +2645,11 @@ static void handle_ELSE(Parser *prs, size_t *index, Error *err)
 			nodelist_alloc(&prs->ast, 1, err);
 			if(*err) goto RET;
 		} else {
-			if(prs->tokens[*index].type != TOKEN_LCURLY) {
+			if(TOK_TYPE(*index) != TOKEN_LCURLY) {
 				wyrt_diag(
-					stderr, prs->identifiers, prs->strings, NULL,
+					prs->diag, prs->identifiers, prs->strings, NULL,
 					"Expected '{' after 'else', found %T\n",
-					&prs->tokens[*index]
+					&prs->tokens, TOK(*index)
 				);
 				*err = ERROR_UNEXPECTED_DATA;
 				goto RET;
@@ -2442,6 +2662,8 @@ static void handle_ELSE(Parser *prs, size_t *index, Error *err)
 			);
 			if(*err) goto RET;
 		}
+	} else {
+		parsestack_pop(&prs->parse_stack);
 	}
 RET:
 	return;
@@ -2450,7 +2672,7 @@ RET:
 static void handle_CONDITION(Parser *prs, size_t *index, Error *err)
 {
 	size_t ref = parsestack_top(&prs->parse_stack)->ref;
-	if(prs->tokens[*index].type != TOKEN_RPAREN) {
+	if(TOK_TYPE(*index) != TOKEN_RPAREN) {
 		prs->ast.nodes[ref].if_statement.condition = prs->ast.len - ref;
 		nodelist_alloc(&prs->ast, 1, err);
 		if(*err) goto RET;
@@ -2463,30 +2685,365 @@ RET:
 	return;
 }
 
-void parser_parse(Parser *prs, Error *err)
+/*
+ * Error Recovery
+ * After a syntax error the parser skips ahead to a token it can carry on
+ * from, and the statement or definition that went wrong becomes an AST_ERROR.
+ * In a block that's the next ';' or '}' outside of any braces skipped on the
+ * way, and at the top level, or on reaching a fn or typedef, the next fn or
+ * typedef. Tokens are only skipped forwards and every recovery ends past the
+ * last one, so on garbage the extra work is linear in the tokens plus at most
+ * PARSE_ERRORS_MAX unwinds of the parse stack.
+ */
+
+#define PARSE_ERRORS_MAX 64
+
+// Clears *err if parsing can go on, leaving the parse stack ready for it
+static void parse_recover(Parser *prs, size_t *index, Error *err)
+{
+	ParseStack *ps = &prs->parse_stack;
+	if(*err != ERROR_UNEXPECTED_DATA || prs->bail || !ps->len) goto RET;
+	*err = ERROR_OK;
+
+	prs->errors += 1;
+	if(prs->errors >= PARSE_ERRORS_MAX) {
+		wyrt_diag(
+			prs->diag, prs->identifiers, prs->strings, NULL,
+			"Too many syntax errors, giving up.\n"
+		);
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
+
+	const DebugInfo debug = TOK_DEBUG(*index);
+	if(*index == prs->recovered_at && TOK_TYPE(*index) != TOKEN_EOF) *index += 1;
+
+	// The innermost block, or the module at the bottom of the stack
+	size_t target = ps->len - 1;
+	while(target && ps->state[target].type != PARSE_STATE_BLOCK_LIST) target--;
+
+	size_t depth = 0;
+	for(;; *index += 1) {
+		TokenType type = TOK_TYPE(*index);
+		if(
+			*index >= prs->end
+			|| type == TOKEN_EOF
+			|| type == TOKEN_FN
+			|| type == TOKEN_TYPEDEF
+		) {
+			target = 0;
+			break;
+		}
+		if(!target) continue;
+
+		if(type == TOKEN_LCURLY) {
+			depth++;
+		} else if(type == TOKEN_RCURLY) {
+			if(!depth) break;
+			depth--;
+		} else if(type == TOKEN_SEMICOLON && !depth) {
+			break;
+		}
+	}
+	prs->recovered_at = *index;
+	ps->len = target + 1;
+
+	const AstNode error = {.com = {AST_ERROR, debug}};
+	if(target) {
+		// The block's last statement is the one that went wrong
+		size_t last = block_last(prs, &ps->state[target]);
+		if(last) prs->ast.nodes[last] = error;
+
+		if(TOK_TYPE(*index) == TOKEN_RCURLY) {
+			parsestack_pop(ps);
+			*index += 1;
+		} else if(!last) {
+			*index += 1; // No statement for BLOCK_LIST to end with this ';'
+		}
+	} else if(prs->module_tail) {
+		// handle_MODULE links the definition before it has made a node
+		if(prs->module_tail == prs->ast.len) {
+			nodelist_alloc(&prs->ast, 1, err);
+			if(*err) goto RET;
+		}
+		prs->ast.nodes[prs->module_tail] = error;
+	}
+
+RET:
+	return;
+}
+
+#define PARSE_STACK_RESERVE 64 // Deeper than any state nesting in real code
+
+/*
+ * With GCC and Clang, every handler jumps straight to the next state's
+ * handler through a table of label addresses, instead of going back around
+ * a switch. That gives each state its own indirect branch, which predicts
+ * a lot better since states mostly follow each other in fixed patterns
+ * (BLOCK then BLOCK_LIST, FN_TYPE then FN_TYPE_LIST, ...).
+ */
+#if defined(__GNUC__) && !defined(PARSE_NO_THREADING)
+#define PARSE_THREADED
+#endif
+
+// Parses top-level statements from token *index into prs->ast
+static void parse_module(Parser *prs, size_t *index, Error *err)
 {
+	ParseStack *ps = &prs->parse_stack;
 	nodelist_push(
 		&prs->ast,
-		(AstNode) {.com = {AST_MODULE, prs->tokens[0].debug.debug_info}},
+		(AstNode) {.com = {AST_MODULE, TOK_DEBUG(*index)}},
 		err
 	);
 	if(*err) goto RET;
-	parsestack_push(&prs->parse_stack, (ParseState) {PARSE_STATE_MODULE, 0}, err);
+	parsestack_reserve(ps, PARSE_STACK_RESERVE, err);
+	if(*err) goto RET;
+	parsestack_push(ps, (ParseState) {PARSE_STATE_MODULE, 0}, err);
 	if(*err) goto RET;
 
-	size_t i = 0;
-	while(prs->parse_stack.len) {
-		ParseState *top = parsestack_top(&prs->parse_stack);
+#ifdef PARSE_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+	static void *const handlers[] = {
+#define X(n) [PARSE_STATE_ ##n] = &&STATE_ ##n,
+		PARSE_STATE_LIST
+#undef X
+	};
+
+#define DISPATCH() \
+	do { \
+		if(*err) goto RECOVER; \
+		if(!ps->len) goto DONE; \
+		goto *handlers[ps->state[ps->len - 1].type]; \
+	} while(0)
+
+	DISPATCH();
+#define X(n) STATE_ ##n: \
+	handle_ ##n (prs, index, err); \
+	DISPATCH();
+
+	PARSE_STATE_LIST
+#undef X
+
+RECOVER:
+	parse_recover(prs, index, err);
+	if(*err) goto RET;
+	DISPATCH();
+#undef DISPATCH
+#pragma GCC diagnostic pop
+
+DONE:
+#else
+	while(ps->len) {
 #define X(n) case PARSE_STATE_ ##n: \
-		handle_ ##n (prs, &i, err); \
-		if(*err) goto RET; \
+		handle_ ##n (prs, index, err); \
 		break;
 
-		switch(top->type) {
+		switch(ps->state[ps->len - 1].type) {
 			PARSE_STATE_LIST
 		}
 #undef X
+		if(*err) {
+			parse_recover(prs, index, err);
+			if(*err) goto RET;
+		}
+	}
+#endif
+
+	// Every error has been reported, but the AST isn't worth generating code from
+	if(prs->errors) *err = ERROR_UNEXPECTED_DATA;
+
+RET:
+	return;
+}
+
+/*
+ * Parallel Parsing
+ * Top-level fn and typedef definitions don't refer to each other's nodes,
+ * so runs of them can be parsed on their own and their nodes spliced
+ * together afterwards, linking the runs' statement chains end to end.
+ * Every offset inside a definition is relative, so that's all the fixing
+ * up needed, and the result is the AST the serial parse builds, except that
+ * each chunk hash-conses its types on its own (see TYPE_CONS).
+ */
+
+#define PARSE_CHUNK_MIN (64 * 1024) // In tokens, fewer aren't worth a thread
+#define PARSE_JOBS_MAX 64
+
+typedef struct {
+	Parser prs;
+	size_t start;
+	Error err;
+} ParseChunk;
+
+// Fills bounds[0..count] with token indices and returns count (<= jobs).
+// Every bound but the last is a fn or typedef outside of any braces. That's
+// only the start of a definition if the code is valid; if it isn't, a chunk
+// fails and parser_parse starts over.
+static size_t parser_split(Tokens const *toks, size_t *bounds, size_t jobs)
+{
+	size_t count = 0;
+	size_t depth = 0;
+	bounds[0] = 0;
+
+	for(size_t i = 0; i < toks->count && count + 1 < jobs; i++) {
+		switch(toks->types[i]) {
+		case TOKEN_LCURLY:
+			depth++;
+			break;
+		case TOKEN_RCURLY:
+			if(depth) depth--;
+			break;
+		case TOKEN_FN:
+		case TOKEN_TYPEDEF:
+			if(!depth && i >= toks->count / jobs * (count + 1)) bounds[++count] = i;
+			break;
+		}
+	}
+
+	bounds[++count] = toks->count - 1; // EOF
+	return count;
+}
+
+static void *parse_chunk(void *arg)
+{
+	ParseChunk *chunk = arg;
+	size_t index = chunk->start;
+	parse_module(&chunk->prs, &index, &chunk->err);
+	return NULL;
+}
+
+static void parse_chunks(ParseChunk *chunks, size_t count)
+{
+#ifdef _WIN32
+	for(size_t i = 0; i < count; i++) parse_chunk(&chunks[i]);
+#else
+	pthread_t threads[PARSE_JOBS_MAX];
+	bool started[PARSE_JOBS_MAX];
+	for(size_t i = 1; i < count; i++) {
+		started[i] = !pthread_create(&threads[i], NULL, parse_chunk, &chunks[i]);
+	}
+
+	parse_chunk(&chunks[0]);
+
+	for(size_t i = 1; i < count; i++) {
+		// Couldn't get a thread, so it's done here instead
+		if(started[i]) pthread_join(threads[i], NULL);
+		else parse_chunk(&chunks[i]);
+	}
+#endif
+}
+
+// Appends a chunk's statements (everything after its AST_MODULE) to prs->ast,
+// and interns its types as if they'd been parsed here
+static void parse_splice(Parser *prs, Parser const *chunk, Error *err)
+{
+	if(!chunk->module_tail) goto RET;
+
+	size_t base = prs->ast.len;
+	size_t count = chunk->ast.len - 1;
+	nodelist_alloc(&prs->ast, count, err);
+	if(*err) goto RET;
+	memcpy(&prs->ast.nodes[base], &chunk->ast.nodes[1], count * sizeof(AstNode));
+
+	if(prs->module_tail) prs->ast.nodes[prs->module_tail].com.next = base - prs->module_tail;
+	else prs->ast.nodes[0].module.statements = base;
+	prs->module_tail = base + chunk->module_tail - 1;
+
+	TypeRef const *refs = chunk->type_refs.data;
+	for(size_t i = 0; i < chunk->type_refs.count; i++) {
+		size_t type = type_intern(prs, &chunk->types, refs[i].type, err);
+		if(*err) goto RET;
+		type_ref(prs, base + refs[i].node - 1, type, err);
+		if(*err) goto RET;
+	}
+
+RET:
+	return;
+}
+
+// Returns false, with prs->ast untouched, if the module should be parsed
+// serially instead: it didn't split, or a chunk failed to parse.
+static bool parse_parallel(Parser *prs, size_t jobs, Error *err)
+{
+	bool ok = false;
+	size_t bounds[PARSE_JOBS_MAX + 1];
+	ParseChunk chunks[PARSE_JOBS_MAX];
+
+	size_t count = parser_split(&prs->tokens, bounds, jobs);
+	if(count < 2) return false;
+
+	for(size_t i = 0; i < count; i++) {
+		ParseChunk *chunk = &chunks[i];
+		chunk->prs = *prs;
+		chunk->prs.ast = (NodeList) {0};
+		chunk->prs.parse_stack = (ParseStack) {0};
+		chunk->prs.types = (NodeList) {0};
+		chunk->prs.type_slots = NULL;
+		chunk->prs.type_cap = 0;
+		chunk->prs.type_count = 0;
+		dynarr_init(&chunk->prs.type_refs, sizeof(TypeRef));
+		dynarr_init(&chunk->prs.type_stack, sizeof(size_t));
+		chunk->prs.diag = NULL;
+		chunk->prs.module_tail = 0;
+		chunk->prs.end = bounds[i + 1];
+		chunk->prs.bail = true; // The serial parse reports any errors
+		chunk->start = bounds[i];
+		chunk->err = ERROR_OK;
+	}
+
+	parse_chunks(chunks, count);
+
+	for(size_t i = 0; i < count; i++) {
+		if(chunks[i].err) goto RET;
+	}
+
+	nodelist_push(
+		&prs->ast,
+		(AstNode) {.com = {AST_MODULE, TOK_DEBUG(0)}},
+		err
+	);
+	if(*err) goto RET;
+	for(size_t i = 0; i < count; i++) {
+		parse_splice(prs, &chunks[i].prs, err);
+		if(*err) goto RET;
+	}
+	ok = true;
+
+RET:
+	for(size_t i = 0; i < count; i++) {
+		free(chunks[i].prs.ast.nodes);
+		free(chunks[i].prs.parse_stack.state);
+		type_table_clean(&chunks[i].prs);
 	}
+	return ok;
+}
+
+void parser_parse(Parser *prs, Error *err)
+{
+	size_t jobs = prs->jobs;
+	if(jobs > PARSE_JOBS_MAX) jobs = PARSE_JOBS_MAX;
+	if(prs->tokens.stream) jobs = 1; // Chunks need every token up front
+	else if(jobs > prs->tokens.count / PARSE_CHUNK_MIN) jobs = prs->tokens.count / PARSE_CHUNK_MIN;
+
+	bool done = false;
+	if(jobs > 1) {
+		done = parse_parallel(prs, jobs, err);
+		if(*err) goto RET;
+	}
+
+	if(!done) {
+		size_t i = 0;
+		parse_module(prs, &i, err);
+		if(*err) goto RET;
+	}
+
+	type_finish(prs, err);
+	if(*err) goto RET;
+	ast_pack(&prs->tree, &prs->ast, err);
+	if(*err) goto RET;
+	free(prs->ast.nodes);
+	prs->ast = (NodeList) {0};
 
 RET:
 	return;
@@ -2,9 +2,14 @@
 
 #include "lexer.h"
 
+#include <string.h>
+
 // Relative Offset
 // 'next' field for chains: 0 == end
-typedef int16_t Offset;
+// 32 bits, so it can span any module (NodeList never grows past OFFSET_MAX).
+// This doesn't grow AstNode, see bench/parse.c.
+typedef int32_t Offset;
+#define OFFSET_MAX INT32_MAX
 
 typedef enum {
 	AST_NONE,
@@ -73,7 +78,9 @@ typedef enum {
 	AST_TYPEDEF,
 	AST_ARROW,
 	
-	AST_IF
+	AST_IF,
+
+	AST_ERROR // Where a syntax error was recovered from, see parse_recover
 } AstNodeType;
 
 typedef struct {
@@ -204,7 +211,7 @@ typedef union {
 		AstNodeCommon com;
 		Id member_id;
 		Offset parent;
-	} struct_access;
+	} struct_access; // Also AST_ARROW
 
 	struct {
 		AstNodeCommon com;
@@ -221,12 +228,6 @@ typedef union {
 		Offset value;
 	} discard;
 
-	struct {
-		AstNodeCommon com;
-		Offset parent;
-		Offset member;
-	} arrow;
-
 	struct {
 		AstNodeCommon com;
 		Id id;
@@ -257,6 +258,41 @@ void nodelist_alloc(NodeList *list, size_t n, Error *err);
 void nodelist_push(NodeList *list, AstNode node, Error *err);
 AstNode nodelist_pop(NodeList *list);
 
+/*
+ * Finished AST, stored as parallel arrays indexed by node.
+ * The parser builds a NodeList and packs it into this once it's done, so
+ * walking a chain (types/next) doesn't pull every node's payload into cache.
+ * data holds what follows com in each AstNode, use ast_get for the whole node.
+ */
+typedef struct {
+	unsigned char bytes[sizeof(AstNode) - sizeof(AstNodeCommon)];
+} AstPayload;
+
+typedef struct {
+	uint8_t *types; // AstNodeType
+	uint32_t *locs; // DebugInfo.offset
+	Offset *next;
+	AstPayload *data;
+	size_t len;
+	uint32_t file; // DebugInfo.file, the same for every node
+} Ast;
+
+void ast_pack(Ast *ast, NodeList const *list, Error *err);
+void ast_clean(Ast const *ast);
+
+// Evaluates to an lvalue, so &AST_DEBUG(...) is fine
+#define AST_DEBUG(ast, i) ((DebugInfo) {(ast)->locs[i], (ast)->file})
+
+static inline AstNode ast_get(Ast const *ast, size_t i)
+{
+	AstNode node;
+	memcpy((char*)&node + sizeof(AstNodeCommon), &ast->data[i], sizeof(AstPayload));
+	node.com.type = ast->types[i];
+	node.com.debug = AST_DEBUG(ast, i);
+	node.com.next = ast->next[i];
+	return node;
+}
+
 #define PARSE_STATE_LIST \
 	X(MODULE) \
 	X(FN_DEF) \
@@ -266,6 +302,7 @@ AstNode nodelist_pop(NodeList *list);
 	X(FN_TYPE_ARG) \
 	X(FN_TYPE_RET) \
 	X(TYPE) \
+	X(TYPE_CONS) \
 	X(FN_BODY) \
 	X(BLOCK) \
 	X(BLOCK_LIST) \
@@ -290,6 +327,7 @@ PARSE_STATE_LIST
 typedef struct {
 	ParseStateType type;
 	size_t ref; // index into ast
+	size_t prev; // BLOCK_LIST only: the statement before the last one, or the block
 } ParseState;
 
 typedef struct {
@@ -299,26 +337,61 @@ typedef struct {
 } ParseStack;
 
 void parsestack_alloc(ParseStack *ps, size_t n, Error *err);
+void parsestack_reserve(ParseStack *ps, size_t n, Error *err);
 void parsestack_push(ParseStack *ps, ParseState state, Error *err);
 ParseState parsestack_pop(ParseStack *ps);
 ParseState *parsestack_top(ParseStack *ps);
 ParseState *parsestack_from_top(ParseStack *ps, size_t i);
 
+// Open-addressed, see type_canonical
+typedef struct {
+	uint32_t hash;
+	uint32_t type; // Index into Parser.types + 1, 0 == Empty
+} TypeSlot;
+
+// The node at node holds the type at type, once types is appended (see type_finish)
+typedef struct {
+	uint32_t node;
+	uint32_t type;
+} TypeRef;
+
 typedef struct {
-	Token const *tokens;
-	NodeList ast;
+	Tokens tokens;
+	NodeList ast; // Only while parsing
+	Ast tree; // Set by parser_parse
 	ParseStack parse_stack;
 	char *const *identifiers;
 	char *const *strings;
+	unsigned jobs; // Threads parser_parse may use, see parser_split
+	FILE *diag; // Where errors are printed, NULL to drop them
+
+	size_t module_tail; // Last top-level statement so far, 0 == None
+	size_t end; // Token to stop at instead of EOF, only set on chunk copies
+	bool bail; // Stop at the first syntax error instead of recovering
+	size_t errors; // Syntax errors reported so far
+	size_t recovered_at; // Token the last recovery resumed at
+
+	// Every distinct type parsed so far, only while parsing
+	NodeList types;
+	TypeSlot *type_slots;
+	size_t type_cap;
+	size_t type_count; // Used slots
+	DynArr type_refs; // TypeRef
+	DynArr type_stack; // size_t, type_intern's, so deep types don't need a deep C stack
 } Parser;
 
 void parser_init(
 	Parser *prs,
-	Token const *tokens,
+	Tokens const *tokens,
 	char *const *identifiers,
 	char *const *strings
 );
 void parser_clean(Parser *prs);
 
-void parser_print_ast(Parser *prs, FILE *file);
+void parser_print_ast(
+	Ast const *ast,
+	char *const *identifiers,
+	char *const *strings,
+	FILE *file
+);
 void parser_parse(Parser *prs, Error *err);
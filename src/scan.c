@@ -0,0 +1,229 @@
+#include "scan.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+enum {
+	CLASS_SPACE = 1,
+	CLASS_IDENT = 2,
+	CLASS_DIGIT = 4,
+};
+
+// Same classes as isspace/isalnum in the C locale, plus '_' and '@'
+static const uint8_t char_class[256] = {
+	[' '] = CLASS_SPACE, ['\t'] = CLASS_SPACE, ['\n'] = CLASS_SPACE,
+	['\v'] = CLASS_SPACE, ['\f'] = CLASS_SPACE, ['\r'] = CLASS_SPACE,
+
+	['0'] = CLASS_IDENT | CLASS_DIGIT, ['1'] = CLASS_IDENT | CLASS_DIGIT,
+	['2'] = CLASS_IDENT | CLASS_DIGIT, ['3'] = CLASS_IDENT | CLASS_DIGIT,
+	['4'] = CLASS_IDENT | CLASS_DIGIT, ['5'] = CLASS_IDENT | CLASS_DIGIT,
+	['6'] = CLASS_IDENT | CLASS_DIGIT, ['7'] = CLASS_IDENT | CLASS_DIGIT,
+	['8'] = CLASS_IDENT | CLASS_DIGIT, ['9'] = CLASS_IDENT | CLASS_DIGIT,
+
+	['A'] = CLASS_IDENT, ['B'] = CLASS_IDENT, ['C'] = CLASS_IDENT, ['D'] = CLASS_IDENT,
+	['E'] = CLASS_IDENT, ['F'] = CLASS_IDENT, ['G'] = CLASS_IDENT, ['H'] = CLASS_IDENT,
+	['I'] = CLASS_IDENT, ['J'] = CLASS_IDENT, ['K'] = CLASS_IDENT, ['L'] = CLASS_IDENT,
+	['M'] = CLASS_IDENT, ['N'] = CLASS_IDENT, ['O'] = CLASS_IDENT, ['P'] = CLASS_IDENT,
+	['Q'] = CLASS_IDENT, ['R'] = CLASS_IDENT, ['S'] = CLASS_IDENT, ['T'] = CLASS_IDENT,
+	['U'] = CLASS_IDENT, ['V'] = CLASS_IDENT, ['W'] = CLASS_IDENT, ['X'] = CLASS_IDENT,
+	['Y'] = CLASS_IDENT, ['Z'] = CLASS_IDENT,
+
+	['a'] = CLASS_IDENT, ['b'] = CLASS_IDENT, ['c'] = CLASS_IDENT, ['d'] = CLASS_IDENT,
+	['e'] = CLASS_IDENT, ['f'] = CLASS_IDENT, ['g'] = CLASS_IDENT, ['h'] = CLASS_IDENT,
+	['i'] = CLASS_IDENT, ['j'] = CLASS_IDENT, ['k'] = CLASS_IDENT, ['l'] = CLASS_IDENT,
+	['m'] = CLASS_IDENT, ['n'] = CLASS_IDENT, ['o'] = CLASS_IDENT, ['p'] = CLASS_IDENT,
+	['q'] = CLASS_IDENT, ['r'] = CLASS_IDENT, ['s'] = CLASS_IDENT, ['t'] = CLASS_IDENT,
+	['u'] = CLASS_IDENT, ['v'] = CLASS_IDENT, ['w'] = CLASS_IDENT, ['x'] = CLASS_IDENT,
+	['y'] = CLASS_IDENT, ['z'] = CLASS_IDENT,
+
+	['_'] = CLASS_IDENT, ['@'] = CLASS_IDENT,
+};
+
+/*
+ * Scalar
+ * Also used for the tail of the SIMD scanners, so these pick up at i.
+ */
+
+static size_t class_from(const char *str, size_t i, size_t len, uint8_t class)
+{
+	while(i < len && (char_class[(unsigned char)str[i]] & class)) i++;
+	return i;
+}
+
+static size_t whitespace_scalar(const char *str, size_t len)
+{
+	return class_from(str, 0, len, CLASS_SPACE);
+}
+
+static size_t ident_scalar(const char *str, size_t len)
+{
+	return class_from(str, 0, len, CLASS_IDENT);
+}
+
+static size_t digits_scalar(const char *str, size_t len)
+{
+	return class_from(str, 0, len, CLASS_DIGIT);
+}
+
+const Scanner scanner_scalar = {
+	"scalar",
+	whitespace_scalar,
+	ident_scalar,
+	digits_scalar,
+};
+
+#ifdef SCAN_X86
+
+/*
+ * SSE2
+ * Every ASCII class we care about is below 0x80, so signed compares against
+ * (lo - 1, hi + 1) are range checks that reject bytes >= 0x80 for free.
+ */
+
+#define SSE2_RANGE(v, lo, hi) _mm_and_si128( \
+		_mm_cmpgt_epi8(v, _mm_set1_epi8((lo) - 1)), \
+		_mm_cmplt_epi8(v, _mm_set1_epi8((hi) + 1)) \
+	)
+
+static size_t whitespace_sse2(const char *str, size_t len)
+{
+	size_t i = 0;
+	for(; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+		__m128i space = _mm_or_si128(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+			SSE2_RANGE(v, '\t', '\r')
+		);
+		uint32_t stop = ~(uint32_t)_mm_movemask_epi8(space) & 0xFFFF;
+		if(stop) return i + __builtin_ctz(stop);
+	}
+	return class_from(str, i, len, CLASS_SPACE);
+}
+
+static size_t ident_sse2(const char *str, size_t len)
+{
+	size_t i = 0;
+	for(; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+		__m128i ident = _mm_or_si128(
+			_mm_or_si128(SSE2_RANGE(v, '0', '9'), SSE2_RANGE(v, '@', 'Z')),
+			_mm_or_si128(SSE2_RANGE(v, 'a', 'z'), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')))
+		);
+		uint32_t stop = ~(uint32_t)_mm_movemask_epi8(ident) & 0xFFFF;
+		if(stop) return i + __builtin_ctz(stop);
+	}
+	return class_from(str, i, len, CLASS_IDENT);
+}
+
+static size_t digits_sse2(const char *str, size_t len)
+{
+	size_t i = 0;
+	for(; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+		uint32_t stop = ~(uint32_t)_mm_movemask_epi8(SSE2_RANGE(v, '0', '9')) & 0xFFFF;
+		if(stop) return i + __builtin_ctz(stop);
+	}
+	return class_from(str, i, len, CLASS_DIGIT);
+}
+
+static const Scanner scanner_sse2 = {
+	"sse2",
+	whitespace_sse2,
+	ident_sse2,
+	digits_sse2,
+};
+
+/*
+ * AVX2
+ * Same as SSE2, 32 bytes at a time. Only called if the CPU supports it.
+ */
+
+#define AVX2_RANGE(v, lo, hi) _mm256_and_si256( \
+		_mm256_cmpgt_epi8(v, _mm256_set1_epi8((lo) - 1)), \
+		_mm256_cmpgt_epi8(_mm256_set1_epi8((hi) + 1), v) \
+	)
+
+__attribute__((target("avx2")))
+static size_t whitespace_avx2(const char *str, size_t len)
+{
+	size_t i = 0;
+	for(; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+		__m256i space = _mm256_or_si256(
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+			AVX2_RANGE(v, '\t', '\r')
+		);
+		uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(space);
+		if(stop) return i + __builtin_ctz(stop);
+	}
+	return class_from(str, i, len, CLASS_SPACE);
+}
+
+__attribute__((target("avx2")))
+static size_t ident_avx2(const char *str, size_t len)
+{
+	size_t i = 0;
+	for(; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+		__m256i ident = _mm256_or_si256(
+			_mm256_or_si256(AVX2_RANGE(v, '0', '9'), AVX2_RANGE(v, '@', 'Z')),
+			_mm256_or_si256(AVX2_RANGE(v, 'a', 'z'), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')))
+		);
+		uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(ident);
+		if(stop) return i + __builtin_ctz(stop);
+	}
+	return class_from(str, i, len, CLASS_IDENT);
+}
+
+__attribute__((target("avx2")))
+static size_t digits_avx2(const char *str, size_t len)
+{
+	size_t i = 0;
+	for(; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+		uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(AVX2_RANGE(v, '0', '9'));
+		if(stop) return i + __builtin_ctz(stop);
+	}
+	return class_from(str, i, len, CLASS_DIGIT);
+}
+
+static const Scanner scanner_avx2 = {
+	"avx2",
+	whitespace_avx2,
+	ident_avx2,
+	digits_avx2,
+};
+
+#endif
+
+Scanner const *const *scan_available(void)
+{
+	static Scanner const *available[4];
+	static bool init = false;
+	if(init) return available;
+
+	size_t count = 0;
+	available[count++] = &scanner_scalar;
+#ifdef SCAN_X86
+	available[count++] = &scanner_sse2;
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) available[count++] = &scanner_avx2;
+#endif
+	available[count] = NULL;
+
+	init = true;
+	return available;
+}
+
+Scanner const *scan_best(void)
+{
+	Scanner const *const *available = scan_available();
+	size_t i = 0;
+	while(available[i + 1]) i++;
+	return available[i];
+}
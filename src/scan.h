@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Character-class scanning
+ * Each scanner returns the length of the run of whitespace/identifier/digit
+ * bytes at the start of str, looking at no more than len bytes.
+ * The SIMD versions classify 16 (SSE2) or 32 (AVX2) bytes per step, the best
+ * one the CPU supports is picked at runtime.
+ */
+
+typedef struct {
+	const char *name;
+	size_t (*whitespace)(const char *str, size_t len);
+	size_t (*ident)(const char *str, size_t len);
+	size_t (*digits)(const char *str, size_t len);
+} Scanner;
+
+extern const Scanner scanner_scalar;
+
+// NULL-terminated, scalar first and best last. Only lists what this CPU runs.
+Scanner const *const *scan_available(void);
+Scanner const *scan_best(void);
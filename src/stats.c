@@ -0,0 +1,178 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L // clock_gettime
+#endif
+
+#include "stats.h"
+
+#include <time.h>
+
+#ifdef _WIN32
+int QueryPerformanceCounter(long long *);
+int QueryPerformanceFrequency(long long *);
+#endif
+
+#define STATS_PASSES_MAX 32
+#define STATS_SPAN_DEPTH 16
+#define STATS_NAME_MAX 64
+
+typedef struct {
+	char const *name;
+	double start; // Wall
+	double cpu_start;
+	double wall;
+	double cpu;
+} Pass;
+
+typedef struct {
+	char name[STATS_NAME_MAX];
+	double start;
+} Span;
+
+Counters counters;
+
+static bool enabled;
+static double epoch; // When stats_init ran, trace timestamps count from here
+static double cpu_epoch;
+
+static Pass passes[STATS_PASSES_MAX];
+static size_t pass_count;
+
+static FILE *trace;
+static bool traced; // Wrote an event already, so the next needs a comma
+static Span spans[STATS_SPAN_DEPTH];
+static size_t span_depth; // Can be deeper than spans, those aren't traced
+
+// Wall time in seconds, from some fixed point
+static double wall_now(void)
+{
+#ifdef _WIN32
+	long long count, freq;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&freq);
+	return (double) count / freq;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+// CPU time of every thread in the process. On Windows clock() is wall time.
+static double cpu_now(void)
+{
+	return (double) clock() / CLOCKS_PER_SEC;
+}
+
+void stats_init(char const *trace_path, Error *err)
+{
+	enabled = true;
+	epoch = wall_now();
+	cpu_epoch = cpu_now();
+	if(!trace_path) goto RET;
+
+	trace = fopen(trace_path, "w");
+	if(!trace) {
+		fprintf(stderr, "Unable to Open Trace File '%s'.\n", trace_path);
+		*err = ERROR_IO;
+		goto RET;
+	}
+	fputs("{\"traceEvents\": [\n", trace);
+
+RET:
+	return;
+}
+
+static void trace_event(char const *category, char const *name, double start, double end)
+{
+	fputs(traced ? ",\n{\"name\": \"" : "{\"name\": \"", trace);
+	for(; *name; name++) {
+		if(*name == '"' || *name == '\\') fputc('\\', trace);
+		if((unsigned char) *name >= ' ') fputc(*name, trace);
+	}
+	fprintf(
+		trace,
+		"\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, "
+		"\"ts\": %.3f, \"dur\": %.3f}",
+		category,
+		(start - epoch) * 1e6,
+		(end - start) * 1e6
+	);
+	traced = true;
+}
+
+void stats_finish(void)
+{
+	if(!trace) return;
+	fputs("\n]}\n", trace);
+	fclose(trace);
+	trace = NULL;
+}
+
+size_t pass_begin(char const *name)
+{
+	if(!enabled || pass_count == STATS_PASSES_MAX) return SIZE_MAX;
+
+	passes[pass_count] = (Pass) {
+		.name = name,
+		.start = wall_now(),
+		.cpu_start = cpu_now(),
+	};
+	return pass_count++;
+}
+
+void pass_end(size_t pass)
+{
+	if(pass == SIZE_MAX) return;
+
+	Pass *p = &passes[pass];
+	double end = wall_now();
+	p->wall = end - p->start;
+	p->cpu = cpu_now() - p->cpu_start;
+	if(trace) trace_event("pass", p->name, p->start, end);
+}
+
+void span_begin(char const *name)
+{
+	if(!trace) return;
+
+	if(span_depth < STATS_SPAN_DEPTH) {
+		Span *span = &spans[span_depth];
+		snprintf(span->name, sizeof span->name, "%s", name);
+		span->start = wall_now();
+	}
+	span_depth += 1;
+}
+
+void span_end(void)
+{
+	if(!trace || !span_depth) return;
+
+	span_depth -= 1;
+	if(span_depth < STATS_SPAN_DEPTH) {
+		trace_event("span", spans[span_depth].name, spans[span_depth].start, wall_now());
+	}
+}
+
+void stats_report(FILE *file)
+{
+	fprintf(file, "===== Passes =====\n");
+	fprintf(file, "%-20s %12s %12s\n", "", "Wall (ms)", "CPU (ms)");
+	for(size_t i = 0; i < pass_count; i++) {
+		fprintf(file, "%-20s %12.3f %12.3f\n", passes[i].name, passes[i].wall * 1e3, passes[i].cpu * 1e3);
+	}
+	fprintf(
+		file,
+		"%-20s %12.3f %12.3f\n",
+		"total",
+		(wall_now() - epoch) * 1e3,
+		(cpu_now() - cpu_epoch) * 1e3
+	);
+
+	fprintf(file, "===== Counters =====\n");
+	fprintf(file, "%-20s %12zu\n", "tokens", counters.tokens);
+	fprintf(file, "%-20s %12zu\n", "ast nodes", counters.nodes);
+	fprintf(file, "%-20s %12zu\n", "functions", counters.functions);
+	fprintf(file, "%-20s %12zu\n", "types registered", counters.types_registered);
+	fprintf(file, "%-20s %12zu\n", "scopes", counters.scopes);
+	fprintf(file, "%-20s %12zu\n", "backend calls", counters.backend_calls);
+}
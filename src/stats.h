@@ -0,0 +1,39 @@
+#pragma once
+#include "util.h"
+
+/*
+ * --time-passes and --time-trace
+ * A pass is a phase of the compile (lexing, parsing, codegen, the backend),
+ * timed in wall and CPU time and printed by stats_report in the order they
+ * ran. With a trace file every pass, and every span inside one (like each
+ * function's codegen), is also written as a Chrome trace event, which
+ * chrome://tracing and ui.perfetto.dev can open.
+ * Nothing is timed unless stats_init was called, so the calls can stay in.
+ */
+
+// Bumped unconditionally, it's cheaper than checking whether anyone's looking
+typedef struct {
+	size_t tokens;
+	size_t nodes;
+	size_t functions;
+	size_t types_registered; // Types added to a TypeContext, over all of them
+	size_t scopes; // Made from a parent, by scope_init
+	size_t backend_calls;
+} Counters;
+
+extern Counters counters;
+
+// trace_path is where to write trace events, NULL for none
+void stats_init(char const *trace_path, Error *err);
+// Writes out the rest of the trace, if there is one
+void stats_finish(void);
+
+// Returns a handle for pass_end, name has to outlive the report
+size_t pass_begin(char const *name);
+void pass_end(size_t pass);
+
+// Trace-only spans, name is copied. Spans nest, so end the innermost first.
+void span_begin(char const *name);
+void span_end(void);
+
+void stats_report(FILE *file);
@@ -1,13 +1,15 @@
 #include "types.h"
 #include "lexer.h"
 #include "util.h"
+#include "stats.h"
 
 #include <string.h>
+#include <stddef.h>
 #include <assert.h>
 
-void types_init(TypeContext *tc, Error *err)
+void types_init(TypeContext *tc, Arena *arena, Error *err)
 {
-	*tc = (TypeContext) { 0 };
+	*tc = (TypeContext) { .arena = arena };
 	types_register(tc, (Type) {.type = TYPE_PRIMITIVE_U8}, err);
 	if(*err) goto RET;
 	types_register(tc, (Type) {.type = TYPE_PRIMITIVE_U16}, err);
@@ -32,61 +34,142 @@ RET:
 	return;
 }
 
-static void type_clean(Type t)
+#define TYPE_HASH_MUL 0x9E3779B97F4A7C15u
+
+// Agrees with types_are_equal
+static uint32_t type_hash(Type t)
 {
-	if(t.type == TYPE_STRUCT) {
-		if(t.struct_type.member_types)
-			free(t.struct_type.member_types);
-		if(t.struct_type.member_name_ids)
-			free(t.struct_type.member_name_ids);
+	uint64_t hash = (t.type + 1) * TYPE_HASH_MUL;
+
+	switch(t.type) {
+	case TYPE_ARRAY:
+		hash = (hash ^ t.array.len) * TYPE_HASH_MUL;
+		// fallthrough
+	case TYPE_POINTER_CONST:
+	case TYPE_POINTER_ABYSS:
+	case TYPE_POINTER_VAR:
+	case TYPE_PAUL_CONST:
+	case TYPE_PAUL_ABYSS:
+	case TYPE_PAUL_VAR:
+	case TYPE_SLICE_CONST:
+	case TYPE_SLICE_ABYSS:
+	case TYPE_SLICE_VAR:
+		hash = (hash ^ t.pointer.base) * TYPE_HASH_MUL;
+		break;
+
+	case TYPE_STRUCT:
+		for(size_t i = 0; i < t.struct_type.member_count; i++) {
+			hash = (hash ^ t.struct_type.member_name_ids[i]) * TYPE_HASH_MUL;
+			hash = (hash ^ t.struct_type.member_types[i]) * TYPE_HASH_MUL;
+		}
+		break;
+
+	case TYPE_TYPEDEF:
+		hash = (hash ^ t.typdef.id) * TYPE_HASH_MUL;
+		break;
+
+	default:
+		break;
 	}
+	return hash ^ (hash >> 32);
 }
 
-void types_clean(TypeContext const *tc)
+// The slot t is in, or the empty one it would go in
+static TypeId *types_slot(TypeContext const *tc, Type t)
 {
-	for(size_t i = 0; i < tc->count; i++) {
-		type_clean(tc->types[i]);
+	size_t mask = tc->slot_cap - 1;
+	for(size_t j = type_hash(t) & mask;; j = (j + 1) & mask) {
+		TypeId *slot = &tc->slots[j];
+		if(!*slot || types_are_equal(tc->types[*slot - 1], t)) return slot;
 	}
-	if(tc->types) free(tc->types);
 }
 
-size_t types_register(TypeContext *tc, Type t, Error *err)
+static void types_grow(TypeContext *tc, Error *err)
 {
-	size_t base = tc->count;
-	tc->count += 8;
-	tc->types = realloc(tc->types, tc->count * sizeof(Type));
-	CHECK_MALLOC(tc->types);
-	tc->types[tc->count - 8] = t;
-	tc->types[tc->count - 7] = (Type) {.pointer = {.type = TYPE_POINTER_CONST, .base = base}};
-	tc->types[tc->count - 6] = (Type) {.pointer = {.type = TYPE_POINTER_ABYSS, .base = base}};
-	tc->types[tc->count - 5] = (Type) {.pointer = {.type = TYPE_POINTER_VAR, .base = base}};
-	tc->types[tc->count - 4] = (Type) {.pointer = {.type = TYPE_ARRAY, .base = base}};
-	tc->types[tc->count - 3] = (Type) {.pointer = {.type = TYPE_SLICE_CONST, .base = base}};
-	tc->types[tc->count - 2] = (Type) {.pointer = {.type = TYPE_SLICE_ABYSS, .base = base}};
-	tc->types[tc->count - 1] = (Type) {.pointer = {.type = TYPE_SLICE_VAR, .base = base}};
+	size_t cap = tc->cap ? tc->cap * 2 : 64;
+	tc->types = arena_realloc(tc->arena, tc->types, tc->cap * sizeof(Type), cap * sizeof(Type), err);
+	if(*err) goto RET;
+	tc->cap = cap;
+
+	tc->slots = arena_alloc(tc->arena, 2 * cap * sizeof(TypeId), err);
+	if(*err) goto RET;
+	memset(tc->slots, 0, 2 * cap * sizeof(TypeId));
+	tc->slot_cap = 2 * cap;
+	for(size_t i = 0; i < tc->count; i++) {
+		*types_slot(tc, tc->types[i]) = i + 1;
+	}
 
 RET:
-	return tc->count - 8;
+	return;
 }
 
-size_t types_register_nexist(TypeContext *tc, Type t, Error *err)
+TypeId types_find(TypeContext const *tc, Type t)
 {
-	size_t index = SIZE_MAX;
-	for(size_t i = 0; i < tc->count; i++) {
-		if(types_are_equal(tc->types[i], t)) {
-			index = i;
-			break;
-		}
+	if(!tc->slot_cap) return TYPE_ID_NONE;
+	return *types_slot(tc, t) - 1; // An empty slot is 0, so that's TYPE_ID_NONE
+}
+
+TypeId types_register(TypeContext *tc, Type t, Error *err)
+{
+	TypeId id = types_find(tc, t);
+	if(id != TYPE_ID_NONE) return id;
+
+	counters.types_registered += 1;
+	if(tc->count == tc->cap) {
+		types_grow(tc, err);
+		if(*err) goto RET;
 	}
-	if(index != SIZE_MAX) return index;
 
-	return types_register(tc, t, err);
+	// The member arrays might be on the caller's stack
+	if(t.type == TYPE_STRUCT) {
+		size_t count = t.struct_type.member_count;
+		TypeId *member_types = arena_alloc(tc->arena, count * sizeof(TypeId), err);
+		if(*err) goto RET;
+		Id *member_name_ids = arena_alloc(tc->arena, count * sizeof(Id), err);
+		if(*err) goto RET;
+		memcpy(member_types, t.struct_type.member_types, count * sizeof(TypeId));
+		memcpy(member_name_ids, t.struct_type.member_name_ids, count * sizeof(Id));
+		t.struct_type.member_types = member_types;
+		t.struct_type.member_name_ids = member_name_ids;
+	}
+
+	id = tc->count;
+	tc->types[tc->count++] = t;
+	*types_slot(tc, t) = id + 1;
+
+RET:
+	return id;
 }
 
-Type type_from_ast(TypeContext *tc, AstNode const *nodes, size_t i, Error *err)
+// Makes room on tc's stack for count more
+static void types_stack_reserve(TypeContext *tc, size_t count, Error *err)
+{
+	if(tc->stack_len + count <= tc->stack_cap) return;
+
+	size_t cap = tc->stack_cap ? tc->stack_cap * 2 : 64;
+	while(cap < tc->stack_len + count) cap *= 2;
+	tc->stack = arena_realloc(
+		tc->arena,
+		tc->stack,
+		tc->stack_len * sizeof(uint32_t),
+		cap * sizeof(uint32_t),
+		err
+	);
+	if(*err) return;
+	tc->stack_cap = cap;
+}
+
+// The type at i, if it's not a pointer, array or slice, registered
+static Type type_from_ast_leaf(TypeContext *tc, Ast const *ast, size_t i, Error *err)
 {
 	Type t = { 0 };
-	AstNode node = nodes[i];
+	TypeId index;
+	size_t mark = tc->stack_len;
+
+	// Types are hash-consed by the parser, so the same node comes up a lot
+	if(tc->cache && tc->cache[i]) return tc->types[tc->cache[i] - 1];
+
+	AstNode node = ast_get(ast, i);
 	switch(node.type) {
 	case AST_IDENT:
 		do {} while(0);
@@ -123,16 +206,8 @@ Type type_from_ast(TypeContext *tc, AstNode const *nodes, size_t i, Error *err)
 			t = (Type) { .type = TYPE_PRIMITIVE_BOOL };
 			break;
 		default: {
-			size_t index = SIZE_MAX;
-			for(size_t j = 0; j < tc->count; j++) {
-				if(tc->types[j].type == TYPE_TYPEDEF
-					&& tc->types[j].typdef.id == id
-				) {
-					index = j;
-					break;
-				}
-			}
-			if(index == SIZE_MAX) {
+			TypeId index = types_find(tc, (Type) {.typdef = {.type = TYPE_TYPEDEF, .id = id}});
+			if(index == TYPE_ID_NONE) {
 				fprintf(stderr, "Identifier is not a Type at ");
 				lexer_print_debug_to_file(stderr, &node.com.debug);
 				fprintf(stderr, "\n");
@@ -144,133 +219,176 @@ Type type_from_ast(TypeContext *tc, AstNode const *nodes, size_t i, Error *err)
 		}
 		break;
 
-	case AST_POINTER_CONST:
-	case AST_POINTER_VAR:
-	case AST_POINTER_ABYSS:
-		do {} while(0);
-		Type targ_type = type_from_ast(tc, nodes, i + node.pointer_type.base_type, err);
-		if(*err) goto RET;
-		size_t index = types_register_nexist(tc, targ_type, err);
+	case AST_STRUCT_TYPE: {
+		// The members are built on tc's stack, and only copied into its arena
+		// if the struct is new
+		size_t count = node.struct_type.member_count;
+		size_t members = tc->stack_len;
+		types_stack_reserve(tc, 2 * count, err);
 		if(*err) goto RET;
+		tc->stack_len += 2 * count;
 
-		TypeType ptr_type; 
-		switch(node.type) {
-		default:
-		case AST_POINTER_CONST:
-			ptr_type = TYPE_POINTER_CONST;
-			break;
-		case AST_POINTER_ABYSS:
-			ptr_type = TYPE_POINTER_ABYSS;
-			break;
-		case AST_POINTER_VAR:
-			ptr_type = TYPE_POINTER_VAR;
-			break;
-		}
+		size_t name_index = i + node.struct_type.member_names;
+		size_t type_index = i + node.struct_type.member_types;
+		for(size_t j = 0; j < count; j++) {
+			Type member_type = type_from_ast(tc, ast, type_index, err);
+			if(*err) goto RET;
 
-		t = (Type) {
-			.pointer = {
-				.type = ptr_type,
-				.base = index,
-			},
-		};
-
-		if(targ_type.type == TYPE_ARRAY) {
-			if(!targ_type.array.len) {
-				t.pointer.base = targ_type.array.base;
-				t.pointer.type += TYPE_PAUL_CONST - TYPE_POINTER_CONST;
-			}
+			index = types_register(tc, member_type, err);
+			if(*err) goto RET;
+
+			tc->stack[members + j] = index;
+			assert(ast->types[name_index] == AST_IDENT);
+			tc->stack[members + count + j] = ast_get(ast, name_index).ident.id;
+
+			name_index += ast->next[name_index];
+			type_index += ast->next[type_index];
 		}
-		break;
 
-	case AST_ARRAY:
-		do {} while(0);
-		Type base_type = type_from_ast(tc, nodes, i + node.array.elem_type, err);
-		if(*err) goto RET;
-		index = types_register_nexist(tc, base_type, err);
-		if(*err) goto RET;
+		t.type = TYPE_STRUCT;
+		t.struct_type.member_count = count;
+		t.struct_type.member_types = tc->stack + members;
+		t.struct_type.member_name_ids = tc->stack + members + count;
+	} break;
 
-		t = (Type) {
-			.array = {
-				.type = TYPE_ARRAY,
-				.base = index,
-				.len = node.array.len,
-			},
-		};
-		break;
+	default:
+		fprintf(stderr, "Invalid Type at ");
+		lexer_print_debug_to_file(stderr, &node.com.debug);
+		fprintf(stderr, "\n");
+		*err = ERROR_UNEXPECTED_DATA;
+		goto RET;
+	}
 
-	case AST_SLICE_CONST:
-	case AST_SLICE_VAR:
-	case AST_SLICE_ABYSS:
-		do {} while(0);
-		Type slice_type = type_from_ast(tc, nodes, i + node.pointer_type.base_type, err);
-		if(*err) goto RET;
-		index = types_register_nexist(tc, slice_type, err);
-		if(*err) goto RET;
+	index = types_register(tc, t, err);
+	if(*err) goto RET;
+	t = tc->types[index];
+	if(tc->cache) tc->cache[i] = index + 1;
+
+RET:
+	tc->stack_len = mark; // A struct's members are copied out by now
+	return t;
+}
+
+Type type_from_ast(TypeContext *tc, Ast const *ast, size_t i, Error *err)
+{
+	Type t = { 0 };
+	size_t mark = tc->stack_len;
 
+	// Pointers, arrays and slices each wrap one type, so a chain of them is
+	// walked down to what it wraps, then built back up
+	for(;;) {
+		if(tc->cache && tc->cache[i]) break;
+
+		AstNode node = ast_get(ast, i);
+		Offset base;
 		switch(node.type) {
-		default:
+		case AST_POINTER_CONST:
+		case AST_POINTER_VAR:
+		case AST_POINTER_ABYSS:
 		case AST_SLICE_CONST:
-			ptr_type = TYPE_SLICE_CONST;
-			break;
+		case AST_SLICE_VAR:
 		case AST_SLICE_ABYSS:
-			ptr_type = TYPE_SLICE_ABYSS;
+			base = node.pointer_type.base_type;
 			break;
-		case AST_SLICE_VAR:
-			ptr_type = TYPE_SLICE_VAR;
+		case AST_ARRAY:
+			base = node.array.elem_type;
 			break;
+		default:
+			goto LEAF;
 		}
 
-		t = (Type) {
-			.slice = {
-				.type = ptr_type,
-				.base = index,
-			},
-		};
-		break;
+		types_stack_reserve(tc, 1, err);
+		if(*err) goto RET;
+		tc->stack[tc->stack_len++] = i;
+		i += base;
+	}
 
-	case AST_STRUCT_TYPE:
-		do {} while(0);
-		t.type = TYPE_STRUCT;
-		t.struct_type.member_count = node.struct_type.member_count;
-		t.struct_type.member_types = malloc(t.struct_type.member_count * sizeof(size_t));
-		CHECK_MALLOC(t.struct_type.member_types);
-		t.struct_type.member_name_ids = malloc(t.struct_type.member_count * sizeof(Id));
-		CHECK_MALLOC(t.struct_type.member_name_ids);
+LEAF:
+	t = type_from_ast_leaf(tc, ast, i, err);
+	if(*err || tc->stack_len == mark) goto RET;
+	TypeId index = types_register(tc, t, err);
+	if(*err) goto RET;
 
-		size_t name_index = i + node.struct_type.member_names;
-		size_t type_index = i + node.struct_type.member_types;
-		for(size_t i = 0; i < node.struct_type.member_count; i++) {
-			Type member_type = type_from_ast(tc, nodes, type_index, err);
-			if(*err) goto RET;	
+	while(tc->stack_len > mark) {
+		i = tc->stack[--tc->stack_len];
+		AstNode node = ast_get(ast, i);
+		TypeType ptr_type;
 
-			index = types_register_nexist(tc, member_type, err);
-			if(*err) goto RET;
+		switch(node.type) {
+		case AST_POINTER_CONST:
+		case AST_POINTER_VAR:
+		case AST_POINTER_ABYSS:
+			switch(node.type) {
+			default:
+			case AST_POINTER_CONST:
+				ptr_type = TYPE_POINTER_CONST;
+				break;
+			case AST_POINTER_ABYSS:
+				ptr_type = TYPE_POINTER_ABYSS;
+				break;
+			case AST_POINTER_VAR:
+				ptr_type = TYPE_POINTER_VAR;
+				break;
+			}
 
-			t.struct_type.member_types[i] = index;
-			assert(nodes[name_index].type == AST_IDENT);
-			t.struct_type.member_name_ids[i] = nodes[name_index].ident.id;
+			if(t.type == TYPE_ARRAY && !t.array.len) {
+				t = (Type) {
+					.pointer = {
+						.type = ptr_type + TYPE_PAUL_CONST - TYPE_POINTER_CONST,
+						.base = t.array.base,
+					},
+				};
+			} else {
+				t = (Type) {
+					.pointer = {
+						.type = ptr_type,
+						.base = index,
+					},
+				};
+			}
+			break;
 
-			name_index += nodes[name_index].com.next;
-			type_index += nodes[type_index].com.next;
+		case AST_ARRAY:
+			t = (Type) {
+				.array = {
+					.type = TYPE_ARRAY,
+					.base = index,
+					.len = node.array.len,
+				},
+			};
+			break;
+
+		default:
+			switch(node.type) {
+			default:
+			case AST_SLICE_CONST:
+				ptr_type = TYPE_SLICE_CONST;
+				break;
+			case AST_SLICE_ABYSS:
+				ptr_type = TYPE_SLICE_ABYSS;
+				break;
+			case AST_SLICE_VAR:
+				ptr_type = TYPE_SLICE_VAR;
+				break;
+			}
+
+			t = (Type) {
+				.slice = {
+					.type = ptr_type,
+					.base = index,
+				},
+			};
+			break;
 		}
-		break;
 
-	default:
-		fprintf(stderr, "Invalid Type at ");
-		lexer_print_debug_to_file(stderr, &node.com.debug);
-		fprintf(stderr, "\n");
-		*err = ERROR_UNEXPECTED_DATA;
-		goto RET;
+		index = types_register(tc, t, err);
+		if(*err) goto RET;
+		t = tc->types[index];
+		if(tc->cache) tc->cache[i] = index + 1;
 	}
 
 RET:
-	do {} while(0);
-	size_t exist_limit = tc->count;
-	size_t index = types_register_nexist(tc, t, err);
-	if(index < exist_limit) {
-		type_clean(t);
-		t = tc->types[index];
-	}
+	tc->stack_len = mark;
 	return t;
 }
 
@@ -606,50 +724,6 @@ bool type_is_unsigned(Type t)
 }
 
 
-void types_copy(
-	TypeContext *restrict dst,
-	TypeContext const *restrict src,
-	Error *err
-)
-{
-	dst->types = malloc(src->count * sizeof(Type));
-	CHECK_MALLOC(dst->types);
-	dst->count = src->count;
-	for(size_t i = 0; i < src->count; i++) {
-		if(src->types[i].type == TYPE_STRUCT) {
-			dst->types[i].struct_type.member_types = malloc(
-				src->types[i].struct_type.member_count * sizeof(size_t)
-			);
-			CHECK_MALLOC(dst->types[i].struct_type.member_types);
-			dst->types[i].struct_type.member_name_ids = malloc(
-				src->types[i].struct_type.member_count * sizeof(size_t)
-			);
-			CHECK_MALLOC(dst->types[i].struct_type.member_name_ids);
-
-			dst->types[i].struct_type.member_count =
-				src->types[i].struct_type.member_count;
-
-			memcpy(
-				dst->types[i].struct_type.member_name_ids,
-				src->types[i].struct_type.member_name_ids,
-				dst->types[i].struct_type.member_count * sizeof(size_t)
-			);
-
-			memcpy(
-				dst->types[i].struct_type.member_types,
-				src->types[i].struct_type.member_types,
-				dst->types[i].struct_type.member_count * sizeof(size_t)
-			);
-			dst->types[i].type = TYPE_STRUCT;
-		} else {
-			dst->types[i] = src->types[i];
-		}
-	}
-
-RET:
-	return;
-}
-
 Type type_resolve(TypeContext const *tc, Type t)
 {
 	while(t.type == TYPE_TYPEDEF) {
@@ -661,22 +735,18 @@ Type type_resolve(TypeContext const *tc, Type t)
 
 
 Type types_get_ptr(
-	TypeContext const *tc,
+	TypeContext *tc,
 	Type base,
-	TypeType ptr_type
+	TypeType ptr_type,
+	Error *err
 )
 {
-	for(size_t i = 0; i < tc->count; i++) {
-		if(types_are_equal(tc->types[i], base)) {
-			return (Type) {
-				.pointer = {
-					.type = ptr_type,
-					.base = i,
-				},
-			};
-		}
-	}
-	assert(0);
+	return (Type) {
+		.pointer = {
+			.type = ptr_type,
+			.base = types_register(tc, base, err),
+		},
+	};
 }
 
 bool type_is_subscriptable(
@@ -702,12 +772,143 @@ bool type_is_subscriptable(
 	}
 }
 
-size_t type_lookup_id(TypeContext *tc, size_t id)
+TypeId type_lookup_id(TypeContext const *tc, Id id)
 {
-	for(size_t i = 0; i < tc->count; i++) {
-		if(tc->types[i].type == TYPE_TYPEDEF) {
-			if(tc->types[i].typdef.id == id) return tc->types[i].typdef.backing;
+	TypeId index = types_find(tc, (Type) {.typdef = {.type = TYPE_TYPEDEF, .id = id}});
+	if(index == TYPE_ID_NONE) return TYPE_ID_NONE;
+	return tc->types[index].typdef.backing;
+}
+
+// How T is aligned as a struct member, by the compiler building this one,
+// which can be less than on its own (uint64_t on i386). _Alignof is C11.
+#define TYPE_ALIGN(T) offsetof(struct {char c; T x;}, x)
+#define TYPE_LAYOUT(T) ((TypeLayout) {.size = sizeof(T), .align = TYPE_ALIGN(T)})
+
+// What the backend makes a slice
+typedef struct {
+	void *ptr;
+	uint64_t len;
+} SliceLayout;
+
+static bool layout_add(uint64_t *sum, uint64_t a, uint64_t b)
+{
+	if(a > UINT64_MAX - b) return false;
+	*sum = a + b;
+	return true;
+}
+
+// Rounds size up to align, which is a power of 2
+static bool layout_round(uint64_t *size, uint32_t align)
+{
+	if(!layout_add(size, *size, align - 1)) return false;
+	*size &= ~(uint64_t) (align - 1);
+	return true;
+}
+
+TypeLayout type_layout(TypeContext *tc, TypeId id, Error *err)
+{
+	TypeLayout layout = { 0 };
+
+	if(id >= tc->layout_cap) {
+		size_t cap = tc->cap;
+		tc->layouts = arena_realloc(
+			tc->arena,
+			tc->layouts,
+			tc->layout_cap * sizeof(TypeLayout),
+			cap * sizeof(TypeLayout),
+			err
+		);
+		if(*err) goto RET;
+		memset(tc->layouts + tc->layout_cap, 0, (cap - tc->layout_cap) * sizeof(TypeLayout));
+		tc->layout_cap = cap;
+	}
+	if(tc->layouts[id].align) return tc->layouts[id];
+
+	Type t = tc->types[id];
+	switch(t.type) {
+	case TYPE_PRIMITIVE_U8:
+	case TYPE_PRIMITIVE_S8:
+		layout = TYPE_LAYOUT(uint8_t);
+		break;
+	case TYPE_PRIMITIVE_U16:
+	case TYPE_PRIMITIVE_S16:
+		layout = TYPE_LAYOUT(uint16_t);
+		break;
+	case TYPE_PRIMITIVE_U32:
+	case TYPE_PRIMITIVE_S32:
+		layout = TYPE_LAYOUT(uint32_t);
+		break;
+	case TYPE_PRIMITIVE_U64:
+	case TYPE_PRIMITIVE_S64:
+		layout = TYPE_LAYOUT(uint64_t);
+		break;
+	case TYPE_PRIMITIVE_BOOL:
+		layout = TYPE_LAYOUT(bool);
+		break;
+	case TYPE_PRIMITIVE_VOID:
+		layout = (TypeLayout) {.size = 0, .align = 1};
+		break;
+
+	case TYPE_POINTER_CONST:
+	case TYPE_POINTER_ABYSS:
+	case TYPE_POINTER_VAR:
+	case TYPE_PAUL_CONST:
+	case TYPE_PAUL_ABYSS:
+	case TYPE_PAUL_VAR:
+		layout = TYPE_LAYOUT(void*);
+		break;
+
+	case TYPE_SLICE_CONST:
+	case TYPE_SLICE_ABYSS:
+	case TYPE_SLICE_VAR:
+		layout = TYPE_LAYOUT(SliceLayout);
+		break;
+
+	case TYPE_ARRAY: {
+		TypeLayout elem = type_layout(tc, t.array.base, err);
+		if(*err) goto RET;
+
+		layout.align = elem.align;
+		if(elem.size && t.array.len > UINT64_MAX / elem.size) goto TOO_LARGE;
+		layout.size = elem.size * t.array.len;
+	} break;
+
+	case TYPE_STRUCT: {
+		size_t count = t.struct_type.member_count;
+		uint64_t *offsets = arena_alloc(tc->arena, count * sizeof(uint64_t), err);
+		if(*err) goto RET;
+
+		layout.align = 1;
+		for(size_t i = 0; i < count; i++) {
+			TypeLayout member = type_layout(tc, t.struct_type.member_types[i], err);
+			if(*err) goto RET;
+
+			if(!layout_round(&layout.size, member.align)) goto TOO_LARGE;
+			offsets[i] = layout.size;
+			if(!layout_add(&layout.size, layout.size, member.size)) goto TOO_LARGE;
+			if(member.align > layout.align) layout.align = member.align;
 		}
+		if(!layout_round(&layout.size, layout.align)) goto TOO_LARGE;
+		layout.offsets = offsets;
+	} break;
+
+	case TYPE_TYPEDEF:
+		layout = type_layout(tc, t.typdef.backing, err);
+		if(*err) goto RET;
+		break;
+
+	default:
+		fprintf(stderr, "Cannot Lay Out Type #%d\n", t.type);
+		*err = ERROR_INTERNAL;
+		goto RET;
 	}
-	return SIZE_MAX;
+
+	tc->layouts[id] = layout;
+	goto RET;
+
+TOO_LARGE:
+	fprintf(stderr, "Type is too large to fit in memory\n");
+	*err = ERROR_UNEXPECTED_DATA;
+RET:
+	return layout;
 }
@@ -32,52 +32,88 @@ typedef enum {
 	TYPE_TYPEDEF
 } TypeType;
 
+// Index into a TypeContext's types. Each distinct type has exactly one, so two
+// types are the same if and only if their ids are.
+typedef uint32_t TypeId;
+#define TYPE_ID_NONE UINT32_MAX
+
 typedef union {
 	TypeType type;
 
 	struct {
 		TypeType type;
-		size_t base; // index into types
+		TypeId base;
 	} pointer;
 
 	struct {
 		TypeType type;
-		size_t base;
+		TypeId base;
 		size_t len; // 0 == Unknown Length (used in PAUL)
 	} array;
 
 	struct {
 		TypeType type;
-		size_t base;
+		TypeId base;
 	} slice;
 
 	struct {
 		TypeType type;
-		size_t *member_types;
-		size_t *member_name_ids;
+		TypeId *member_types;
+		Id *member_name_ids;
 		size_t member_count;
 	} struct_type;
 
 	struct {
 		TypeType type;
 		size_t id;
-		size_t backing;
+		TypeId backing;
 	} typdef;
 } Type;
 
+/*
+ * Where a type's bytes go: the sizes, alignments and padding the C compiler
+ * building Wyrt gives the same C types, which is the ABI the gcc backend
+ * targets too. A slice is laid out as struct {T *ptr; uint64_t len;}.
+ */
+typedef struct {
+	uint64_t size; // A multiple of align
+	uint32_t align; // 0 == Not laid out yet
+	uint64_t const *offsets; // Of each struct member, NULL for anything else
+} TypeLayout;
+
+/*
+ * Hash-consed: types are only ever added if there isn't an equal one
+ * already, and slots maps each one's hash back to its id, so finding or
+ * adding a type doesn't depend on how many there are.
+ * Derived types (pointers, arrays, slices) are added as they're used.
+ * Types are never removed or changed, so one context can be shared by
+ * every scope of a compile, and an id stays valid for all of it.
+ */
 typedef struct {
 	Type *types;
 	size_t count;
+	size_t cap;
+	TypeId *slots; // Open-addressed, id + 1, 0 == Empty
+	size_t slot_cap; // Power of 2, at least twice count
+	Arena *arena; // types, slots and struct member arrays, freed with it
+	TypeId *cache; // What type_from_ast made of each AST node, id + 1, 0 == Not yet. Optional.
+	TypeLayout *layouts; // By id, filled in by type_layout as it's asked
+	size_t layout_cap;
+	// type_from_ast's, so deep types don't need a deep C stack: AST indices
+	// (which fit, like TypeRef's) and struct members' TypeIds and Ids
+	uint32_t *stack;
+	size_t stack_len;
+	size_t stack_cap;
 } TypeContext;
 
-void types_init(TypeContext *tc, Error *err);
-void types_clean(TypeContext const *tc);
+void types_init(TypeContext *tc, Arena *arena, Error *err);
 
-size_t types_register(TypeContext *tc, Type t, Error *err);
-size_t types_register_nexist(TypeContext *tc, Type t, Error *err);
+// TYPE_ID_NONE == Not Found
+TypeId types_find(TypeContext const *tc, Type t);
+TypeId types_register(TypeContext *tc, Type t, Error *err);
 Type type_from_ast(
 	TypeContext *tc,
-	AstNode const *nodes,
+	Ast const *ast,
 	size_t i,
 	Error *err
 );
@@ -88,16 +124,12 @@ bool type_is_arithmetic(Type t);
 bool type_is_unsigned(Type t);
 Type type_resolve(TypeContext const *tc, Type t);
 
-void types_copy(
-	TypeContext *restrict dst,
-	TypeContext const *restrict src,
-	Error *err
-);
-
+// Registers base if it has to
 Type types_get_ptr(
-	TypeContext const *tc,
+	TypeContext *tc,
 	Type base,
-	TypeType ptr_type
+	TypeType ptr_type,
+	Error *err
 );
 
 bool type_is_subscriptable(
@@ -105,5 +137,9 @@ bool type_is_subscriptable(
 	Type t
 );
 
-// SIZE_MAX == Not Found
-size_t type_lookup_id(TypeContext *tc, size_t id);
+// The typedef called id's backing type, TYPE_ID_NONE == Not Found
+TypeId type_lookup_id(TypeContext const *tc, Id id);
+
+// Each type is only laid out once, the first time it's asked for.
+// offsets lives in tc's arena.
+TypeLayout type_layout(TypeContext *tc, TypeId id, Error *err);
@@ -5,6 +5,8 @@
 
 void wyrt_diag(FILE *file, char *const *idents, char *const *strings, const TypeContext *tc, const char *fmt, ...)
 {
+	if(!file) return;
+
 	va_list args;
 	va_start(args, fmt);
 	fmt--;
@@ -17,9 +19,12 @@ void wyrt_diag(FILE *file, char *const *idents, char *const *strings, const Type
 			case '%': fputc('%', file); break;
 			case 'l': lexer_print_debug_to_file(file, va_arg(args, DebugInfo*)); break; 
 			case 's': fputs(strings[va_arg(args, size_t)], file); break;
-			case 'i': fputs(idents[va_arg(args, size_t)], file); break;
+			case 'i': fputs(id_get(idents, va_arg(args, Id)), file); break;
 			case 't': type_print(file, tc, va_arg(args, Type), idents); break;
-			case 'T': lexer_print_token_to_file(file, va_arg(args, Token*), idents, strings); break;
+			case 'T': {
+				Tokens const *toks = va_arg(args, Tokens*);
+				lexer_print_token_to_file(file, toks, va_arg(args, size_t), idents, strings);
+			} break;
 			case 'z': fprintf(file, "%zi", va_arg(args, size_t)); break;
 			}
 			break;
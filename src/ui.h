@@ -7,11 +7,12 @@
  * Custom formatted printing
  * %t = Type
  * %l = Location (DebugInfo)
- * %i = Identiifer
+ * %i = Identifier (Id)
  * %s = String
  * %z = size_t
- * %T = Token*
+ * %T = Token (two arguments: Tokens*, size_t index)
  *
  * If a parameter would not be used (i.e. idents when there are no %i placeholders) they can be NULL
+ * If file is NULL nothing is printed
 */
 void wyrt_diag(FILE *file, char *const *idents, char *const *strings, const TypeContext *tc, const char *fmt, ...);
@@ -81,12 +81,15 @@ void *dynarr_pop(DynArr *da)
 
 void dynarr_append(DynArr *da, void const *vals, size_t count, Error *err)
 {
+	if(!count) goto RET;
 	dynarr_alloc(da, count, err);
 	if(*err) goto RET;
 
-	for(size_t i = count - 1; i >= 0; i--) {
-		memcpy(dynarr_from_back(da, i), &((char*)vals)[i], da->elem_size);
-	}
+	memcpy(
+		(char*)da->data + (da->count - count) * da->elem_size,
+		vals,
+		count * da->elem_size
+	);
 
 RET:
 	return;
@@ -171,3 +174,229 @@ void string_builder_printf(
 RET:
 	fclose(tmp);
 }
+
+#define ARENA_ALIGN 16 // Enough for anything malloc would return
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct ArenaBlock {
+	ArenaBlock *next;
+	size_t size; // Of the data, which starts ARENA_ROUND(sizeof(ArenaBlock)) in
+};
+
+static char *arena_data(ArenaBlock *block)
+{
+	return (char*)block + ARENA_ROUND(sizeof(ArenaBlock));
+}
+
+// Moves on to a block with at least size bytes, reusing a spare one if it fits
+static void arena_next_block(Arena *arena, size_t size, Error *err)
+{
+	ArenaBlock *spare = arena->block ? arena->block->next : arena->first;
+	if(!spare || spare->size < size) {
+		size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+		ArenaBlock *block = malloc(ARENA_ROUND(sizeof(ArenaBlock)) + block_size);
+		CHECK_MALLOC(block);
+		block->size = block_size;
+		block->next = spare;
+		if(arena->block) arena->block->next = block;
+		else arena->first = block;
+		spare = block;
+	}
+
+	arena->block = spare;
+	arena->at = arena_data(spare);
+	arena->end = arena->at + spare->size;
+
+RET:
+	return;
+}
+
+void *arena_alloc(Arena *arena, size_t size, Error *err)
+{
+	void *ptr = NULL;
+	size = ARENA_ROUND(size);
+	if(!arena->block || (size_t)(arena->end - arena->at) < size) {
+		arena_next_block(arena, size, err);
+		if(*err) goto RET;
+	}
+
+	ptr = arena->at;
+	arena->at += size;
+
+RET:
+	return ptr;
+}
+
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t size, Error *err)
+{
+	if(size <= old_size) return ptr;
+
+	if(ptr && (char*)ptr + ARENA_ROUND(old_size) == arena->at
+		&& (size_t)(arena->end - (char*)ptr) >= ARENA_ROUND(size)
+	) {
+		arena->at = (char*)ptr + ARENA_ROUND(size);
+		return ptr;
+	}
+
+	void *moved = arena_alloc(arena, size, err);
+	if(*err) goto RET;
+	if(old_size) memcpy(moved, ptr, old_size);
+
+RET:
+	return moved;
+}
+
+ArenaMark arena_mark(Arena const *arena)
+{
+	return (ArenaMark) {arena->block, arena->at};
+}
+
+void arena_reset(Arena *arena, ArenaMark mark)
+{
+	arena->block = mark.block;
+	arena->at = mark.at;
+	arena->end = mark.block ? arena_data(mark.block) + mark.block->size : NULL;
+}
+
+void arena_clean(Arena const *arena)
+{
+	ArenaBlock *block = arena->first;
+	while(block) {
+		ArenaBlock *next = block->next;
+		free(block);
+		block = next;
+	}
+}
+
+void intern_init(InternTable *it)
+{
+	*it = (InternTable) { 0 };
+	dynarr_init(&it->pool, sizeof(char));
+	dynarr_init(&it->offsets, sizeof(size_t));
+	dynarr_init(&it->hashes, sizeof(uint32_t));
+}
+
+void intern_clean(InternTable const *it)
+{
+	dynarr_clean(&it->pool);
+	dynarr_clean(&it->offsets);
+	dynarr_clean(&it->hashes);
+	free(it->slots);
+}
+
+uint32_t intern_hash(const char *str, size_t len)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < len; i++) {
+		hash ^= (unsigned char)str[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void intern_grow(InternTable *it, Error *err)
+{
+	size_t slot_count = it->slot_count ? it->slot_count * 2 : 64;
+	uint32_t *slots = calloc(slot_count, sizeof(uint32_t));
+	CHECK_MALLOC(slots);
+
+	for(size_t i = 0; i < it->offsets.count; i++) {
+		size_t slot = ((uint32_t*)it->hashes.data)[i] & (slot_count - 1);
+		while(slots[slot]) {
+			slot = (slot + 1) & (slot_count - 1);
+		}
+		slots[slot] = i + 1;
+	}
+
+	free(it->slots);
+	it->slots = slots;
+	it->slot_count = slot_count;
+RET:
+	return;
+}
+
+size_t intern(InternTable *it, const char *str, size_t len, Error *err)
+{
+	size_t id = SIZE_MAX;
+
+	// Keep load factor <= 1/2
+	if((it->offsets.count + 1) * 2 > it->slot_count) {
+		intern_grow(it, err);
+		if(*err) goto RET;
+	}
+
+	uint32_t hash = intern_hash(str, len);
+	size_t slot = hash & (it->slot_count - 1);
+	while(it->slots[slot]) {
+		size_t i = it->slots[slot] - 1;
+		if(((uint32_t*)it->hashes.data)[i] == hash) {
+			const char *other = (char*)it->pool.data + ((size_t*)it->offsets.data)[i];
+			uint32_t other_len;
+			memcpy(&other_len, other - sizeof(uint32_t), sizeof(uint32_t));
+			if(other_len == len && !memcmp(other, str, len)) {
+				id = i;
+				goto RET;
+			}
+		}
+		slot = (slot + 1) & (it->slot_count - 1);
+	}
+
+	id = it->offsets.count;
+	size_t offset = it->pool.count + sizeof(uint32_t);
+	uint32_t len32 = len;
+
+	dynarr_alloc(&it->pool, sizeof(uint32_t) + len + 1, err);
+	if(*err) goto RET;
+	char *entry = (char*)it->pool.data + offset;
+	memcpy(entry - sizeof(uint32_t), &len32, sizeof(uint32_t));
+	memcpy(entry, str, len);
+	entry[len] = '\0';
+
+	dynarr_push(&it->offsets, &offset, err);
+	if(*err) goto RET;
+	dynarr_push(&it->hashes, &hash, err);
+	if(*err) goto RET;
+
+	it->slots[slot] = id + 1;
+RET:
+	return id;
+}
+
+const char *intern_get(InternTable const *it, size_t id, size_t *len)
+{
+	const char *str = (char*)it->pool.data + ((size_t*)it->offsets.data)[id];
+	uint32_t len32;
+	memcpy(&len32, str - sizeof(uint32_t), sizeof(uint32_t));
+	*len = len32;
+	return str;
+}
+
+char **intern_finish(InternTable *it, Error *err)
+{
+	char **table = NULL;
+	size_t count = it->offsets.count;
+	if(!count) goto RET;
+
+	table = malloc(count * sizeof(char*) + it->pool.count);
+	CHECK_MALLOC(table);
+
+	char *pool = (char*)(table + count);
+	memcpy(pool, it->pool.data, it->pool.count);
+	for(size_t i = 0; i < count; i++) {
+		table[i] = pool + ((size_t*)it->offsets.data)[i];
+	}
+
+RET:
+	intern_clean(it);
+	intern_init(it);
+	return table;
+}
+
+size_t intern_len(char *const *table, size_t id)
+{
+	uint32_t len;
+	memcpy(&len, table[id] - sizeof(uint32_t), sizeof(uint32_t));
+	return len;
+}
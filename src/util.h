@@ -69,3 +69,61 @@ void string_builder_printf(
 	const char *fmt_str,
 	...
 );
+
+/*
+ * Region Allocator
+ * Everything allocated from an arena is freed at once, by arena_reset back to
+ * an earlier mark or by arena_clean, never on its own. Blocks are kept for
+ * reuse after a reset, so a phase that runs over and over (like codegen for
+ * each function) stops calling malloc once it has warmed up.
+ * A zeroed Arena is empty and ready to use.
+ */
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+	ArenaBlock *first;
+	ArenaBlock *block; // Being allocated from, the ones after it are spare
+	char *at;
+	char *end;
+} Arena;
+
+typedef struct {
+	ArenaBlock *block;
+	char *at;
+} ArenaMark;
+
+void *arena_alloc(Arena *arena, size_t size, Error *err);
+// Grows in place if ptr was the last allocation, otherwise copies. ptr stays valid either way.
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t size, Error *err);
+ArenaMark arena_mark(Arena const *arena);
+// Frees everything allocated since mark
+void arena_reset(Arena *arena, ArenaMark mark);
+void arena_clean(Arena const *arena);
+
+/*
+ * String Interning Table
+ * Every distinct string gets a dense id (in insertion order).
+ * Strings are stored back-to-back in a single pool as length-prefixed byte
+ * ranges ([u32 len][bytes][NUL]), and looked up through an open-addressed
+ * hash table.
+ */
+typedef struct {
+	DynArr pool; // char, [u32 len][bytes][NUL] entries
+	DynArr offsets; // size_t, start of each string's bytes in pool
+	DynArr hashes; // uint32_t, hash of each string
+	uint32_t *slots; // id + 1, 0 == empty
+	size_t slot_count; // power of 2
+} InternTable;
+
+void intern_init(InternTable *it);
+void intern_clean(InternTable const *it);
+
+uint32_t intern_hash(const char *str, size_t len);
+size_t intern(InternTable *it, const char *str, size_t len, Error *err);
+// Bytes of an id in a table that hasn't been finished yet.
+const char *intern_get(InternTable const *it, size_t id, size_t *len);
+
+// Single allocation, free() it when done. Cleans the table.
+char **intern_finish(InternTable *it, Error *err);
+// Length of a string from an intern_finish table, without strlen.
+size_t intern_len(char *const *table, size_t id);
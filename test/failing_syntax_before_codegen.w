@@ -0,0 +1,16 @@
+fn main() u8
+{
+	var x: u8 = (1;
+	return missing(x);
+}
+
+fn wrong() u8
+{
+	const y: bool = 5;
+	return y;
+}
+
+fn broken() u8
+{
+	return 2 *;
+}
@@ -0,0 +1,102 @@
+fn main() u8 { return 0; }
+
+fn f0() u8 { return = ; }
+fn f1() u8 { return = ; }
+fn f2() u8 { return = ; }
+fn f3() u8 { return = ; }
+fn f4() u8 { return = ; }
+fn f5() u8 { return = ; }
+fn f6() u8 { return = ; }
+fn f7() u8 { return = ; }
+fn f8() u8 { return = ; }
+fn f9() u8 { return = ; }
+fn f10() u8 { return = ; }
+fn f11() u8 { return = ; }
+fn f12() u8 { return = ; }
+fn f13() u8 { return = ; }
+fn f14() u8 { return = ; }
+fn f15() u8 { return = ; }
+fn f16() u8 { return = ; }
+fn f17() u8 { return = ; }
+fn f18() u8 { return = ; }
+fn f19() u8 { return = ; }
+fn f20() u8 { return = ; }
+fn f21() u8 { return = ; }
+fn f22() u8 { return = ; }
+fn f23() u8 { return = ; }
+fn f24() u8 { return = ; }
+fn f25() u8 { return = ; }
+fn f26() u8 { return = ; }
+fn f27() u8 { return = ; }
+fn f28() u8 { return = ; }
+fn f29() u8 { return = ; }
+fn f30() u8 { return = ; }
+fn f31() u8 { return = ; }
+fn f32() u8 { return = ; }
+fn f33() u8 { return = ; }
+fn f34() u8 { return = ; }
+fn f35() u8 { return = ; }
+fn f36() u8 { return = ; }
+fn f37() u8 { return = ; }
+fn f38() u8 { return = ; }
+fn f39() u8 { return = ; }
+fn f40() u8 { return = ; }
+fn f41() u8 { return = ; }
+fn f42() u8 { return = ; }
+fn f43() u8 { return = ; }
+fn f44() u8 { return = ; }
+fn f45() u8 { return = ; }
+fn f46() u8 { return = ; }
+fn f47() u8 { return = ; }
+fn f48() u8 { return = ; }
+fn f49() u8 { return = ; }
+fn f50() u8 { return = ; }
+fn f51() u8 { return = ; }
+fn f52() u8 { return = ; }
+fn f53() u8 { return = ; }
+fn f54() u8 { return = ; }
+fn f55() u8 { return = ; }
+fn f56() u8 { return = ; }
+fn f57() u8 { return = ; }
+fn f58() u8 { return = ; }
+fn f59() u8 { return = ; }
+fn f60() u8 { return = ; }
+fn f61() u8 { return = ; }
+fn f62() u8 { return = ; }
+fn f63() u8 { return = ; }
+fn f64() u8 { return = ; }
+fn f65() u8 { return = ; }
+fn f66() u8 { return = ; }
+fn f67() u8 { return = ; }
+fn f68() u8 { return = ; }
+fn f69() u8 { return = ; }
+fn f70() u8 { return = ; }
+fn f71() u8 { return = ; }
+fn f72() u8 { return = ; }
+fn f73() u8 { return = ; }
+fn f74() u8 { return = ; }
+fn f75() u8 { return = ; }
+fn f76() u8 { return = ; }
+fn f77() u8 { return = ; }
+fn f78() u8 { return = ; }
+fn f79() u8 { return = ; }
+fn f80() u8 { return = ; }
+fn f81() u8 { return = ; }
+fn f82() u8 { return = ; }
+fn f83() u8 { return = ; }
+fn f84() u8 { return = ; }
+fn f85() u8 { return = ; }
+fn f86() u8 { return = ; }
+fn f87() u8 { return = ; }
+fn f88() u8 { return = ; }
+fn f89() u8 { return = ; }
+fn f90() u8 { return = ; }
+fn f91() u8 { return = ; }
+fn f92() u8 { return = ; }
+fn f93() u8 { return = ; }
+fn f94() u8 { return = ; }
+fn f95() u8 { return = ; }
+fn f96() u8 { return = ; }
+fn f97() u8 { return = ; }
+fn f98() u8 { return = ; }
+fn f99() u8 { return = ; }
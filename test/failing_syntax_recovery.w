@@ -0,0 +1,16 @@
+fn main() u8
+{
+	var x: u8 = 1;
+	x = 3 +;
+	if(x == 1) {
+		x = (2;
+	}
+	return x;
+}
+
+typedef = u8;
+
+fn f(a: u8) u8
+{
+	return a
+}
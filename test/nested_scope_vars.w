@@ -0,0 +1,15 @@
+fn main() u8
+{
+	var a: u8 = 1;
+	var c: u8 = 5;
+	if(a == 1) {
+		var b: u8 = 2;
+		b += c;
+		if(b == 7) {
+			var d: u8 = b + 1;
+			return a + d;
+		}
+		return b;
+	}
+	return a + c;
+}
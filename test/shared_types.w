@@ -0,0 +1,24 @@
+fn main() u8
+{
+	const a: struct {x: u8, y: u8} = _{.x = 2, .y = 5};
+	const b: struct {x: u8, y: u8} = _{.x = 3, .y = 4};
+	const short: [3]u8 = {1, 2, 3};
+	const long: [4]u8 = {10, 20, 30, 40};
+	const ptr: &const [4]u8 = &long;
+	return sum(a) + sum(b) + first(&short) + first(ptr) + second(&long);
+}
+
+fn sum(args: struct {x: u8, y: u8}) u8
+{
+	return args.x + args.y;
+}
+
+fn first(list: []const u8) u8
+{
+	return list[0];
+}
+
+fn second(list: []const u8) u8
+{
+	return list[1];
+}
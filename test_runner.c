@@ -7,6 +7,7 @@ typedef struct {
 	const char *file;
 	int exitcode;
 	bool should_fail;
+	int error_lines; // Lines the compiler should write to stderr, 0 == Don't check
 	const char *in;
 	const char *out;
 	int num;
@@ -65,6 +66,22 @@ int main(void)
 				printf("[" RED "FAIL" RESET "] Compiler Rejected\n");
 				goto CLEAN_AFTER;
 			}
+
+			if(tests[i].error_lines) {
+				int lines = 0;
+				rewind(err);
+				for(int c; (c = fgetc(err)) != EOF;) {
+					if(c == '\n') lines++;
+				}
+				if(lines != tests[i].error_lines) {
+					printf(
+						"[" RED "FAIL" RESET "] Expected %i Lines of Errors, got %i\n",
+						tests[i].error_lines,
+						lines
+					);
+					goto CLEAN_AFTER;
+				}
+			}
 			goto PASS;
 		} else if(tests[i].should_fail) {
 			printf("[" RED "FAIL" RESET "] Compiler Accepted\n");